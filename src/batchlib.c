@@ -0,0 +1,250 @@
+/**********************************************************************/
+/* FILE:  batchlib.c
+ * DATE:  16 OCT 2026
+ * AUTH:  G. E. Deschaines
+ * DESC:  Batch rendering of many TXYZ.OUT trajectory runs across a
+ *        pool of worker processes.
+ *
+ *        The batch run specification is either a comma separated
+ *        list of run numbers and inclusive ranges (e.g., 0-3,1240),
+ *        or a file glob pattern (e.g., "./txyz/TXYZ.OUT.*") whose
+ *        matching file name suffixes are taken as run numbers.
+ *
+ *        Object polygon models are loaded once by the parent process
+ *        before any worker is forked, so workers share the loaded
+ *        model pages copy-on-write and only privately copy what they
+ *        modify while transforming polygons.
+ *
+ *        Runs are sorted by decreasing trajectory file size and each
+ *        worker is handed the next run as soon as it finishes its
+ *        last, so uneven run lengths are balanced dynamically rather
+ *        than split statically among workers.  Each run renders
+ *        headless into its own ./Ximg/#### image directory.
+*/
+/**********************************************************************/
+
+#include <errno.h>
+#include <glob.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+typedef struct
+{
+  Integer  Num;  /* trajectory run number       */
+  off_t    Siz;  /* trajectory file size (bytes) */
+  pid_t    Pid;  /* worker process id, 0 if idle */
+} BatchRun;
+
+static BatchRun  *batchRuns = NULL;
+static int        batchCnt  = 0;
+static int        batchMax  = 0;
+
+/*
+ * APPENDS RUN NUMBER TO BATCH RUN LIST, IGNORING DUPLICATES
+*/
+static Boolean BatchAddRun( int num )
+{
+   BatchRun  *runs;
+   int        i;
+
+   if ( ( num < 0 ) || ( num > 9999 ) ) return FALSE;
+   for ( i = 0 ; i < batchCnt ; i++ ) {
+      if ( batchRuns[i].Num == num ) return TRUE;
+   }
+   if ( batchCnt == batchMax ) {
+      batchMax = ( batchMax == 0 ) ? 64 : 2*batchMax;
+      runs = (BatchRun *)realloc(batchRuns, batchMax*sizeof(BatchRun));
+      if ( runs == NULL ) {
+         printf("BatchAddRun:  realloc error for %d runs.\n",batchMax);
+         return FALSE;
+      }
+      batchRuns = runs;
+   }
+   batchRuns[batchCnt].Num = (Integer)num;
+   batchRuns[batchCnt].Siz = 0;
+   batchRuns[batchCnt].Pid = 0;
+   batchCnt++;
+   return TRUE;
+}
+
+/*
+ * PARSES BATCH RUN SPECIFICATION INTO BATCH RUN LIST
+*/
+static Boolean BatchParseRuns( const char *spec )
+{
+   glob_t      gbuf;
+   const char  *sptr;
+   char        *eptr;
+   long        num1, num2, num;
+   size_t      i;
+
+   if ( strpbrk(spec, "*?[/") != NULL ) {
+      /* File glob pattern. */
+      if ( glob(spec, 0, NULL, &gbuf) != 0 ) {
+         printf("BatchParseRuns:  no files match %s\n",spec);
+         return FALSE;
+      }
+      for ( i = 0 ; i < gbuf.gl_pathc ; i++ ) {
+         sptr = strrchr(gbuf.gl_pathv[i], '.');
+         if ( sptr == NULL ) continue;
+         num = strtol(sptr+1, &eptr, 10);
+         if ( ( eptr == sptr+1 ) || ( *eptr != '\0' ) ) continue;
+         BatchAddRun((int)num);
+      }
+      globfree(&gbuf);
+   } else {
+      /* Comma separated list of run numbers and ranges. */
+      sptr = spec;
+      while ( *sptr != '\0' ) {
+         num1 = strtol(sptr, &eptr, 10);
+         if ( eptr == sptr ) {
+            printf("BatchParseRuns:  invalid run specification %s\n",spec);
+            return FALSE;
+         }
+         num2 = num1;
+         if ( *eptr == '-' ) {
+            sptr = eptr + 1;
+            num2 = strtol(sptr, &eptr, 10);
+            if ( ( eptr == sptr ) || ( num2 < num1 ) ) {
+               printf("BatchParseRuns:  invalid run range in %s\n",spec);
+               return FALSE;
+            }
+         }
+         for ( num = num1 ; num <= num2 ; num++ ) {
+            BatchAddRun((int)num);
+         }
+         if ( *eptr == ',' ) eptr++;
+         else if ( *eptr != '\0' ) {
+            printf("BatchParseRuns:  invalid run specification %s\n",spec);
+            return FALSE;
+         }
+         sptr = eptr;
+      }
+   }
+   return ( batchCnt > 0 );
+}
+
+/*
+ * ORDERS BATCH RUNS BY DECREASING TRAJECTORY FILE SIZE
+*/
+static int BatchCmpRun( const void *a, const void *b )
+{
+   const BatchRun  *ra = (const BatchRun *)a;
+   const BatchRun  *rb = (const BatchRun *)b;
+
+   if ( ra->Siz != rb->Siz ) return ( ra->Siz < rb->Siz ) ? 1 : -1;
+   return ( ra->Num - rb->Num );
+}
+
+/*
+ * RENDERS ONE BATCH RUN IN A FORKED WORKER PROCESS
+*/
+static void BatchWorker( BatchRun *run )
+{
+   run_NUM = run->Num;
+   if ( img_OUT == 1 ) {
+      sprintf(img_DIR,"./Ximg/%04hd",run->Num);
+      if ( ( mkdir("./Ximg", 0755) != 0 ) && ( errno != EEXIST ) ) {
+         printf("BatchWorker:  mkdir error for ./Ximg\n");
+         _exit(2);
+      }
+      if ( ( mkdir(img_DIR, 0755) != 0 ) && ( errno != EEXIST ) ) {
+         printf("BatchWorker:  mkdir error for %s\n",img_DIR);
+         _exit(2);
+      }
+   }
+   draw3D(NULL, NULL, None);
+   TRACE_WRITE();
+   fflush(stdout);
+   _exit( quitflag ? 1 : 0 );
+}
+
+/*
+ * RENDERS ALL BATCH RUNS WITH A POOL OF nwrk WORKER PROCESSES
+ * (nwrk <= 0 SIZES POOL TO NUMBER OF ONLINE PROCESSORS) AND
+ * RETURNS NUMBER OF RUNS WHICH FAILED.
+*/
+int BatchRender( const char *spec, int nwrk )
+{
+   struct stat  sbuf;
+   char         txyzout_fpath[24];
+   pid_t        pid;
+   int          status;
+   int          next, nact, nerr;
+   int          i;
+
+   if ( ! BatchParseRuns(spec) ) {
+      printf("BatchRender:  no runs to render.\n");
+      return 1;
+   }
+
+/* Size runs by trajectory file length for longest first scheduling. */
+
+   for ( i = 0 ; i < batchCnt ; i++ ) {
+      sprintf(txyzout_fpath,"./txyz/TXYZ.OUT.%04hd",batchRuns[i].Num);
+      if ( stat(txyzout_fpath, &sbuf) == 0 ) {
+         batchRuns[i].Siz = sbuf.st_size;
+      }
+   }
+   qsort(batchRuns, batchCnt, sizeof(BatchRun), BatchCmpRun);
+
+   if ( nwrk <= 0 ) {
+      nwrk = (int)sysconf(_SC_NPROCESSORS_ONLN);
+      if ( nwrk <= 0 ) nwrk = 1;
+   }
+   if ( nwrk > batchCnt ) nwrk = batchCnt;
+   printf("BatchRender:  rendering %d runs with %d workers.\n",batchCnt,nwrk);
+
+/* Load object polygon models once for all workers. */
+
+   LoadModels();
+
+/* Keep each worker busy with the next longest remaining run. */
+
+   next = 0;
+   nact = 0;
+   nerr = 0;
+   while ( ( next < batchCnt ) || ( nact > 0 ) ) {
+      if ( ( next < batchCnt ) && ( nact < nwrk ) ) {
+         fflush(stdout);
+         pid = fork();
+         if ( pid == 0 ) {
+            BatchWorker(&batchRuns[next]);
+         }
+         if ( pid < 0 ) {
+            printf("BatchRender:  fork error for run %04hd.\n",
+                   batchRuns[next].Num);
+            nerr++;
+         } else {
+            batchRuns[next].Pid = pid;
+            nact++;
+         }
+         next++;
+         continue;
+      }
+      pid = waitpid(-1, &status, 0);
+      if ( pid < 0 ) {
+         if ( errno == EINTR ) continue;
+         break;
+      }
+      for ( i = 0 ; i < next ; i++ ) {
+         if ( batchRuns[i].Pid == pid ) break;
+      }
+      if ( i == next ) continue;
+      batchRuns[i].Pid = 0;
+      nact--;
+      if ( WIFEXITED(status) && ( WEXITSTATUS(status) == 0 ) ) {
+         printf("BatchRender:  run %04hd done.\n",batchRuns[i].Num);
+      } else {
+         printf("BatchRender:  run %04hd failed.\n",batchRuns[i].Num);
+         nerr++;
+      }
+   }
+
+   free(batchRuns);
+   batchRuns = NULL;
+   batchCnt  = 0;
+   batchMax  = 0;
+   return nerr;
+}
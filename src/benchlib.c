@@ -0,0 +1,178 @@
+/**********************************************************************/
+/* FILE:  benchlib.c
+ * DATE:  16 OCT 2026
+ * AUTH:  G. E. Deschaines
+ * DESC:  Per-stage frame timing benchmark of the render loop.
+ *
+ *        With the "-bench file" option, the time of each frame in
+ *        draw3D() is split into the stages below by laps of the
+ *        monotonic clock taken between them, and the time of every
+ *        frame is kept.
+ *
+ *          parse   reading the trajectory record (or fixed rate frame)
+ *          move    MakeMatrix, PlaceObject, CullObjects, MoveObjects
+ *          xfrm    XfrmPolys, XfrmGrid, XfrmObjects
+ *          sort    OrderObjects and depth sort of polygons (or
+ *                  clearing of the depth buffer with "-zbuffer")
+ *          clip    PolyClip of polygons in DrawPoly3D
+ *          draw    ground, grid and polygon drawing less clipping,
+ *                  and completion of tiled rasterization
+ *          hud     time and state variable text and viewport frame
+ *          output  window copy or present, image capture, frame
+ *                  stream and clearing of the drawn frame
+ *
+ *        At the end of the run, one line holding a JSON object with
+ *        the run, missile type, frame size, scene size, frame count,
+ *        frames per second, mean, p50, p95, p99 and maximum frame
+ *        time and mean time of each stage per frame (milliseconds)
+ *        is appended to the file, so runs of a batch or benchmark
+ *        harness (util/bench_threeD) accumulate in one file.
+ *
+ *        Stage times are those of the render loop thread, so with
+ *        the "-pipeline" option, draw is the recording of display
+ *        lists and output is the passing of frames to the pipeline.
+*/
+/**********************************************************************/
+
+#define bnParse   0   /* stage indices, in JSON output order        */
+#define bnMove    1
+#define bnXfrm    2
+#define bnSort    3
+#define bnClip    4
+#define bnDraw    5
+#define bnHud     6
+#define bnOutput  7
+#define bnNum     8
+
+typedef struct
+{
+  Boolean    On;           /* timing frames of run                  */
+  Extended   T;            /* time of last lap                      */
+  Extended   Cur[bnNum];   /* stage times of current frame (sec)    */
+  Extended   Sum[bnNum];   /* stage times of all frames (sec)       */
+  Extended   Clip;         /* clipping time at last frame (sec)     */
+  Extended  *Frm;          /* frame times (sec)                     */
+  Longint    Cnt;
+  Longint    Max;
+  Extended   Tbeg;         /* start time of run                     */
+  Extended   Twall;        /* run time (sec)                        */
+} Bench;
+
+Bench  bench;
+
+static const char *bnName[bnNum] = {
+   "parse", "move", "xfrm", "sort", "clip", "draw", "hud", "output"
+};
+
+/*
+ * STARTS TIMING FRAMES OF RUN
+*/
+void BenchStart( void )
+{
+   free(bench.Frm);
+   memset(&bench, 0, sizeof(bench));
+   bench.On   = TRUE;
+   bench.Clip = clipstat.Sec;
+   bench.Tbeg = RenSec();
+}
+
+/*
+ * STARTS TIMING OF NEXT FRAME
+*/
+void BenchBegin( void )
+{
+   Integer  i;
+
+   if ( ! bench.On ) return;
+   for ( i = 0 ; i < bnNum ; i++ ) bench.Cur[i] = 0.0;
+   bench.T = RenSec();
+}
+
+/*
+ * ADDS TIME SINCE LAST LAP TO GIVEN STAGE OF CURRENT FRAME
+*/
+void BenchLap( Integer stage )
+{
+   Extended  t;
+
+   if ( ! bench.On ) return;
+   t = RenSec();
+   bench.Cur[stage] = bench.Cur[stage] + t - bench.T;
+   bench.T = t;
+}
+
+/*
+ * ENDS TIMING OF CURRENT FRAME, MOVING ITS CLIPPING TIME (MEASURED IN
+ * DrawPoly3D) FROM DRAW TO CLIP STAGE
+*/
+void BenchFrame( void )
+{
+   Extended  tfrm = 0.0;
+   Integer   i;
+
+   if ( ! bench.On ) return;
+   bench.Cur[bnClip] = clipstat.Sec - bench.Clip;
+   bench.Cur[bnDraw] = bench.Cur[bnDraw] - bench.Cur[bnClip];
+   bench.Clip = clipstat.Sec;
+   for ( i = 0 ; i < bnNum ; i++ ) {
+      bench.Sum[i] = bench.Sum[i] + bench.Cur[i];
+      tfrm = tfrm + bench.Cur[i];
+   }
+   if ( GrowList((void **)&bench.Frm, &bench.Max, bench.Cnt+1,
+                 sizeof(Extended), 1024) ) {
+      bench.Frm[bench.Cnt++] = tfrm;
+   }
+}
+
+/*
+ * FRAME TIME COMPARISON FOR qsort
+*/
+static int BenchCmp( const void *a, const void *b )
+{
+   Extended  ta = *(const Extended *)a;
+   Extended  tb = *(const Extended *)b;
+
+   return ( ta < tb ) ? -1 : ( ta > tb ) ? 1 : 0;
+}
+
+/*
+ * STOPS TIMING AND APPENDS JSON LINE OF RUN TIMING STATISTICS TO FILE
+*/
+void BenchWrite( const char *fpath, Integer run, Integer msl,
+                 Integer wid, Integer hgt, Longint npol )
+{
+   FILE     *fp;
+   Longint   n = bench.Cnt;
+   Longint   nfrm = lmax(n, 1);
+   Extended  tsum = 0.0;
+   Integer   i;
+
+   if ( ! bench.On ) return;
+   bench.On    = FALSE;
+   bench.Twall = RenSec() - bench.Tbeg;
+   if ( n == 0 ) return;
+
+   for ( i = 0 ; i < bnNum ; i++ ) tsum = tsum + bench.Sum[i];
+   qsort(bench.Frm, n, sizeof(Extended), BenchCmp);
+
+   fp = fopen(fpath, "a");
+   if ( fp == NULL ) {
+      printf("BenchWrite:  fopen error for %s.\n",fpath);
+      return;
+   }
+   fprintf(fp,"{\"run\": \"%04d\", \"missile\": %d, \"width\": %d, \"height\": %d, "
+              "\"polygons\": %ld, \"frames\": %ld, \"seconds\": %.6f, \"fps\": %.2f, ",
+           run, msl, wid, hgt, npol, n, tsum, n/dmax(tsum,1.0e-9));
+   fprintf(fp,"\"frame_ms\": {\"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f, "
+              "\"p99\": %.4f, \"max\": %.4f}, ",
+           1.0e3*tsum/nfrm, 1.0e3*bench.Frm[(n-1)*50/100],
+           1.0e3*bench.Frm[(n-1)*95/100], 1.0e3*bench.Frm[(n-1)*99/100],
+           1.0e3*bench.Frm[n-1]);
+   fprintf(fp,"\"stage_ms\": {");
+   for ( i = 0 ; i < bnNum ; i++ ) {
+      fprintf(fp,"%s\"%s\": %.4f", ( i > 0 ) ? ", " : "",
+              bnName[i], 1.0e3*bench.Sum[i]/nfrm);
+   }
+   fprintf(fp,"}, \"wall_seconds\": %.6f}\n", bench.Twall);
+   fclose(fp);
+}
@@ -0,0 +1,376 @@
+/**********************************************************************/
+/* FILE:  caplib.c
+ * DATE:  16 OCT 2026
+ * AUTH:  G. E. Deschaines
+ * DESC:  Asynchronous image capture through a bounded queue of frames
+ *        drained by a pool of writer threads.
+ *
+ *        A captured frame is copied into a free queue slot, and writer
+ *        threads encode queued frames as X11 pixmap (XPM) files and
+ *        write them, so the render loop does not wait on encoding or
+ *        disk.  Frames rendered into the client-side framebuffer are
+ *        queued as copies of its palette indices.  Frames drawn by the
+ *        X server are queued as images read with XGetImage, the only
+ *        step left to the render loop since the X connection is used
+ *        by one thread; writers convert their screen pixel values to
+ *        palette indices with the pixel values and RGB values of the
+ *        palette colors queried at the start of a run.
+ *
+ *        When all slots are full, the render loop either blocks until
+ *        a writer frees one (CapBlock), so every frame is written, or
+ *        drops the frame (CapDrop), so rendering is never delayed.
+ *        Time spent blocked and frames dropped are reported with the
+ *        "-stats" option.
+ *
+ *        Frames queued with the same path (e.g., the duplicate of the
+ *        last frame of a run, written over by the next frame) are
+ *        written in queue order:  a writer does not take a frame while
+ *        another writer is writing one to the same path, so the file
+ *        ends up holding the last frame queued for it, as when frames
+ *        are written inline.
+*/
+/**********************************************************************/
+
+#define capMaxThr  16   /* maximum number of writer threads          */
+
+#define CapBlock    0   /* render loop waits for a free queue slot   */
+#define CapDrop     1   /* frames are dropped while the queue is full */
+
+#define capFree     0   /* slot states                               */
+#define capFill     1
+#define capReady    2
+#define capBusy     3
+
+typedef struct
+{
+  Integer   State;      /* capFree, capFill, capReady or capBusy     */
+  Longint   Seq;        /* order in which frame was queued           */
+  char      Path[280];  /* XPM file path                             */
+  FrmBuf    Fb;         /* frame palette indices                     */
+  XImage   *Img;        /* X server frame to convert, or NULL        */
+} CapSlot;
+
+typedef struct
+{
+  Integer          Nthr;    /* number of writer threads, 0 if inline */
+  Integer          Mode;    /* CapBlock or CapDrop                   */
+  Integer          Nslot;   /* queue capacity (frames)               */
+  CapSlot         *Slot;
+  Longint          Seq;     /* number of frames queued               */
+  Longint          Ndrop;   /* number of frames dropped              */
+  Longint          Nwait;   /* number of frames blocked for a slot   */
+  Extended         Twait;   /* time blocked for slots (sec)          */
+  Longint          Nbad;    /* X server pixels not in palette        */
+  unsigned long    Pix[fbNumClr];     /* X server palette pixels     */
+  unsigned char    RGB[fbNumClr][3];  /* X server palette colors     */
+  Boolean          Quit;    /* writers to exit                       */
+  Boolean          Fail;    /* a queued frame was not written        */
+  pthread_mutex_t  Mtx;
+  pthread_cond_t   Ready;   /* slot ready to be written              */
+  pthread_cond_t   Free;    /* slot freed                            */
+  pthread_t        Thr[capMaxThr];
+} CapPool;
+
+CapPool  cap;
+
+void CapFree( void );
+
+/*
+ * CONVERTS X SERVER IMAGE OF SLOT TO PALETTE INDICES, AND FREES IT
+*/
+static void CapConvert( CapSlot *slot )
+{
+   XImage          *img = slot->Img;
+   unsigned char   *dst = slot->Fb.Pix;
+   unsigned long    pix;
+   unsigned long    last = cap.Pix[fbBkgClr];
+   unsigned char    clr  = fbBkgClr;
+   Longint          x, y;
+   Longint          nbad = 0;
+   Integer          i;
+
+   for ( y = 0 ; y < slot->Fb.Hgt ; y++ ) {
+      for ( x = 0 ; x < slot->Fb.Wid ; x++ ) {
+         /* Runs of one color are common, so check last pixel first. */
+         pix = XGetPixel(img, x, y);
+         if ( pix != last ) {
+            for ( i = 0 ; i < fbNumClr ; i++ ) {
+               if ( cap.Pix[i] == pix ) break;
+            }
+            if ( i < fbNumClr ) {
+               clr  = (unsigned char)i;
+               last = pix;
+            } else {
+               clr  = fbBkgClr;
+               last = cap.Pix[fbBkgClr];
+               nbad++;
+            }
+         }
+         *dst++ = clr;
+      }
+   }
+   XDestroyImage(img);
+   slot->Img = NULL;
+   if ( nbad > 0 ) __sync_fetch_and_add(&cap.Nbad, nbad);
+}
+
+/*
+ * RETURNS TRUE IF A WRITER IS WRITING A FRAME TO THE PATH OF SLOT
+*/
+static Boolean CapPathBusy( CapSlot *slot )
+{
+   Integer  i;
+
+   for ( i = 0 ; i < cap.Nslot ; i++ ) {
+      if ( ( cap.Slot[i].State == capBusy ) &&
+           ( strcmp(cap.Slot[i].Path, slot->Path) == 0 ) ) return TRUE;
+   }
+   return FALSE;
+}
+
+/*
+ * WRITER THREAD; WRITES QUEUED FRAMES, OLDEST FIRST (SKIPPING THOSE
+ * WHOSE PATH IS BEING WRITTEN), UNTIL TOLD TO QUIT AND NO FRAMES REMAIN
+*/
+static void *CapWriter( void *arg )
+{
+   CapSlot  *slot;
+   Integer   i;
+   Boolean   ok;
+
+   TRACE_THREAD("writer");
+   pthread_mutex_lock(&cap.Mtx);
+   for (;;) {
+      slot = NULL;
+      for ( i = 0 ; i < cap.Nslot ; i++ ) {
+         if ( ( cap.Slot[i].State == capReady ) &&
+              ( ( slot == NULL ) || ( cap.Slot[i].Seq < slot->Seq ) ) &&
+              ( ! CapPathBusy(&cap.Slot[i]) ) ) {
+            slot = &cap.Slot[i];
+         }
+      }
+      if ( slot == NULL ) {
+         if ( cap.Quit ) break;
+         pthread_cond_wait(&cap.Ready, &cap.Mtx);
+         continue;
+      }
+      slot->State = capBusy;
+      pthread_mutex_unlock(&cap.Mtx);
+
+      TRACE_BEG(1,"CapWrite");
+      if ( slot->Img != NULL ) {
+         CapConvert(slot);
+         ok = FbWriteXPMRGB(&slot->Fb, slot->Path, cap.RGB);
+      } else {
+         ok = FbWriteXPM(&slot->Fb, slot->Path);
+      }
+      if ( ! ok ) __atomic_store_n(&cap.Fail, TRUE, __ATOMIC_RELEASE);
+      TRACE_END(1);
+
+      pthread_mutex_lock(&cap.Mtx);
+      slot->State = capFree;
+      pthread_cond_broadcast(&cap.Free);
+      pthread_cond_broadcast(&cap.Ready);
+   }
+   pthread_mutex_unlock(&cap.Mtx);
+   return NULL;
+}
+
+/*
+ * CREATES QUEUE OF nslot FRAMES OF GIVEN SIZE AND STARTS nthr WRITER
+ * THREADS; WITH NO THREADS, FRAMES ARE TO BE WRITTEN INLINE
+*/
+Boolean CapCreate( Integer nthr, Integer nslot, Integer mode,
+                   Integer wid, Integer hgt )
+{
+   Integer  i;
+
+   memset(&cap, 0, sizeof(cap));
+   if ( nthr <= 0 ) return TRUE;
+
+   cap.Mode  = mode;
+   cap.Nslot = (Integer)lmax(1, nslot);
+   cap.Slot  = (CapSlot *)calloc(cap.Nslot, sizeof(CapSlot));
+   if ( cap.Slot == NULL ) {
+      printf("CapCreate:  calloc error for %d frame slots.\n",cap.Nslot);
+      return FALSE;
+   }
+   for ( i = 0 ; i < cap.Nslot ; i++ ) {
+      if ( ! FbCreate(&cap.Slot[i].Fb, wid, hgt) ) {
+         while ( i > 0 ) FbFree(&cap.Slot[--i].Fb);
+         free(cap.Slot);
+         cap.Slot = NULL;
+         return FALSE;
+      }
+   }
+   for ( i = 0 ; i < fbNumClr ; i++ ) {
+      memcpy(cap.RGB[i], fbRGB[i], 3);
+   }
+
+   pthread_mutex_init(&cap.Mtx, NULL);
+   pthread_cond_init(&cap.Ready, NULL);
+   pthread_cond_init(&cap.Free, NULL);
+   nthr = (Integer)lmin(nthr, capMaxThr);
+   for ( i = 0 ; i < nthr ; i++ ) {
+      if ( pthread_create(&cap.Thr[i], NULL, CapWriter, NULL) != 0 ) break;
+      cap.Nthr++;
+   }
+   if ( cap.Nthr == 0 ) {
+      printf("CapCreate:  pthread_create error; writing frames inline.\n");
+      CapFree();
+   }
+#if DBG_LVL > 0
+   printf("CapCreate:  %d writer threads, %d frame slots\n",cap.Nthr,cap.Nslot);
+#endif
+   return TRUE;
+}
+
+/*
+ * SETS X SERVER PIXEL VALUES AND RGB VALUES OF PALETTE COLORS
+*/
+void CapPalette( unsigned long pix[fbNumClr], unsigned char rgb[fbNumClr][3] )
+{
+   Integer  i;
+
+   for ( i = 0 ; i < fbNumClr ; i++ ) {
+      cap.Pix[i] = pix[i];
+      memcpy(cap.RGB[i], rgb[i], 3);
+   }
+}
+
+/*
+ * RETURNS A FREE SLOT MARKED FOR FILLING, WAITING FOR ONE IF BLOCKING,
+ * OR NULL IF DROPPING FRAME
+*/
+static CapSlot *CapTake( void )
+{
+   CapSlot   *slot = NULL;
+   Extended   twait = 0.0;
+   Integer    i;
+
+   pthread_mutex_lock(&cap.Mtx);
+   for (;;) {
+      for ( i = 0 ; i < cap.Nslot ; i++ ) {
+         if ( cap.Slot[i].State == capFree ) {
+            slot = &cap.Slot[i];
+            break;
+         }
+      }
+      if ( slot != NULL ) break;
+      if ( cap.Mode == CapDrop ) {
+         cap.Ndrop = cap.Ndrop + 1;
+         break;
+      }
+      if ( twait == 0.0 ) {
+         twait = RenSec();
+         cap.Nwait = cap.Nwait + 1;
+      }
+      pthread_cond_wait(&cap.Free, &cap.Mtx);
+   }
+   if ( twait > 0.0 ) cap.Twait = cap.Twait + RenSec() - twait;
+   if ( slot != NULL ) slot->State = capFill;
+   pthread_mutex_unlock(&cap.Mtx);
+   return slot;
+}
+
+/*
+ * QUEUES FILLED SLOT FOR WRITING
+*/
+static void CapGive( CapSlot *slot, const char *fpath )
+{
+   strncpy(slot->Path, fpath, sizeof(slot->Path)-1);
+   slot->Path[sizeof(slot->Path)-1] = '\0';
+   pthread_mutex_lock(&cap.Mtx);
+   slot->Seq   = cap.Seq;
+   slot->State = capReady;
+   cap.Seq = cap.Seq + 1;
+   pthread_cond_signal(&cap.Ready);
+   pthread_mutex_unlock(&cap.Mtx);
+}
+
+/*
+ * QUEUES COPY OF FRAMEBUFFER TO BE WRITTEN TO XPM FILE
+*/
+void CapPutFb( FrmBuf *fb, const char *fpath )
+{
+   CapSlot  *slot = CapTake();
+
+   if ( slot == NULL ) return;
+   memcpy(slot->Fb.Pix, fb->Pix, (size_t)fb->Wid*(size_t)fb->Hgt);
+   slot->Img = NULL;
+   CapGive(slot, fpath);
+}
+
+/*
+ * QUEUES X SERVER IMAGE TO BE WRITTEN TO XPM FILE; THE IMAGE IS FREED
+ * ONCE WRITTEN OR DROPPED
+*/
+void CapPutImage( XImage *img, const char *fpath )
+{
+   CapSlot  *slot = CapTake();
+
+   if ( slot == NULL ) {
+      XDestroyImage(img);
+      return;
+   }
+   slot->Img = img;
+   CapGive(slot, fpath);
+}
+
+/*
+ * WAITS UNTIL ALL QUEUED FRAMES HAVE BEEN WRITTEN
+*/
+void CapFlush( void )
+{
+   Integer  i;
+
+   if ( cap.Nthr == 0 ) return;
+   pthread_mutex_lock(&cap.Mtx);
+   for ( i = 0 ; i < cap.Nslot ; i++ ) {
+      while ( cap.Slot[i].State != capFree ) {
+         pthread_cond_wait(&cap.Free, &cap.Mtx);
+      }
+   }
+   pthread_mutex_unlock(&cap.Mtx);
+}
+
+/*
+ * WRITES QUEUED FRAMES, STOPS WRITER THREADS AND FREES QUEUE
+*/
+void CapFree( void )
+{
+   Integer  i;
+
+   if ( cap.Slot == NULL ) return;
+   pthread_mutex_lock(&cap.Mtx);
+   cap.Quit = TRUE;
+   pthread_cond_broadcast(&cap.Ready);
+   pthread_mutex_unlock(&cap.Mtx);
+   for ( i = 0 ; i < cap.Nthr ; i++ ) {
+      pthread_join(cap.Thr[i], NULL);
+   }
+   for ( i = 0 ; i < cap.Nslot ; i++ ) {
+      if ( cap.Slot[i].Img != NULL ) XDestroyImage(cap.Slot[i].Img);
+      FbFree(&cap.Slot[i].Fb);
+   }
+   free(cap.Slot);
+   cap.Slot = NULL;
+   pthread_mutex_destroy(&cap.Mtx);
+   pthread_cond_destroy(&cap.Ready);
+   pthread_cond_destroy(&cap.Free);
+   cap.Nthr = 0;
+}
+
+/*
+ * PRINTS CAPTURE QUEUE STATISTICS
+*/
+void CapReport( void )
+{
+   if ( cap.Seq + cap.Ndrop == 0 ) return;
+   printf("CapReport:  %ld frames queued, %ld dropped\n",cap.Seq,cap.Ndrop);
+   printf("CapReport:  %ld frames blocked, %.3f ms blocked per frame\n",
+          cap.Nwait, 1.0e3*cap.Twait/lmax(1, cap.Seq));
+   if ( cap.Nbad > 0 ) {
+      printf("CapReport:  %ld X server pixels not in palette\n",cap.Nbad);
+   }
+}
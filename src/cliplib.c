@@ -7,6 +7,21 @@
  *        were derived from algorithms presented on pages 152-155 in
  *        Chapter 3 of "Procedural Elements for Computer Graphics"
  *        by David F. Rogers, published by McGraw-Hill, Inc., 1985.
+ *
+ *        Before clipping, a polygon's vertices are outcoded against
+ *        all six frustum edges in one pass.  Polygons with every
+ *        vertex outside one edge are rejected, polygons with every
+ *        vertex strictly inside all edges are accepted unchanged, and
+ *        other polygons are clipped only to the edges that some vertex
+ *        is outside of or on.  Since a clip to an edge that every
+ *        vertex is strictly inside of returns the polygon unchanged,
+ *        the clipped polygons are those of clipping to all six edges.
+ *
+ *        Line segments, such as those of the ground plane grid, are
+ *        clipped in batches by the parametric method of Liang and
+ *        Barsky, which finds the visible parameter interval of each
+ *        segment from its signed distances to the six frustum edges
+ *        without constructing intermediate vertices.
 */
 /**********************************************************************/
 
@@ -18,10 +33,56 @@ typedef unsigned long int   Word;
 typedef double              Extended;
 #endif
 
-#define mxvcnt  32       /* maximum vertices in clipped polygon */
+#define mxvcnt  32       /* initial vertices in clipped polygon */
 #define zmin        0.1  /* minimum z clipping distance         */
 #define zmax    20000.0  /* maximum z clipping distance         */
 
+/* Vertex lists of the polygon before and after each of the six
+ * frustum edge clips, indexed from 1 with the first vertex repeated
+ * after the last, grown to hold the largest polygon clipped.
+*/
+Pnt3D   *clpvtx[8] = { NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL };
+Longint  clpmax    = 0;  /* vertex capacity of each list */
+
+/* Polygon clipping statistics. */
+
+typedef struct
+{
+  Longint   Acc;  /* number of polygons trivially accepted  */
+  Longint   Rej;  /* number of polygons trivially rejected  */
+  Longint   Clp;  /* number of polygons clipped             */
+  Longint   Edg;  /* number of edges polygons clipped to    */
+  Extended  Sec;  /* time spent clipping (sec), if measured */
+} Clip3D;
+
+Clip3D  clipstat = { 0, 0, 0, 0, 0.0 };
+
+/*
+ * Grows clip vertex lists to hold nvtx vertices, returning FALSE if
+ * memory could not be allocated.
+*/
+Boolean ClipGrow( Longint nvtx )
+{
+   Pnt3D    *vtx;
+   Longint   max;
+   Integer   k;
+
+   if ( nvtx < clpmax ) return TRUE;
+
+   max = ( clpmax == 0 ) ? mxvcnt : clpmax;
+   while ( max <= nvtx ) max = 2*max;
+   for ( k = 0 ; k < 8 ; k++ ) {
+      vtx = (Pnt3D *)realloc(clpvtx[k], max*sizeof(Pnt3D));
+      if ( vtx == NULL ) {
+         printf("ClipGrow:  realloc error for %ld vertices.\n",max);
+         return FALSE;
+      }
+      clpvtx[k] = vtx;
+   }
+   clpmax = max;
+   return TRUE;
+}
+
 /*
  * Calculates edge code for given pyramidal frustum edge and
  * polygon vertex point.
@@ -71,6 +132,28 @@ void EdgeCode( Integer edge, Pnt3D a_pt, Longint *code )
    }
 }
 
+/*
+ * Calculates outcodes of polygon vertex point for all six pyramidal
+ * frustum edges, with the bit of edge e being 1 << (e-1).  The out
+ * code has bits set for edges the point is outside of, and the bnd
+ * code for edges the point is outside of or on.
+*/
+void ClipCode( Pnt3D a_pt, Integer *out, Integer *bnd )
+{
+   Extended  x, y, z;
+
+   x =  a_pt.Y;
+   y = -a_pt.Z;
+   z =  a_pt.X;
+
+   *out = ( ( x <  -z )   ?  1 : 0 ) | ( ( x >   z )   ?  2 : 0 ) |
+          ( ( y <  -z )   ?  4 : 0 ) | ( ( y >   z )   ?  8 : 0 ) |
+          ( ( z >  zmax ) ? 16 : 0 ) | ( ( z <  zmin ) ? 32 : 0 );
+   *bnd = ( ( x <= -z )   ?  1 : 0 ) | ( ( x >=  z )   ?  2 : 0 ) |
+          ( ( y <= -z )   ?  4 : 0 ) | ( ( y >=  z )   ?  8 : 0 ) |
+          ( ( z >= zmax ) ? 16 : 0 ) | ( ( z <= zmin ) ? 32 : 0 );
+}
+
 /*
  * Determines pyramidal frustum edge clipping of given line segment.
 */
@@ -134,19 +217,50 @@ void EdgeClip( Integer edge, Pnt3D pt_s, Pnt3D pt_e, Pnt3D *pt_i )
 /*
  * Clips given polygon to 3D viewing pyramidal frustum.
 */
-void PolyClip( Integer* pcnt, Integer vcnt[], Pnt3D vlist[][mxvcnt] )
+void PolyClip( Longint* pcnt, Longint vcnt[], Pnt3D* vlist[] )
 {
    Longint  cs, ce;
-   Integer  pcntp1;
-   Integer  icnt, jcnt;
+   Longint  pcntp1;
+   Longint  icnt, jcnt;
    Pnt3D    pt_S, pt_E, pt_X;
+   Integer  edge, out, bnd;
+   Integer  outall, bndany;
 
-   do {
+/* outcode polygon points against all frustum edges */
+   outall = 0x3F;
+   bndany = 0;
+   for ( icnt = 1 ; icnt < vcnt[*pcnt] ; icnt++ ) {
+      ClipCode(vlist[*pcnt][icnt],&out,&bnd);
+      outall = outall & out;
+      bndany = bndany | bnd;
+   }
+   if ( outall != 0 ) {
+   /* all points outside one frustum edge - reject */
+      clipstat.Rej = clipstat.Rej + 1;
+      vcnt[*pcnt]  = 0;
+      return;
+   }
+   if ( bndany == 0 ) {
+   /* all points strictly inside all frustum edges - accept */
+      clipstat.Acc = clipstat.Acc + 1;
+      return;
+   }
+   clipstat.Clp = clipstat.Clp + 1;
+
+   for ( edge = 1 ; edge <= 6 ; edge++ ) {
+      if ( ( bndany & (1 << (edge-1)) ) == 0 ) continue;
+      clipstat.Edg = clipstat.Edg + 1;
+   /* each edge clip at most doubles the number of polygon points */
+      if ( ! ClipGrow(2*vcnt[*pcnt]) ) {
+         *pcnt       = 7;
+         vcnt[*pcnt] = 0;
+         return;
+      }
    /* check all polygon points against each frustum edge */
       pcntp1 = *pcnt + 1;
       jcnt   = 0;
       pt_S   = vlist[*pcnt][1];
-      EdgeCode(*pcnt,pt_S,&cs);
+      EdgeCode(edge,pt_S,&cs);
       if ( cs >= 0 ) {
       /* pt_S inside or on frustum edge - save */
          jcnt                = jcnt + 1;
@@ -156,15 +270,15 @@ void PolyClip( Integer* pcnt, Integer vcnt[], Pnt3D vlist[][mxvcnt] )
       for ( icnt = 2 ; icnt <= vcnt[*pcnt] ; icnt++ ) {
       /* check all subsequent points along polygon */
          pt_E = vlist[*pcnt][icnt];
-         EdgeCode(*pcnt,pt_E,&ce);
+         EdgeCode(edge,pt_E,&ce);
          if ( cs != ce ) {
          /* line segment intercepts frustum edge */
             if ( cs < ce ) {
             /* pt_S left of pt_E */
-               EdgeClip(*pcnt,pt_S,pt_E,&pt_X);
+               EdgeClip(edge,pt_S,pt_E,&pt_X);
 	    } else {
             /* pt_E left of pt_S */
-               EdgeClip(*pcnt,pt_E,pt_S,&pt_X);
+               EdgeClip(edge,pt_E,pt_S,&pt_X);
             }
             /* save this intercept */
 	    jcnt                = jcnt + 1;
@@ -189,12 +303,95 @@ void PolyClip( Integer* pcnt, Integer vcnt[], Pnt3D vlist[][mxvcnt] )
       *pcnt       = pcntp1;
       vcnt[*pcnt] = jcnt;
 #if DBG_LVL > 5
-      Integer i;
+      Longint i;
       for (i=1; i<=vcnt[*pcnt]; i++)
-         printf("PolyClip:  %d %d %f %f %f\n",*pcnt,i,
+         printf("PolyClip:  %ld %ld %f %f %f\n",*pcnt,i,
                 vlist[*pcnt][i].X,vlist[*pcnt][i].Y,vlist[*pcnt][i].Z);
 #endif
-   } while ( ! ( ( *pcnt == 7 ) || ( jcnt == 0 ) ) );
+      if ( jcnt == 0 ) break;
+   }
+}
+
+/*
+ * Clips line segments from p0[i] to p1[i], i = 0 to nseg-1, to the 3D
+ * viewing pyramidal frustum, packing the visible parts of segments in
+ * order at the start of the arrays, and returns their number.
+*/
+Longint LineClip( Longint nseg, Pnt3D p0[], Pnt3D p1[] )
+{
+   Extended  x, y, z, dx, dy, dz;
+   Extended  f[6], df[6];
+   Extended  t, t0, t1;
+   Pnt3D     q0, q1;
+   Longint   i, n;
+   Integer   e;
+
+   n = 0;
+   for ( i = 0 ; i < nseg ; i++ ) {
+   /* load segment into viewing pyramid space */
+      x  =  p0[i].Y;
+      y  = -p0[i].Z;
+      z  =  p0[i].X;
+      dx =  p1[i].Y - p0[i].Y;
+      dy = -(p1[i].Z - p0[i].Z);
+      dz =  p1[i].X - p0[i].X;
+   /* distances f + t*df inside each frustum edge at parameter t */
+      f[0] = z + x;     df[0] = dz + dx;  /* left edge   */
+      f[1] = z - x;     df[1] = dz - dx;  /* right edge  */
+      f[2] = z + y;     df[2] = dz + dy;  /* bottom edge */
+      f[3] = z - y;     df[3] = dz - dy;  /* top edge    */
+      f[4] = zmax - z;  df[4] = -dz;      /* max z plane */
+      f[5] = z - zmin;  df[5] = dz;       /* min z plane */
+   /* narrow visible parameter interval [t0,t1] edge by edge */
+      t0 = 0.0;
+      t1 = 1.0;
+      for ( e = 0 ; e < 6 ; e++ ) {
+         if ( df[e] == 0.0 ) {
+            if ( f[e] < 0.0 ) break;        /* parallel and outside */
+         } else {
+            t = -f[e]/df[e];
+            if ( df[e] > 0.0 ) {
+               if ( t > t0 ) t0 = t;        /* entering edge */
+            } else {
+               if ( t < t1 ) t1 = t;        /* leaving edge  */
+            }
+            if ( t0 > t1 ) break;
+         }
+      }
+      if ( e < 6 ) continue;
+   /* save visible part of segment */
+      q0 = p0[i];
+      q1 = p1[i];
+      if ( t0 > 0.0 ) {
+         q0.X = p0[i].X + t0*(p1[i].X - p0[i].X);
+         q0.Y = p0[i].Y + t0*(p1[i].Y - p0[i].Y);
+         q0.Z = p0[i].Z + t0*(p1[i].Z - p0[i].Z);
+      }
+      if ( t1 < 1.0 ) {
+         q1.X = p0[i].X + t1*(p1[i].X - p0[i].X);
+         q1.Y = p0[i].Y + t1*(p1[i].Y - p0[i].Y);
+         q1.Z = p0[i].Z + t1*(p1[i].Z - p0[i].Z);
+      }
+      p0[n] = q0;
+      p1[n] = q1;
+      n     = n + 1;
+   }
+   return n;
+}
+
+/*
+ * Prints polygon clipping statistics over given number of frames.
+*/
+void ClipReport( Longint nfrm )
+{
+   Longint  nclp = ( clipstat.Clp > 0 ) ? clipstat.Clp : 1;
+
+   if ( nfrm < 1 ) nfrm = 1;
+   printf("ClipReport:  %.1f accepted, %.1f rejected, %.1f clipped polygons per frame\n",
+          (Extended)clipstat.Acc/nfrm, (Extended)clipstat.Rej/nfrm,
+          (Extended)clipstat.Clp/nfrm);
+   printf("ClipReport:  %.2f edges per clipped polygon, %.3f ms clipping per frame\n",
+          (Extended)clipstat.Edg/nclp, 1.0e3*clipstat.Sec/nfrm);
 }
 
 /**********************************************************************/
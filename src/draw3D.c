@@ -65,6 +65,7 @@
 #include <X11/keysym.h>
 #include <Xm/Xm.h>
 #include <Xm/DrawingA.h>
+#include <X11/extensions/Xdbe.h>
 
 static GC         the_GC;
 static XGCValues  the_GCv;
@@ -72,6 +73,27 @@ static int        img_FPS = 50;
 static int        run_NUM = 0;
 static int        msl_TYP = 1;
 static int        img_OUT = 0;
+static int        ren_MOD = 0;
+static int        win_WID = 800;
+static int        win_HGT = 600;
+static char       img_DIR[256] = "./Ximg";
+static char*      str_PATH = NULL;
+static double     sek_TSEC = -1.0;
+static char*      fol_PATH = NULL;
+static int        str_FMT = 0;
+static int        srt_BEN = 0;
+static int        sta_OUT = 0;
+static long       scl_CNT = 1;
+static int        zbf_MOD = 0;
+static int        thr_CNT = 1;
+static int        rat_FPS = 0;
+static int        wrt_CNT = 2;
+static int        wrt_QUE = 8;
+static int        wrt_DRP = 0;
+static int        pip_USE = 0;
+static char*      bch_PATH = NULL;
+static int        shm_USE = 1;
+static int        dbe_USE = 0;
 static Pixel      pixels[8];
 static Boolean    quitflag = FALSE;
 #endif
@@ -136,7 +158,10 @@ Longint lmax(Longint x1, Longint x2)
    else           return x1;
 }
 
+#include "tracelib.c"
 #include "pquelib.c"
+#include "sortlib.c"
+#include "xfrmlib.c"
 
 typedef struct Pnt_3D
 {
@@ -145,27 +170,16 @@ typedef struct Pnt_3D
   Extended  Z;
 } Pnt3D;
 
-typedef struct Pol_Rec *PolPtr;
-typedef struct Pol_Rec
-{
-  PolPtr  Nxt;
-  Pnt3D   Pt0;
-  Pnt3D   Pt1;
-  Pnt3D   Pt2;
-} PolRec;
-
 typedef struct
 {
   Boolean  Flg;
   Longint  Pri;
   Integer  Typ;
   Integer  Vis;
-  Pnt3D    Cnt0;
-  Pnt3D    Cnt1;
-  Pnt3D    Nrm0;
-  Pnt3D    Nrm1;
   Word     Pat;
-  PolPtr   Ptr;
+  Longint  Voff;  /* offset of first vertice in vertex store */
+  Longint  Vcnt;  /* number of polygon vertice               */
+  Longint  Obj;   /* number of object polygon belongs to     */
 } Pol3D;
 
 /* CONSTANTS */
@@ -176,7 +190,6 @@ Extended  fOne   = 1.0;
 Extended  fTwo   = 2.0;
 Extended  f1K    = 1000.0;
 Extended  rpd    = 0.01745329;  /* Radian per degree */
-Longint   CpMsec = CLOCKS_PER_SEC/1000;
 
 /* FOV INFORMATION */
 
@@ -213,15 +226,135 @@ Extended  dcx3, dcy3, dcz3;
 Pnt3D  GridPt1[4];
 Pnt3D  GridPt2[4];
 
-/* POLYGON INFORMATION */
+/* POLYGON INFORMATION
+ *
+ * Polygons are numbered from 1; the polygon list, the centroid and
+ * normal store and the vertex store grow by doubling as models are
+ * loaded, as do the point list of the polygon being loaded and the
+ * clipped polygon screen point list, so scene size is bounded only
+ * by memory.
+*/
+
+#define maxpol  1024  /* Initial capacity of polygon list            */
+#define maxpnt    16  /* Initial capacity of loaded polygon points   */
 
-#define maxpol  1024  /* Maximum number of polygons                 */
-#define maxpnt    16  /* Maximum number of points in loaded polygon */
+Longint  polcnt = 0;
+Longint  polmax = 0;     /* allocated polygons, including unused 0 */
+Pol3D   *pollist = NULL;
+Longint  pntmax = 0;     /* allocated loaded polygon points        */
+Pnt3D   *pntlist = NULL;
+Longint  xptmax = 0;     /* allocated screen points                */
+XPoint  *xptlist = NULL;
+SortList polSL;
 
-Integer  polcnt = 0;
-Pol3D    pollist[maxpol];
-Pnt3D    pntlist[maxpnt];
-PQtype   polPQ;
+/* POLYGON VERTEX STORE
+ *
+ * Vertice of all polygons are kept contiguously in load order as
+ * separate X, Y and Z coordinate arrays for the model (0), world (1)
+ * and scaled viewport (2) coordinate spaces, so polygon movement and
+ * transformation loops stream linearly through memory.
+*/
+
+typedef struct
+{
+  Longint    Cnt;           /* number of stored vertice    */
+  Longint    Max;           /* allocated vertice capacity  */
+  Extended  *X0, *Y0, *Z0;  /* model coordinates           */
+  Extended  *X1, *Y1, *Z1;  /* world coordinates           */
+  Extended  *X2, *Y2, *Z2;  /* scaled viewport coordinates */
+} Vtx3D;
+
+Vtx3D    vtxlist = { 0, 0, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL };
+
+/* POLYGON CENTROID AND NORMAL STORE
+ *
+ * Centroids and unit normals of all polygons are kept as separate X,
+ * Y and Z coordinate arrays indexed by polygon number for the model
+ * (0), world (1) and viewport (2) coordinate spaces, so polygons of
+ * an object are moved and transformed together as one batch.  The
+ * viewport centroid is the unscaled eye vector to the centroid.
+*/
+
+typedef struct
+{
+  Extended  *CX0, *CY0, *CZ0;  /* model centroids    */
+  Extended  *CX1, *CY1, *CZ1;  /* world centroids    */
+  Extended  *CX2, *CY2, *CZ2;  /* viewport centroids */
+  Extended  *NX0, *NY0, *NZ0;  /* model normals      */
+  Extended  *NX1, *NY1, *NZ1;  /* world normals      */
+  Extended  *NX2, *NY2, *NZ2;  /* viewport normals   */
+} Ctr3D;
+
+Ctr3D    ctrlist;
+
+/* OBJECT INFORMATION
+ *
+ * An object is a run of consecutively loaded polygons of the same type
+ * from one polygon file, bounded by a sphere about its vertice.  Each
+ * frame, the bounding sphere of each object is placed in world space
+ * and tested against the viewing frustum, and the polygons of objects
+ * entirely outside the frustum are neither moved nor transformed.  The
+ * remaining objects are ordered by depth and those overlapping in depth
+ * are clustered, so polygons are only depth sorted against polygons
+ * of the same cluster.
+*/
+
+#define maxobj    64  /* Initial capacity of object list            */
+
+typedef struct
+{
+  Integer   Typ;   /* object polygon type                        */
+  Longint   Pol1;  /* first polygon number                       */
+  Longint   Pol2;  /* last polygon number                        */
+  Longint   Pri;   /* polygon priority code, -1 if mixed         */
+  Pnt3D     Cen0;  /* bounding sphere center in model space      */
+  Pnt3D     Cen1;  /* bounding sphere center in world space      */
+  Extended  Rad;   /* bounding sphere radius                     */
+  Extended  Near;  /* viewport distance to near side of sphere   */
+  Extended  Far;   /* viewport distance to far side of sphere    */
+  Longint   Grp;   /* drawing rank of object's cluster           */
+  Boolean   Mov;   /* object placed in world space this frame    */
+  Boolean   Cul;   /* object outside viewing frustum this frame  */
+  Extended  Mw[9]; /* model to world space rotation matrix       */
+  Extended  Tw[3]; /* model to world space translation           */
+} Obj3D;
+
+Longint  objcnt = 0;
+Longint  objmax = 0;     /* allocated objects */
+Obj3D   *objlist = NULL;
+Longint *objord  = NULL;
+Longint  grpcnt  = 0;
+
+/* OBJECT CULLING STATISTICS */
+
+typedef struct
+{
+  Longint  Nfrm;  /* number of frames culled             */
+  Longint  Nobj;  /* number of objects tested            */
+  Longint  Cobj;  /* number of objects culled            */
+  Longint  Cpol;  /* number of polygons culled           */
+  Longint  Fobj;  /* number of objects culled this frame */
+  Longint  Fpol;  /* number of polygons culled this frame */
+} Cull3D;
+
+Cull3D   cullstat;
+
+/* GROUND GRID DRAWING STATISTICS */
+
+typedef struct
+{
+  Longint   Nseg;  /* number of grid segments clipped  */
+  Longint   Dseg;  /* number of grid segments drawn    */
+  Longint   Nreq;  /* number of grid drawing requests  */
+  Extended  Sec;   /* time spent drawing grid (sec)    */
+} Grid3D;
+
+Grid3D   gridstat;
+
+/* FRAME TIMING STATISTICS */
+
+Longint   frmcnt = 0;    /* number of frames rendered          */
+Extended  frmsec = 0.0;  /* time spent rendering frames (sec)  */
 
 #define poltyp_gnd  0  /* ground polygon type  */
 #define poltyp_tgt  1  /* target polygon type  */
@@ -243,6 +376,11 @@ Extended  xAspect = 1.0;
 Extended  yAspect = 1.0;
 Pixmap    drawn;
 Pixmap    blank;
+Integer   pixWid = 0;        /* size of drawn and blank pixmaps  */
+Integer   pixHgt = 0;
+Window    dbeWin = None;     /* window with double buffer        */
+Drawable  dbeBack = None;    /* back buffer of window, if any    */
+Boolean   dbeOn = FALSE;     /* drawing to back buffer           */
 Word      SolidPattern;
 Word      White  = 0;
 Word      Black  = 1;
@@ -253,8 +391,6 @@ Word      Cyan   = 5;
 Word      Yellow = 6;
 Word      Brown  = 7;
 Word      Colors[] = {0, 1, 2, 3, 4, 5, 6, 7};
-Longint   cpumsec1;
-Longint   cpumsec2;
 
 /* I/O BUFFERS */
 
@@ -318,17 +454,136 @@ Pnt3D CrossP3D(Pnt3D A, Pnt3D B)
 }
 
 /*
- * MAKES LINKED LIST OF POLYGON DATA FROM ARRAY OF POLYGON DATA
+ * GROWS POLYGON VERTEX STORE TO HOLD AT LEAST nvtx VERTICE
+*/
+Boolean GrowVtx( Longint nvtx )
+{
+   Extended  *blk;
+   Extended  *old;
+   Longint    max;
+   Integer    k;
+
+   if ( nvtx <= vtxlist.Max ) return TRUE;
+
+   max = ( vtxlist.Max == 0 ) ? 1024 : vtxlist.Max;
+   while ( max < nvtx ) max = 2*max;
+
+/* Allocate one cache line aligned block holding all nine coordinate
+   arrays and move the stored vertice of each array into its place in
+   the new block.
+*/
+   if ( posix_memalign((void **)&blk, 64, 9*max*sizeof(Extended)) != 0 ) {
+      printf("GrowVtx:  posix_memalign error for %ld vertice.\n",max);
+      return FALSE;
+   }
+   old = vtxlist.X0;
+   for ( k = 0 ; k < 9 ; k++ ) {
+      if ( vtxlist.Cnt > 0 ) {
+         memcpy(blk+k*max, old+k*vtxlist.Max, vtxlist.Cnt*sizeof(Extended));
+      }
+   }
+   free(old);
+
+   vtxlist.X0  = blk;
+   vtxlist.Y0  = blk + 1*max;
+   vtxlist.Z0  = blk + 2*max;
+   vtxlist.X1  = blk + 3*max;
+   vtxlist.Y1  = blk + 4*max;
+   vtxlist.Z1  = blk + 5*max;
+   vtxlist.X2  = blk + 6*max;
+   vtxlist.Y2  = blk + 7*max;
+   vtxlist.Z2  = blk + 8*max;
+   vtxlist.Max = max;
+   return TRUE;
+}
+
+/*
+ * GROWS POLYGON LIST AND CENTROID AND NORMAL STORE TO HOLD POLYGONS
+ * NUMBERED THRU npol
+*/
+Boolean GrowPol( Longint npol )
+{
+   Pol3D     *pol;
+   Extended  *blk;
+   Extended  *old;
+   Extended **arr[18];
+   Longint    max;
+   Integer    k;
+
+   if ( npol < polmax ) return TRUE;
+
+   max = ( polmax == 0 ) ? maxpol : polmax;
+   while ( max <= npol ) max = 2*max;
+
+   pol = (Pol3D *)realloc(pollist, max*sizeof(Pol3D));
+   if ( pol == NULL ) {
+      printf("GrowPol:  realloc error for %ld polygons.\n",max);
+      return FALSE;
+   }
+   pollist = pol;
+
+/* Allocate one cache line aligned block holding all eighteen centroid
+   and normal arrays and move the stored polygons of each array into
+   its place in the new block.
 */
-void MakePol( Integer pntcnt,
+   if ( posix_memalign((void **)&blk, 64, 18*max*sizeof(Extended)) != 0 ) {
+      printf("GrowPol:  posix_memalign error for %ld polygons.\n",max);
+      return FALSE;
+   }
+   arr[ 0] = &ctrlist.CX0; arr[ 1] = &ctrlist.CY0; arr[ 2] = &ctrlist.CZ0;
+   arr[ 3] = &ctrlist.CX1; arr[ 4] = &ctrlist.CY1; arr[ 5] = &ctrlist.CZ1;
+   arr[ 6] = &ctrlist.CX2; arr[ 7] = &ctrlist.CY2; arr[ 8] = &ctrlist.CZ2;
+   arr[ 9] = &ctrlist.NX0; arr[10] = &ctrlist.NY0; arr[11] = &ctrlist.NZ0;
+   arr[12] = &ctrlist.NX1; arr[13] = &ctrlist.NY1; arr[14] = &ctrlist.NZ1;
+   arr[15] = &ctrlist.NX2; arr[16] = &ctrlist.NY2; arr[17] = &ctrlist.NZ2;
+   old = ctrlist.CX0;
+   for ( k = 0 ; k < 18 ; k++ ) {
+      if ( polmax > 0 ) {
+         memcpy(blk+k*max, *arr[k], polmax*sizeof(Extended));
+      }
+      *arr[k] = blk + k*max;
+   }
+   free(old);
+
+   polmax = max;
+   return TRUE;
+}
+
+/*
+ * GROWS LIST *pLst OF *pMax ITEMS OF GIVEN SIZE TO HOLD AT LEAST n
+ * ITEMS, STARTING WITH min ITEMS
+*/
+Boolean GrowList( void **pLst, Longint *pMax, Longint n, size_t size,
+                  Longint min )
+{
+   void     *lst;
+   Longint   max;
+
+   if ( n <= *pMax ) return TRUE;
+
+   max = ( *pMax == 0 ) ? min : *pMax;
+   while ( max < n ) max = 2*max;
+   lst = realloc(*pLst, max*size);
+   if ( lst == NULL ) {
+      printf("GrowList:  realloc error for %ld items.\n",max);
+      return FALSE;
+   }
+   *pLst = lst;
+   *pMax = max;
+   return TRUE;
+}
+
+/*
+ * MAKES POLYGON IN POLYGON LIST AND VERTEX STORE FROM ARRAY OF
+ * POLYGON DATA
+*/
+void MakePol( Longint pntcnt,
               Integer thePri,
               Integer theTyp, 
               Integer theVis,
               Word thePat, Pnt3D offset )
 {
-   PolPtr    newPtr;
-   PolPtr    oldPtr;
-   PolPtr    aPolRec;
+   Longint   j;
    Extended  sumP;
    Extended  sumX;
    Extended  sumY;
@@ -337,140 +592,191 @@ void MakePol( Integer pntcnt,
    Pnt3D     V1;
    Pnt3D     V01;
    Pnt3D     NrmV01;
-   Integer   i;
+   Longint   i;
 
-/* Allocate memory for new polygon point record. */
+/* Make room for polygon in polygon list and its points in vertex store. */
 
-   newPtr = (PolPtr)malloc(sizeof(PolRec));
+   if ( ! GrowPol(polcnt + 1) ) return;
+   if ( ! GrowVtx(vtxlist.Cnt + pntcnt) ) return;
 
 /* Increment polygon counter. */
 
    polcnt = polcnt + 1;
 
 #if DBG_LVL > 0
-   printf("MakePol:  polcnt = %d\n", polcnt);
+   printf("MakePol:  polcnt = %ld\n", polcnt);
 #endif
 
 /* Initialize polygon list entry. */
 
-   pollist[polcnt].Flg = FALSE;
-   pollist[polcnt].Pri = thePri*100000000;
-   pollist[polcnt].Pat = thePat;
-   pollist[polcnt].Typ = theTyp;
-   pollist[polcnt].Vis = theVis;
-   pollist[polcnt].Ptr = newPtr;
-
-/* Initialize first polygon point record. */
-
-   newPtr->Nxt   = NULL;
-   newPtr->Pt0.X = pntlist[1].X + offset.X;
-   newPtr->Pt0.Y = pntlist[1].Y + offset.Y;
-   newPtr->Pt0.Z = pntlist[1].Z + offset.Z;
-   newPtr->Pt1.X = newPtr->Pt0.X;
-   newPtr->Pt1.Y = newPtr->Pt0.Y;
-   newPtr->Pt1.Z = newPtr->Pt0.Z;
-   newPtr->Pt2.X = fZero;
-   newPtr->Pt2.Y = fZero;
-   newPtr->Pt2.Z = fZero;
-
-#if DBG_LVL > 2
-   printf("MakePol:   vertice # %d =  %f  %f  %f\n",1,newPtr->Pt0.X,
-                                                      newPtr->Pt0.Y,
-                                                      newPtr->Pt0.Z);
-#endif
+   pollist[polcnt].Flg  = FALSE;
+   pollist[polcnt].Pri  = thePri*100000000;
+   pollist[polcnt].Pat  = thePat;
+   pollist[polcnt].Typ  = theTyp;
+   pollist[polcnt].Vis  = theVis;
+   pollist[polcnt].Voff = vtxlist.Cnt;
+   pollist[polcnt].Vcnt = pntcnt;
 
 /* Initialize polygon centroid summation variables. */
 
-   sumP = fOne;
-   sumX = newPtr->Pt0.X;
-   sumY = newPtr->Pt0.Y;
-   sumZ = newPtr->Pt0.Z;
-
-/* Initialize polygon point record for each additional point. */
-
-   i = 2;
-   do {
-/*--- Save current polygon point record pointer. */
-      oldPtr = newPtr;
-/*--- Allocate next polygon point record. */
-      newPtr = (PolPtr)malloc(sizeof(PolRec));
-/*--- Link last polygon record to new record. */
-      oldPtr->Nxt = newPtr;
-/*--- Initialize new polygon point record. */
-      newPtr->Nxt   = NULL;
-      newPtr->Pt0.X = pntlist[i].X + offset.X;
-      newPtr->Pt0.Y = pntlist[i].Y + offset.Y;
-      newPtr->Pt0.Z = pntlist[i].Z + offset.Z;
-      newPtr->Pt1.X = newPtr->Pt0.X;
-      newPtr->Pt1.Y = newPtr->Pt0.Y;
-      newPtr->Pt1.Z = newPtr->Pt0.Z;
-      newPtr->Pt2.X = fZero;
-      newPtr->Pt2.Y = fZero;
-      newPtr->Pt2.Z = fZero;
+   sumP = fZero;
+   sumX = fZero;
+   sumY = fZero;
+   sumZ = fZero;
+
+/* Store each polygon point in vertex store. */
+
+   j = vtxlist.Cnt;
+   for ( i = 1 ; i <= pntcnt ; i++ ) {
+      vtxlist.X0[j] = pntlist[i].X + offset.X;
+      vtxlist.Y0[j] = pntlist[i].Y + offset.Y;
+      vtxlist.Z0[j] = pntlist[i].Z + offset.Z;
+      vtxlist.X1[j] = vtxlist.X0[j];
+      vtxlist.Y1[j] = vtxlist.Y0[j];
+      vtxlist.Z1[j] = vtxlist.Z0[j];
+      vtxlist.X2[j] = fZero;
+      vtxlist.Y2[j] = fZero;
+      vtxlist.Z2[j] = fZero;
 #if DBG_LVL > 2
-      printf("MakePol:   vertice # %d =  %f  %f  %f\n",i,newPtr->Pt0.X,
-                                                         newPtr->Pt0.Y,
-                                                         newPtr->Pt0.Z);
+      printf("MakePol:   vertice # %ld =  %f  %f  %f\n",i,vtxlist.X0[j],
+                                                         vtxlist.Y0[j],
+                                                         vtxlist.Z0[j]);
 #endif
 
 /*--- Increment polygon centroid summation variables. */
       sumP = sumP + fOne;
-      sumX = sumX + newPtr->Pt0.X;
-      sumY = sumY + newPtr->Pt0.Y;
-      sumZ = sumZ + newPtr->Pt0.Z;
-/*--- Increment polygon point counter. */
-      i = i + 1;
-   } while ( i <= pntcnt );
+      sumX = sumX + vtxlist.X0[j];
+      sumY = sumY + vtxlist.Y0[j];
+      sumZ = sumZ + vtxlist.Z0[j];
+      j    = j + 1;
+   }
+   vtxlist.Cnt = j;
 
 /* Calculate polygon centroid. */
 
-   pollist[polcnt].Cnt0.X = sumX/sumP;
-   pollist[polcnt].Cnt0.Y = sumY/sumP;
-   pollist[polcnt].Cnt0.Z = sumZ/sumP;
-   pollist[polcnt].Cnt1.X = sumX/sumP;
-   pollist[polcnt].Cnt1.Y = sumY/sumP;
-   pollist[polcnt].Cnt1.Z = sumZ/sumP;
+   ctrlist.CX0[polcnt] = sumX/sumP;
+   ctrlist.CY0[polcnt] = sumY/sumP;
+   ctrlist.CZ0[polcnt] = sumZ/sumP;
+   ctrlist.CX1[polcnt] = sumX/sumP;
+   ctrlist.CY1[polcnt] = sumY/sumP;
+   ctrlist.CZ1[polcnt] = sumZ/sumP;
 #if DBG_LVL > 2
-   printf("MakePol:  centroid 0 =  %f  %f  %f\n",pollist[polcnt].Cnt0.X,
-         pollist[polcnt].Cnt0.Y,
-         pollist[polcnt].Cnt0.Z);
-   printf("MakePol:  centroid 1 =  %f  %f  %f\n",pollist[polcnt].Cnt1.X,
-         pollist[polcnt].Cnt1.Y,
-         pollist[polcnt].Cnt1.Z);
+   printf("MakePol:  centroid 0 =  %f  %f  %f\n",ctrlist.CX0[polcnt],
+         ctrlist.CY0[polcnt],
+         ctrlist.CZ0[polcnt]);
+   printf("MakePol:  centroid 1 =  %f  %f  %f\n",ctrlist.CX1[polcnt],
+         ctrlist.CY1[polcnt],
+         ctrlist.CZ1[polcnt]);
 #endif
 
 /* Calculate polygon normal assuming traversal from point 0 
    to point 1 is in a counterclockwise direction.
 */
-   aPolRec = pollist[polcnt].Ptr;
-   V0.X = aPolRec->Pt0.X - pollist[polcnt].Cnt0.X;
-   V0.Y = aPolRec->Pt0.Y - pollist[polcnt].Cnt0.Y;
-   V0.Z = aPolRec->Pt0.Z - pollist[polcnt].Cnt0.Z;
-   aPolRec = aPolRec->Nxt;
-   V1.X = aPolRec->Pt0.X - pollist[polcnt].Cnt0.X;
-   V1.Y = aPolRec->Pt0.Y - pollist[polcnt].Cnt0.Y;
-   V1.Z = aPolRec->Pt0.Z - pollist[polcnt].Cnt0.Z;
+   j = pollist[polcnt].Voff;
+   V0.X = vtxlist.X0[j] - ctrlist.CX0[polcnt];
+   V0.Y = vtxlist.Y0[j] - ctrlist.CY0[polcnt];
+   V0.Z = vtxlist.Z0[j] - ctrlist.CZ0[polcnt];
+   j = j + 1;
+   V1.X = vtxlist.X0[j] - ctrlist.CX0[polcnt];
+   V1.Y = vtxlist.Y0[j] - ctrlist.CY0[polcnt];
+   V1.Z = vtxlist.Z0[j] - ctrlist.CZ0[polcnt];
 
    V01    = CrossP3D(V0, V1);
    NrmV01 = NrmP3D(V01);
 
-   pollist[polcnt].Nrm0.X = NrmV01.X;
-   pollist[polcnt].Nrm0.Y = NrmV01.Y;
-   pollist[polcnt].Nrm0.Z = NrmV01.Z;
-   pollist[polcnt].Nrm1.X = NrmV01.X;
-   pollist[polcnt].Nrm1.Y = NrmV01.Y;
-   pollist[polcnt].Nrm1.Z = NrmV01.Z;
+   ctrlist.NX0[polcnt] = NrmV01.X;
+   ctrlist.NY0[polcnt] = NrmV01.Y;
+   ctrlist.NZ0[polcnt] = NrmV01.Z;
+   ctrlist.NX1[polcnt] = NrmV01.X;
+   ctrlist.NY1[polcnt] = NrmV01.Y;
+   ctrlist.NZ1[polcnt] = NrmV01.Z;
 
 #if DBG_LVL > 2
-printf("MakePol:  normal 0 =  %f  %f  %f\n",pollist[polcnt].Nrm0.X,
-      pollist[polcnt].Nrm0.Y,
-      pollist[polcnt].Nrm0.Z);
-printf("MakePol:  normal 1 =  %f  %f  %f\n",pollist[polcnt].Nrm1.X,
-      pollist[polcnt].Nrm1.Y,
-      pollist[polcnt].Nrm1.Z);
+printf("MakePol:  normal 0 =  %f  %f  %f\n",ctrlist.NX0[polcnt],
+      ctrlist.NY0[polcnt],
+      ctrlist.NZ0[polcnt]);
+printf("MakePol:  normal 1 =  %f  %f  %f\n",ctrlist.NX1[polcnt],
+      ctrlist.NY1[polcnt],
+      ctrlist.NZ1[polcnt]);
 #endif
 }
 
+/*
+ * MAKES OBJECTS FROM RUNS OF SAME TYPE POLYGONS iPol1 THRU iPol2
+ * LOADED FROM ONE POLYGON FILE; POLYGON 1, THE GROUND PLANE DRAWN
+ * BEFORE ALL OTHERS, IS KEPT AS AN OBJECT BY ITSELF
+*/
+void MakeObj( Longint iPol1, Longint iPol2 )
+{
+   Obj3D     *obj;
+   Extended   xmin, xmax, ymin, ymax, zmin, zmax;
+   Extended   dx, dy, dz, rsq;
+   Longint    j, jbeg, jend;
+   Longint    iPol, iRun;
+   Longint    max;
+
+   iPol = iPol1;
+   while ( iPol <= iPol2 )
+   {
+      iRun = iPol;
+      while ( ( iRun < iPol2 ) && ( iRun > 1 ) &&
+              ( pollist[iRun+1].Typ == pollist[iPol].Typ ) ) {
+         iRun = iRun + 1;
+      }
+      max = objmax;
+      if ( ( ! GrowList((void **)&objord, &max, objcnt+1,
+                        sizeof(Longint), maxobj) ) ||
+           ( ! GrowList((void **)&objlist, &objmax, objcnt+1,
+                        sizeof(Obj3D), maxobj) ) ) {
+         printf("MakeObj:  polygons %ld-%ld ignored.\n",iPol,iPol2);
+         vtxlist.Cnt = pollist[iPol].Voff;
+         polcnt      = iPol - 1;
+         return;
+      }
+      obj       = &objlist[objcnt];
+      obj->Typ  = pollist[iPol].Typ;
+      obj->Pol1 = iPol;
+      obj->Pol2 = iRun;
+      obj->Pri  = pollist[iPol].Pri;
+      obj->Grp  = 0;
+      obj->Mov  = FALSE;
+      obj->Cul  = FALSE;
+      for ( ; iPol <= iRun ; iPol++ ) {
+         pollist[iPol].Obj = objcnt;
+         if ( pollist[iPol].Pri != obj->Pri ) obj->Pri = -1;
+      }
+
+/*--- Bound object vertice by sphere centered on their extents. */
+      jbeg = pollist[obj->Pol1].Voff;
+      jend = pollist[obj->Pol2].Voff + pollist[obj->Pol2].Vcnt;
+      xmin = xmax = vtxlist.X0[jbeg];
+      ymin = ymax = vtxlist.Y0[jbeg];
+      zmin = zmax = vtxlist.Z0[jbeg];
+      for ( j = jbeg+1 ; j < jend ; j++ ) {
+         xmin = dmin(xmin, vtxlist.X0[j]);  xmax = dmax(xmax, vtxlist.X0[j]);
+         ymin = dmin(ymin, vtxlist.Y0[j]);  ymax = dmax(ymax, vtxlist.Y0[j]);
+         zmin = dmin(zmin, vtxlist.Z0[j]);  zmax = dmax(zmax, vtxlist.Z0[j]);
+      }
+      obj->Cen0.X = fHalf*(xmin + xmax);
+      obj->Cen0.Y = fHalf*(ymin + ymax);
+      obj->Cen0.Z = fHalf*(zmin + zmax);
+      obj->Cen1   = obj->Cen0;
+      rsq         = fZero;
+      for ( j = jbeg ; j < jend ; j++ ) {
+         dx  = vtxlist.X0[j] - obj->Cen0.X;
+         dy  = vtxlist.Y0[j] - obj->Cen0.Y;
+         dz  = vtxlist.Z0[j] - obj->Cen0.Z;
+         rsq = dmax(rsq, dx*dx + dy*dy + dz*dz);
+      }
+      obj->Rad = sqrt(rsq);
+#if DBG_LVL > 0
+      printf("MakeObj:  object %ld type %d polygons %ld-%ld radius %f\n",
+             objcnt,obj->Typ,obj->Pol1,obj->Pol2,obj->Rad);
+#endif
+      objcnt = objcnt + 1;
+   }
+}
+
 /*
  * COMPUTE WORLD SPACE TO VIEW SPACE TRANSFORMATION MATRIX
 */
@@ -585,316 +891,854 @@ void XfrmGrid ()
 }
 
 /*
- * TRANSFORMS POLYGON WORLD SPACE COORDINATES TO VIEWPORT COORDINATES
+ * TRANSFORMS WORLD SPACE COORDINATES OF POLYGONS iPol1 THRU iPol2 TO
+ * VIEWPORT COORDINATES AND ENQUEUES THOSE VISIBLE FOR DRAWING
 */
-void XfrmPoly ( Integer iPol )
+void XfrmPolys ( Longint iPol1, Longint iPol2 )
 {
-   PolPtr       aPolRec;
-   Extended     eye1x, eye1y, eye1z;
-   Extended     eye2x, eye2y, eye2z;
-   Pnt3D        nrm1;
-   Extended     nrm2x, nrm2y, nrm2z;
+   Extended     mv[9];
+   Extended     fv[3];
+   Extended     sv[3];
+   Extended     ones[3];
+   Extended     zeros[3];
    Extended     dotp;
-   Extended     xd, yd, zd;
-   Extended     xs, ys, zs;
    Extended     rs;
    Extended     rsmm;
    Longint      irsmm;
    Longint      pcode;
+   Longint      j, jbeg, jend;
+   Longint      iPol, npol;
    HeapElement  anElement;
    Boolean      inflag;
 
-#if DBG_LVL > 3
-   printf("  Polygon # %d\n",iPol);
-#endif
+   npol = iPol2 - iPol1 + 1;
+   if ( npol <= 0 ) return;
 
-   /* Compute eye vector to polygon centroid in viewport. */
-
-   eye1x = pollist[iPol].Cnt1.X - fovpt.X;
-   eye1y = pollist[iPol].Cnt1.Y - fovpt.Y;
-   eye1z = pollist[iPol].Cnt1.Z - fovpt.Z;
-   eye2x = dcx1*eye1x + dcy1*eye1y + dcz1*eye1z;
-   eye2y = dcx2*eye1x + dcy2*eye1y + dcz2*eye1z;
-   eye2z = dcx3*eye1x + dcy3*eye1y + dcz3*eye1z;
-
-   /* Check if polygon surface is visible. */
-
-   if ( pollist[iPol].Vis == 2 ) {
-      nrm1  = pollist[iPol].Nrm1;
-      nrm2x = dcx1*nrm1.X + dcy1*nrm1.Y + dcz1*nrm1.Z;
-      nrm2y = dcx2*nrm1.X + dcy2*nrm1.Y + dcz2*nrm1.Z;
-      nrm2z = dcx3*nrm1.X + dcy3*nrm1.Y + dcz3*nrm1.Z;
-      dotp  = nrm2x*eye2x + nrm2y*eye2y + nrm2z*eye2z;
-      if (dotp > 0.0) {
-         pollist[iPol].Flg = FALSE;
-         return;
-      }
-   }
+   mv[0] = dcx1;    mv[1] = dcy1;     mv[2] = dcz1;
+   mv[3] = dcx2;    mv[4] = dcy2;     mv[5] = dcz2;
+   mv[6] = dcx3;    mv[7] = dcy3;     mv[8] = dcz3;
+   fv[0] = fovpt.X; fv[1] = fovpt.Y;  fv[2] = fovpt.Z;
+   sv[0] = fOne;    sv[1] = sfacyAR;  sv[2] = sfacz;  // account for square clipping frustum base of fovs pixels
+   ones[0]  = fOne;  ones[1]  = fOne;  ones[2]  = fOne;
+   zeros[0] = fZero; zeros[1] = fZero; zeros[2] = fZero;
+
+   /* Compute eye vectors to polygon centroids in viewport. */
+
+   XfrmView(npol, ctrlist.CX1+iPol1, ctrlist.CY1+iPol1, ctrlist.CZ1+iPol1,
+                  ctrlist.CX2+iPol1, ctrlist.CY2+iPol1, ctrlist.CZ2+iPol1,
+                  mv, fv, ones);
 
-   /* Compute screen coordinates for polygon vertice. */
+   /* Rotate polygon normals into viewport. */
 
-   inflag  = FALSE;
-   pcode   = pollist[iPol].Pri;
-   aPolRec = pollist[iPol].Ptr;
+   XfrmView(npol, ctrlist.NX1+iPol1, ctrlist.NY1+iPol1, ctrlist.NZ1+iPol1,
+                  ctrlist.NX2+iPol1, ctrlist.NY2+iPol1, ctrlist.NZ2+iPol1,
+                  mv, zeros, ones);
 
-   while ( aPolRec != NULL )
+   /* Translate polygon vertice into viewport FOV reference frame,
+      rotate into viewport reference frame and scale.
+   */
+   jbeg = pollist[iPol1].Voff;
+   jend = pollist[iPol2].Voff + pollist[iPol2].Vcnt;
+   XfrmView(jend-jbeg, vtxlist.X1+jbeg, vtxlist.Y1+jbeg, vtxlist.Z1+jbeg,
+                       vtxlist.X2+jbeg, vtxlist.Y2+jbeg, vtxlist.Z2+jbeg,
+                       mv, fv, sv);
+
+   for ( iPol = iPol1 ; iPol <= iPol2 ; iPol++ )
    {
-#if DBG_LVL > 4
-      printf("    - 1 vertice  :  %f  %f  %f\n",aPolRec->Pt1.X,
-                                                aPolRec->Pt1.Y,
-                                                aPolRec->Pt1.Z);
+#if DBG_LVL > 3
+      printf("  Polygon # %ld\n",iPol);
 #endif
-/*--- TRANSLATE COORDINATES INTO VIEWPORT FOV REFERENCE FRAME */
-      xd = aPolRec->Pt1.X - fovpt.X;
-      yd = aPolRec->Pt1.Y - fovpt.Y;
-      zd = aPolRec->Pt1.Z - fovpt.Z;
-/*--- ROTATE COORDINATES INTO VIEWPORT REFERENCE FRAME AND SCALE */
-      xs = dcx1*xd + dcy1*yd + dcz1*zd;
-      ys = dcx2*xd + dcy2*yd + dcz2*zd;
-      zs = dcx3*xd + dcy3*yd + dcz3*zd;
-      xs = xs;
-      ys = ys*sfacyAR;  // account for square clipping frustum base of fovs pixels
-      zs = zs*sfacz;
-/*--- SAVE SCALED VIEWPORT COORDINATES */
-      aPolRec->Pt2.X = xs;
-      aPolRec->Pt2.Y = ys;
-      aPolRec->Pt2.Z = zs;
+
+      /* Check if polygon surface is visible. */
+
+      if ( pollist[iPol].Vis == 2 ) {
+         dotp = ctrlist.NX2[iPol]*ctrlist.CX2[iPol]
+              + ctrlist.NY2[iPol]*ctrlist.CY2[iPol]
+              + ctrlist.NZ2[iPol]*ctrlist.CZ2[iPol];
+         if (dotp > 0.0) {
+            pollist[iPol].Flg = FALSE;
+            continue;
+         }
+      }
+
+      /* Check if any polygon vertice is in front of view point. */
+
+      inflag = FALSE;
+      pcode  = pollist[iPol].Pri;
+      jend   = pollist[iPol].Voff + pollist[iPol].Vcnt;
+      for ( j = pollist[iPol].Voff ; j < jend ; j++ )
+      {
 #if DBG_LVL > 4
-      printf("    - 2 vertice  :  %f  %f  %f\n",aPolRec->Pt2.X,
-                                                aPolRec->Pt2.Y,
-                                                aPolRec->Pt2.Z);
+         printf("    - 1 vertice  :  %f  %f  %f\n",vtxlist.X1[j],
+                                                   vtxlist.Y1[j],
+                                                   vtxlist.Z1[j]);
+         printf("    - 2 vertice  :  %f  %f  %f\n",vtxlist.X2[j],
+                                                   vtxlist.Y2[j],
+                                                   vtxlist.Z2[j]);
 #endif
-      aPolRec = aPolRec->Nxt;
-/*--- CHECK IF POINT IS IN FRONT OF VIEW POINT */
-      if ( xs >= fZero )
-      {
-         inflag = TRUE;
+         if ( vtxlist.X2[j] >= fZero )
+         {
+            inflag = TRUE;
+         }
       }
-   }
 
-   /* Enque polygon if at least one vertice is in the viewport. */
+      /* Enque polygon if at least one vertice is in the viewport. */
 
-   if ( ( inflag ) && ( ! FullPQ(polPQ) ) )
-   {
-      rs    = sqrt(eye2x*eye2x+ eye2y*eye2y + eye2z*eye2z);
-      rsmm  = rs*f1K;
-      irsmm = lroundd(rsmm);
-      anElement.Key  = pcode + irsmm;
-      anElement.Info = iPol;
+      if ( inflag )
+      {
+         rs    = sqrt(ctrlist.CX2[iPol]*ctrlist.CX2[iPol] +
+                      ctrlist.CY2[iPol]*ctrlist.CY2[iPol] +
+                      ctrlist.CZ2[iPol]*ctrlist.CZ2[iPol]);
+         rsmm  = rs*f1K;
+         irsmm = lroundd(rsmm);
+         anElement.Key  = pcode + irsmm;
+         anElement.Info = iPol;
 #if DBG_LVL > 3
-      printf("    - element:  %ld  %hd  %hd  %hd  %ld  %f  %f  %f  %f  %ld\n",
-               anElement.Key,
-                  anElement.Info,
-                        pollist[iPol].Typ,
-                              pollist[iPol].Vis,
-                                 pollist[iPol].Pri,
-                                    eye2x, eye2y, eye2z, rsmm, irsmm);
+         printf("    - element:  %ld  %ld  %hd  %hd  %ld  %f  %f  %f  %f  %ld\n",
+                  anElement.Key,
+                     anElement.Info,
+                           pollist[iPol].Typ,
+                                 pollist[iPol].Vis,
+                                    pollist[iPol].Pri,
+                                       ctrlist.CX2[iPol], ctrlist.CY2[iPol],
+                                       ctrlist.CZ2[iPol], rsmm, irsmm);
 #endif
-      PriorityEnq(&polPQ,anElement);
-      if ( irsmm < 0L ) {
-         printf("*** XfrmPoly:  lroundd(rsmm) < 0 for iPol=%hd\n",iPol);
-         quitflag = TRUE;
+         if ( ! SortAdd(&polSL,anElement,objlist[pollist[iPol].Obj].Grp) ) {
+            printf("*** XfrmPolys:  cannot queue polygon %ld\n",iPol);
+            quitflag = TRUE;
+         }
+         if ( irsmm < 0L ) {
+            printf("*** XfrmPolys:  lroundd(rsmm) < 0 for iPol=%ld\n",iPol);
+            quitflag = TRUE;
+         }
       }
+      pollist[iPol].Flg = inflag;
    }
-   pollist[iPol].Flg = inflag;
 }
 
 /*
- * MOVES POLYGONS IN WORLD SPACE
+ * TRANSFORMS POLYGONS OF OBJECTS NOT CULLED FROM THE VIEWING FRUSTUM
+ * TO VIEWPORT COORDINATES AND ENQUEUES THOSE VISIBLE FOR DRAWING; THE
+ * GROUND PLANE POLYGON IS LEFT TO BE TRANSFORMED BY ITSELF
 */
-void MovePoly ( Integer iPol, Extended px, Extended py, Extended pz )
+void XfrmObjects( void )
 {
-   PolPtr    aPolRec;
-   Extended  xb, yb, zb;
-   Pnt3D     V0;
-   Pnt3D     V1;
-   Pnt3D     V01;
-   Pnt3D     NrmV01;
+   Longint  iObj;
 
-   /* Move the polygon centroid.
+   for ( iObj = 0 ; iObj < objcnt ; iObj++ )
+   {
+      if ( ( objlist[iObj].Pol2 < 2 ) || ( objlist[iObj].Cul ) ) continue;
+      XfrmPolys(lmax(objlist[iObj].Pol1,2), objlist[iObj].Pol2);
+   }
+}
+
+/*
+ * PLACES BOUNDING SPHERES OF OBJECTS OF GIVEN TYPE IN WORLD SPACE
+ * AND KEEPS THEIR MODEL TO WORLD SPACE TRANSFORMATION FOR MoveObjects
+*/
+void PlaceObject ( Integer theTyp, Extended px, Extended py, Extended pz )
+{
+   Obj3D     *obj;
+   Extended   xb, yb, zb;
+   Longint    iObj;
+
+   for ( iObj = 0 ; iObj < objcnt ; iObj++ )
+   {
+      obj = &objlist[iObj];
+      if ( obj->Typ != theTyp ) continue;
+      obj->Mw[0] = dcx1; obj->Mw[1] = dcx2; obj->Mw[2] = dcx3;
+      obj->Mw[3] = dcy1; obj->Mw[4] = dcy2; obj->Mw[5] = dcy3;
+      obj->Mw[6] = dcz1; obj->Mw[7] = dcz2; obj->Mw[8] = dcz3;
+      obj->Tw[0] = px;   obj->Tw[1] = py;   obj->Tw[2] = pz;
+      obj->Mov   = TRUE;
+      xb         = obj->Cen0.X;
+      yb         = obj->Cen0.Y;
+      zb         = obj->Cen0.Z;
+      obj->Cen1.X = dcx1*xb + dcx2*yb + dcx3*zb + px;
+      obj->Cen1.Y = dcy1*xb + dcy2*yb + dcy3*zb + py;
+      obj->Cen1.Z = dcz1*xb + dcz2*yb + dcz3*zb + pz;
+   }
+}
+
+/*
+ * MOVES POLYGONS OF PLACED OBJECTS NOT CULLED FROM THE VIEWING FRUSTUM
+ * IN WORLD SPACE
+*/
+void MoveObjects( void )
+{
+   Obj3D     *obj;
+   Extended   zeros[3];
+   Longint    jbeg, jend;
+   Longint    iPol1, iPol2;
+   Longint    iObj;
+
+   zeros[0] = fZero; zeros[1] = fZero; zeros[2] = fZero;
+
+   /* Move the polygons of each object as a batch of centroids, normals
+      and vertice.
    */
-   xb                   = pollist[iPol].Cnt0.X;
-   yb                   = pollist[iPol].Cnt0.Y;
-   zb                   = pollist[iPol].Cnt0.Z;
-   pollist[iPol].Cnt1.X = dcx1*xb + dcx2*yb + dcx3*zb + px;
-   pollist[iPol].Cnt1.Y = dcy1*xb + dcy2*yb + dcy3*zb + py;
-   pollist[iPol].Cnt1.Z = dcz1*xb + dcz2*yb + dcz3*zb + pz;
+   for ( iObj = 0 ; iObj < objcnt ; iObj++ )
+   {
+      obj = &objlist[iObj];
+      if ( ( ! obj->Mov ) || ( obj->Cul ) ) continue;
+      iPol1 = obj->Pol1;
+      iPol2 = obj->Pol2;
+
+/*--- MOVE POLYGON CENTROIDS */
+      XfrmMove(iPol2-iPol1+1,
+               ctrlist.CX0+iPol1, ctrlist.CY0+iPol1, ctrlist.CZ0+iPol1,
+               ctrlist.CX1+iPol1, ctrlist.CY1+iPol1, ctrlist.CZ1+iPol1,
+               obj->Mw, obj->Tw);
+/*--- ROTATE POLYGON NORMALS */
+      XfrmMove(iPol2-iPol1+1,
+               ctrlist.NX0+iPol1, ctrlist.NY0+iPol1, ctrlist.NZ0+iPol1,
+               ctrlist.NX1+iPol1, ctrlist.NY1+iPol1, ctrlist.NZ1+iPol1,
+               obj->Mw, zeros);
+/*--- MOVE POLYGON VERTICE */
+      jbeg = pollist[iPol1].Voff;
+      jend = pollist[iPol2].Voff + pollist[iPol2].Vcnt;
+      XfrmMove(jend-jbeg,
+               vtxlist.X0+jbeg, vtxlist.Y0+jbeg, vtxlist.Z0+jbeg,
+               vtxlist.X1+jbeg, vtxlist.Y1+jbeg, vtxlist.Z1+jbeg,
+               obj->Mw, obj->Tw);
+
 #if DBG_LVL > 3
-   printf("  Polygon # %d\n",iPol);
-   printf("    - centroid :  %f  %f  %f\n",pollist[iPol].Cnt1.X,
-                                           pollist[iPol].Cnt1.Y,
-                                           pollist[iPol].Cnt1.Z);
+      for ( ; iPol1 <= iPol2 ; iPol1++ ) {
+         printf("  Polygon # %ld\n",iPol1);
+         printf("    - centroid :  %f  %f  %f\n",ctrlist.CX1[iPol1],
+                                                 ctrlist.CY1[iPol1],
+                                                 ctrlist.CZ1[iPol1]);
+      }
 #endif
+   }
+}
 
-   /* Move the polygon vertice.
-   */
-   aPolRec = pollist[iPol].Ptr;
-   while ( aPolRec != NULL )
+/*
+ * COMPARES OBJECTS FOR ORDER OF DECREASING PRIORITY, THEN DECREASING
+ * FAR SIDE DEPTH, THEN INCREASING OBJECT NUMBER
+*/
+static int ObjectCmp( const void *a, const void *b )
+{
+   Obj3D  *oa = &objlist[*(const Longint *)a];
+   Obj3D  *ob = &objlist[*(const Longint *)b];
+
+   if ( oa->Pri != ob->Pri ) return ( oa->Pri > ob->Pri ) ? -1 : 1;
+   if ( oa->Far != ob->Far ) return ( oa->Far > ob->Far ) ? -1 : 1;
+   if ( *(const Longint *)a != *(const Longint *)b ) {
+      return ( *(const Longint *)a < *(const Longint *)b ) ? -1 : 1;
+   }
+   return 0;
+}
+
+/*
+ * ORDERS OBJECTS BY DEPTH OF THEIR BOUNDING SPHERES FROM THE FOV
+ * POSITION AND ASSIGNS EACH OBJECT THE DRAWING RANK OF ITS CLUSTER
+ * OF OBJECTS OVERLAPPING IN DEPTH
+*/
+void OrderObjects( void )
+{
+   Obj3D     *obj;
+   Extended   dx, dy, dz, rs;
+   Extended   cnear;
+   Longint    cpri;
+   Longint    i, k, n;
+   Boolean    mixed;
+
+/* Find depth range of each object holding depth sorted polygons. */
+
+   n     = 0;
+   mixed = FALSE;
+   for ( i = 0 ; i < objcnt ; i++ )
    {
-      xb             = aPolRec->Pt0.X;
-      yb             = aPolRec->Pt0.Y;
-      zb             = aPolRec->Pt0.Z;
-      aPolRec->Pt1.X = dcx1*xb + dcx2*yb + dcx3*zb + px;
-      aPolRec->Pt1.Y = dcy1*xb + dcy2*yb + dcy3*zb + py;
-      aPolRec->Pt1.Z = dcz1*xb + dcz2*yb + dcz3*zb + pz;
+      obj      = &objlist[i];
+      obj->Grp = 0;
+      if ( ( obj->Pol2 < 2 ) || ( obj->Cul ) ) continue;
+      dx        = obj->Cen1.X - fovpt.X;
+      dy        = obj->Cen1.Y - fovpt.Y;
+      dz        = obj->Cen1.Z - fovpt.Z;
+      rs        = sqrt(dx*dx + dy*dy + dz*dz);
+      obj->Near = rs - obj->Rad;
+      obj->Far  = rs + obj->Rad;
+      if ( obj->Pri < 0 ) mixed = TRUE;
+      objord[n] = i;
+      n = n + 1;
+   }
+   qsort(objord, n, sizeof(Longint), ObjectCmp);
+
+/* Cluster objects of equal priority whose depth ranges overlap, with
+   a centimeter margin so polygon keys rounded to millimeters never
+   interleave across clusters.  Polygons of any mixed priority object
+   are ordered by key together with all others in one cluster.
+*/
+   grpcnt = ( n > 0 ) ? 1 : 0;
+   if ( ( mixed ) || ( n == 0 ) ) return;
+
+   obj   = &objlist[objord[0]];
+   cpri  = obj->Pri;
+   cnear = obj->Near;
+   for ( k = 1 ; k < n ; k++ )
+   {
+      obj = &objlist[objord[k]];
+      if ( ( obj->Pri != cpri ) || ( obj->Far < cnear - 0.01 ) ) {
+         grpcnt = grpcnt + 1;
+         cpri   = obj->Pri;
+         cnear  = obj->Near;
+      } else {
+         cnear  = dmin(cnear, obj->Near);
+      }
+      obj->Grp = grpcnt - 1;
 #if DBG_LVL > 3
-      printf("    - vertice :  %f  %f  %f\n",aPolRec->Pt1.X,
-                                             aPolRec->Pt1.Y,
-                                             aPolRec->Pt1.Z);
+      printf("OrderObjects:  object %ld near %f far %f cluster %ld\n",
+             objord[k],obj->Near,obj->Far,obj->Grp);
 #endif
-      aPolRec        = aPolRec->Nxt;
    }
+}
+
+/*
+ * RETURNS MONOTONIC CLOCK TIME (SEC)
+*/
+Extended RenSec( void )
+{
+   struct timespec  ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (Extended)ts.tv_sec + 1.0e-9*(Extended)ts.tv_nsec;
+}
 
-   /* Compute moved polygon normal assuming traversal from point 0 
-      to point 1 is in a counterclockwise direction.
+#include "cliplib.c"
+#include "fbuflib.c"
+#include "tilelib.c"
+#include "shmlib.c"
+#include "schdlib.c"
+#include "caplib.c"
+#include "strmlib.c"
+#include "txyzlib.c"
+#include "pipelib.c"
+#include "benchlib.c"
+#include "packlib.c"
+
+/*
+ * CULLS OBJECTS WHOSE BOUNDING SPHERES LIE ENTIRELY OUTSIDE THE VIEWING
+ * FRUSTUM OF cliplib.c, AS BOUNDED BY ITS SIDE PLANES AND ITS zmin AND
+ * zmax CLIPPING DISTANCES; THE FOV ROTATION MATRIX MUST BE CURRENT
+*/
+void CullObjects( void )
+{
+   Obj3D     *obj;
+   Extended   dx, dy, dz;
+   Extended   xs, ys, zs;
+   Extended   ny, nz, rad;
+
+   /* Side planes |ys*sfacyAR| = xs and |zs*sfacz| = xs of the scaled
+      frustum are tested in unscaled view space, where their distances
+      from a point are normalized by the plane normal magnitudes.  A
+      micrometer margin keeps round off from culling a sphere whose
+      polygons just touch the frustum.
    */
-   aPolRec = pollist[iPol].Ptr;
-   V0.X = aPolRec->Pt1.X - pollist[iPol].Cnt1.X;
-   V0.Y = aPolRec->Pt1.Y - pollist[iPol].Cnt1.Y;
-   V0.Z = aPolRec->Pt1.Z - pollist[iPol].Cnt1.Z;
-   aPolRec = aPolRec->Nxt;
-   V1.X = aPolRec->Pt1.X - pollist[iPol].Cnt1.X;
-   V1.Y = aPolRec->Pt1.Y - pollist[iPol].Cnt1.Y;
-   V1.Z = aPolRec->Pt1.Z - pollist[iPol].Cnt1.Z;
-   
-   V01    = CrossP3D(V0, V1);
-   NrmV01 = NrmP3D(V01);
-   
-   pollist[iPol].Nrm1.X = NrmV01.X;
-   pollist[iPol].Nrm1.Y = NrmV01.Y;
-   pollist[iPol].Nrm1.Z = NrmV01.Z;
+   ny = sqrt(fOne + sfacyAR*sfacyAR);
+   nz = sqrt(fOne + sfacz*sfacz);
+
+   cullstat.Fobj = 0;
+   cullstat.Fpol = 0;
+   for ( obj = objlist ; obj < objlist + objcnt ; obj++ )
+   {
+      obj->Cul = FALSE;
+      if ( obj->Pol2 < 2 ) continue;
+      dx  = obj->Cen1.X - fovpt.X;
+      dy  = obj->Cen1.Y - fovpt.Y;
+      dz  = obj->Cen1.Z - fovpt.Z;
+      xs  = dcx1*dx + dcy1*dy + dcz1*dz;
+      ys  = dcx2*dx + dcy2*dy + dcz2*dz;
+      zs  = dcx3*dx + dcy3*dy + dcz3*dz;
+      rad = obj->Rad + 1.0e-6;
+      if ( ( xs + rad < zmin )                      ||
+           ( xs - rad > zmax )                      ||
+           ( ( sfacyAR*fabs(ys) - xs )/ny > rad )   ||
+           ( ( sfacz*fabs(zs) - xs )/nz > rad ) ) {
+         obj->Cul      = TRUE;
+         cullstat.Fobj = cullstat.Fobj + 1;
+         cullstat.Fpol = cullstat.Fpol + obj->Pol2 - lmax(obj->Pol1,2) + 1;
+      }
+      cullstat.Nobj = cullstat.Nobj + 1;
+   }
+   cullstat.Cobj = cullstat.Cobj + cullstat.Fobj;
+   cullstat.Cpol = cullstat.Cpol + cullstat.Fpol;
+   cullstat.Nfrm = cullstat.Nfrm + 1;
+#if DBG_LVL > 1
+   printf("CullObjects:  %ld objects and %ld polygons culled\n",
+          cullstat.Fobj,cullstat.Fpol);
+#endif
+}
+
+/*
+ * PRINTS OBJECT CULLING STATISTICS
+*/
+void CullReport( void )
+{
+   Longint  nfrm = ( cullstat.Nfrm > 0 ) ? cullstat.Nfrm : 1;
+
+   printf("CullReport:  %ld frames, %.2f objects tested per frame\n",
+          cullstat.Nfrm, (Extended)cullstat.Nobj/nfrm);
+   printf("CullReport:  %.2f objects and %.1f polygons culled per frame\n",
+          (Extended)cullstat.Cobj/nfrm, (Extended)cullstat.Cpol/nfrm);
+}
+
+/*
+ * PRINTS GROUND GRID DRAWING STATISTICS
+*/
+void GridReport( void )
+{
+   Longint  nfrm = ( frmcnt > 0 ) ? frmcnt : 1;
+
+   printf("GridReport:  %.1f segments clipped, %.1f drawn per frame\n",
+          (Extended)gridstat.Nseg/nfrm, (Extended)gridstat.Dseg/nfrm);
+   printf("GridReport:  %.2f drawing requests, %.3f ms per frame\n",
+          (Extended)gridstat.Nreq/nfrm, 1.0e3*gridstat.Sec/nfrm);
+}
+
+/*
+ * PRINTS SCENE SIZE AND FRAME TIMING STATISTICS
+*/
+void RenReport( void )
+{
+   Longint   nfrm = ( frmcnt > 0 ) ? frmcnt : 1;
+   Extended  tfrm = frmsec/nfrm;
+
+   printf("RenReport:  %ld polygons, %ld vertice, %ld objects\n",
+          polcnt, vtxlist.Cnt, objcnt);
+   printf("RenReport:  %ld frames, %.3f ms per frame, %.1f ns per polygon\n",
+          frmcnt, 1.0e3*tfrm, 1.0e9*tfrm/lmax(polcnt,1));
+}
+
+/* CLIENT-SIDE FRAMEBUFFERS FOR HEADLESS OR CLIENT RENDERING */
+
+FrmBuf  fbDrawn;
+FrmBuf  fbBlank;
+
+/*
+ * RENDERING PRIMITIVES ISSUED AS X11 REQUESTS OR RASTERIZED INTO THE
+ * CLIENT-SIDE DRAWN FRAMEBUFFER WHEN RENDERING HEADLESS (ren_MOD=1)
+ * OR FOR PRESENTATION TO A WINDOW (ren_MOD=2), EITHER DIRECTLY OR
+ * RECORDED FOR TILE-PARALLEL RASTERIZATION
+*/
+void RenSetForeground( Display *display, Word clr )
+{
+   if ( ren_MOD != 0 ) {
+      fbFgClr = (unsigned char)clr;
+   } else {
+      XSetForeground(display,the_GC,pixels[clr]);
+   }
+}
+
+void RenSetLineWidth( Display *display, Integer lw )
+{
+   if ( ren_MOD != 0 ) {
+      fbLinWid = lw;
+   } else {
+      XSetLineAttributes(display,the_GC,lw,LineSolid,CapButt,JoinMiter);
+   }
+}
+
+void RenFillPolygon( Display *display, Drawable drawable,
+                     XPoint *pts, Longint npts )
+{
+   if ( ren_MOD != 0 ) {
+      if ( tiles.Nthr > 0 ) TileFillPolygon(pts, npts);
+      else                  FbFillPolygon(&fbDrawn, pts, npts);
+   } else {
+      XFillPolygon(display, drawable, the_GC,
+                   pts, (int)npts, Convex, CoordModeOrigin);
+   }
+}
+
+void RenDrawLines( Display *display, Drawable drawable,
+                   XPoint *pts, Longint npts )
+{
+   if ( ren_MOD != 0 ) {
+      if ( tiles.Nthr > 0 ) TileDrawLines(pts, npts);
+      else                  FbDrawLines(&fbDrawn, pts, npts);
+   } else {
+      XDrawLines(display, drawable, the_GC, pts, (int)npts, CoordModeOrigin);
+   }
+}
+
+void RenDrawSegments( Display *display, Drawable drawable,
+                      XSegment *segs, Longint nsegs )
+{
+   if ( ren_MOD != 0 ) {
+      if ( tiles.Nthr > 0 ) TileDrawSegments(segs, nsegs);
+      else                  FbDrawSegments(&fbDrawn, segs, nsegs);
+   } else {
+      XDrawSegments(display, drawable, the_GC, segs, (int)nsegs);
+   }
+}
+
+void RenDrawRectangle( Display *display, Drawable drawable,
+                       Integer x, Integer y, Integer w, Integer h )
+{
+   if ( ren_MOD != 0 ) {
+      if ( tiles.Nthr > 0 ) TileDrawRectangle(x, y, w, h);
+      else                  FbDrawRectangle(&fbDrawn, x, y, w, h);
+   } else {
+      XDrawRectangle(display, drawable, the_GC, x, y, w, h);
+   }
+}
+
+void RenDrawImageString( Display *display, Drawable drawable,
+                         Integer x, Integer y, char *str, Integer len )
+{
+   if ( ren_MOD != 0 ) {
+      if ( tiles.Nthr > 0 ) TileDrawImageString(x, y, str, len);
+      else                  FbDrawImageString(&fbDrawn, x, y, str, len);
+   } else {
+      XDrawImageString(display, drawable, the_GC, x, y, str, len);
+   }
+}
+
+void RenClearDepth( void )
+{
+   if ( tiles.Nthr > 0 ) TileClearDepth();
+   else                  FbClearDepth(&fbDrawn);
+}
+
+/*
+ * COMPLETES RASTERIZATION OF PRIMITIVES RECORDED FOR TILES, UNLESS
+ * LEFT TO THE RASTER STAGE OF THE FRAME PIPELINE; RETURNS FALSE IF THE
+ * FRAME FAILED
+*/
+Boolean RenFlush( void )
+{
+   if ( ( tiles.Nthr > 0 ) && ! pip.On ) return TileFlush();
+   return TRUE;
+}
+
+/*
+ * ALLOCATES BACK BUFFER OF WINDOW, ONCE PER WINDOW, FROM THE DOUBLE
+ * BUFFER EXTENSION IF THE SERVER SUPPORTS IT FOR THE WINDOW VISUAL
+*/
+Boolean DbeCreate( Display *display, Window win )
+{
+   XWindowAttributes      attr;
+   XdbeScreenVisualInfo  *info;
+   VisualID               vid;
+   int                    major, minor;
+   int                    nscr = 1;
+   int                    i;
+   Boolean                found = FALSE;
+
+   if ( ( dbeBack != None ) && ( dbeWin == win ) ) return TRUE;
+   if ( ! XdbeQueryExtension(display, &major, &minor) ) return FALSE;
+
+   if ( ! XGetWindowAttributes(display, win, &attr) ) return FALSE;
+   vid  = XVisualIDFromVisual(attr.visual);
+   info = XdbeGetVisualInfo(display, &win, &nscr);
+   if ( info == NULL ) return FALSE;
+   for ( i = 0 ; i < info->count ; i++ ) {
+      if ( info->visinfo[i].visual == vid ) found = TRUE;
+   }
+   XdbeFreeVisualInfo(info);
+   if ( ! found ) return FALSE;
+
+/*--- SWAPS LEAVE THE BACK BUFFER CLEARED TO THE WINDOW BACKGROUND */
+   dbeBack = XdbeAllocateBackBufferName(display, win, XdbeBackground);
+   dbeWin  = win;
+#if DBG_LVL > 0
+   printf("DbeCreate:  DBE %d.%d back buffer %lu\n",major,minor,dbeBack);
+#endif
+   return ( dbeBack != None );
+}
+
+/*
+ * SWAPS BACK BUFFER TO WINDOW, LEAVING BACK BUFFER CLEARED
+*/
+void DbeSwap( Display *display )
+{
+   XdbeSwapInfo  swap;
+
+   swap.swap_window = dbeWin;
+   swap.swap_action = XdbeBackground;
+   XdbeSwapBuffers(display, &swap, 1);
+}
+
+/*
+ * SETS X SERVER PIXEL AND RGB VALUES OF PALETTE COLORS FOR WRITERS OF
+ * CAPTURED FRAMES
+*/
+void WritePalette( Widget w, Display *display, Colormap cmap )
+{
+   Arg            args[1];
+   Pixel          bkgpix;
+   XColor         xclr[fbNumClr];
+   unsigned long  pix[fbNumClr];
+   unsigned char  rgb[fbNumClr][3];
+   Integer        k;
+
+   XtSetArg(args[0], XtNbackground, &bkgpix);
+   XtGetValues(w, args, 1);
+   for ( k = 0 ; k < fbNumClr ; k++ ) {
+      xclr[k].pixel = ( k < fbBkgClr ) ? pixels[k] : bkgpix;
+   }
+   XQueryColors(display, cmap, xclr, fbNumClr);
+   for ( k = 0 ; k < fbNumClr ; k++ ) {
+      pix[k]    = xclr[k].pixel;
+      rgb[k][0] = (unsigned char)(xclr[k].red   >> 8);
+      rgb[k][1] = (unsigned char)(xclr[k].green >> 8);
+      rgb[k][2] = (unsigned char)(xclr[k].blue  >> 8);
+   }
+   CapPalette(pix, rgb);
+}
+
+/*
+ * WRITES DRAWN PIXMAP OR FRAMEBUFFER TO X11 PIXMAP (XPM) FILE, OR
+ * QUEUES IT FOR WRITER THREADS OR THE FRAME PIPELINE OUTPUT STAGE
+*/
+void WriteImage( Display *display, const char *fpath, Pixmap pixmap )
+{
+   XImage  *ximg;
+
+   if ( pip.On ) {
+      PipeWrite(fpath);
+   } else if ( ren_MOD != 0 ) {
+      if ( cap.Nthr > 0 ) CapPutFb(&fbDrawn, fpath);
+      else if ( ! FbWriteXPM(&fbDrawn, fpath) ) quitflag = TRUE;
+   } else if ( cap.Nthr > 0 ) {
+      ximg = XGetImage(display,pixmap,0,0,xMax,yMax,AllPlanes,ZPixmap);
+      if ( ximg != NULL ) CapPutImage(ximg, fpath);
+   } else {
+      TRACE_BEG(1,"XpmWriteFileFromPixmap");
+      XpmWriteFileFromPixmap(display, (char *)fpath, pixmap, None, NULL);
+      TRACE_END(1);
+   }
+
+/* STOP AT FIRST IMAGE A WRITER THREAD FAILED TO WRITE */
+
+   if ( __atomic_load_n(&cap.Fail, __ATOMIC_ACQUIRE) ) quitflag = TRUE;
+}
+
+/*
+ * WRITES DRAWN PIXMAP OR FRAMEBUFFER TO FRAME STREAM, OR LEAVES IT TO
+ * THE FRAME PIPELINE OUTPUT STAGE
+*/
+void StreamImage( Display *display, Colormap cmap, Pixmap pixmap )
+{
+   XImage         *ximg;
+   XColor          xclr[16];
+   XColor          aclr;
+   Integer         nclr = 0;
+   Integer         k;
+   unsigned long   pix;
+   unsigned char  *ptr;
+   Longint         x, y;
+
+   if ( strmFile == NULL ) return;
+
+   if ( pip.On ) {
+      PipeStream();
+      return;
+   } else if ( ren_MOD != 0 ) {
+      FbToRGB(&fbDrawn, strmRGB);
+   } else {
+      ximg = XGetImage(display,pixmap,0,0,xMax,yMax,AllPlanes,ZPixmap);
+      if ( ximg == NULL ) return;
+      ptr = strmRGB;
+      for ( y = 0 ; y < yMax ; y++ ) {
+         for ( x = 0 ; x < xMax ; x++ ) {
+            /* Few colors are drawn, so cache colormap queries. */
+            pix = XGetPixel(ximg,x,y);
+            for ( k = 0 ; k < nclr ; k++ ) {
+               if ( xclr[k].pixel == pix ) break;
+            }
+            if ( k == nclr ) {
+               aclr.pixel = pix;
+               XQueryColor(display,cmap,&aclr);
+               if ( nclr < 16 ) xclr[nclr++] = aclr;
+               else k = -1;
+            }
+            if ( k < 0 ) {
+               ptr[0] = aclr.red   >> 8;
+               ptr[1] = aclr.green >> 8;
+               ptr[2] = aclr.blue  >> 8;
+            } else {
+               ptr[0] = xclr[k].red   >> 8;
+               ptr[1] = xclr[k].green >> 8;
+               ptr[2] = xclr[k].blue  >> 8;
+            }
+            ptr += 3;
+         }
+      }
+      XDestroyImage(ximg);
+   }
+   if ( ! StrmFrame() ) {
+      str_PATH = NULL;
+      quitflag = TRUE;
+   }
 }
 
-#include "cliplib.c"
-
 /*
 * DRAWS GRID LINES CLIPPED TO 3D VIEWING PYRAMID
 */
-void DrawGrid3D( Integer iaxis, Display *display, Pixmap drawable )
+void DrawGrid3D( Display *display, Pixmap drawable )
 {
-   Integer   k;
+   Integer   iaxis, k;
    Integer   i10,i11,i20,i21;
    Extended  xd1, yd1, zd1;
    Extended  xd2, yd2, zd2;
-   Integer   pcnt;
-   Integer   vcnt[8];
-   Pnt3D     vlist[8][mxvcnt];
+   Pnt3D     p0[82], p1[82];
+   XSegment  segs[82];
+   Longint   nseg, i;
    Extended  xs, ys, zs, sf;
-   XPoint    tempLine[mxvcnt];
-   Integer   i;
+   Extended  tgrd = 0.0;
 
 #if DBG_LVL > 4
-   printf("DrawGrid3D:  Drawing grid axis %d...\n",iaxis);
+   printf("DrawGrid3D:  Drawing grid...\n");
 #endif
 
-/* SET LINE DRAWING COLOR */
+   TRACE_BEG(1,"DrawGrid3D");
+   if ( sta_OUT == 1 ) tgrd = RenSec();
 
-   XSetForeground(display,the_GC,pixels[White]);
+/* CREATE UN-CLIPPED GRID LINES PARALLEL TO WORLD X-AXIS AND Y-AXIS */
 
-   if ( iaxis == 1 )
+   nseg = 0;
+   for ( iaxis = 1 ; iaxis <= 2 ; iaxis++ )
    {
-/*--- DRAW GRID LINES PARALLEL TO WORLD X-AXIS */
-      i10 = 3;
-      i11 = 2;
-      i20 = 0;
-      i21 = 1;
-   }
-   else
-   {
-/*--- DRAW GRID LINES PARALLEL TO WORLD Y-AXIS */
-      i10 = 3;
-      i11 = 0;
-      i20 = 2;
-      i21 = 1;
-   }
+      if ( iaxis == 1 )
+      {
+         i10 = 3;
+         i11 = 2;
+         i20 = 0;
+         i21 = 1;
+      }
+      else
+      {
+         i10 = 3;
+         i11 = 0;
+         i20 = 2;
+         i21 = 1;
+      }
 
-/* CALCULATE INCREMENTAL DISTANCES */
+/*--- CALCULATE INCREMENTAL DISTANCES */
+      xd1 = 0.025*(GridPt2[i11].X - GridPt2[i10].X);
+      yd1 = 0.025*(GridPt2[i11].Y - GridPt2[i10].Y);
+      zd1 = 0.025*(GridPt2[i11].Z - GridPt2[i10].Z);
+      xd2 = 0.025*(GridPt2[i21].X - GridPt2[i20].X);
+      yd2 = 0.025*(GridPt2[i21].Y - GridPt2[i20].Y);
+      zd2 = 0.025*(GridPt2[i21].Z - GridPt2[i20].Z);
 
-   xd1 = 0.025*(GridPt2[i11].X - GridPt2[i10].X);
-   yd1 = 0.025*(GridPt2[i11].Y - GridPt2[i10].Y);
-   zd1 = 0.025*(GridPt2[i11].Z - GridPt2[i10].Z);
-   xd2 = 0.025*(GridPt2[i21].X - GridPt2[i20].X);
-   yd2 = 0.025*(GridPt2[i21].Y - GridPt2[i20].Y);
-   zd2 = 0.025*(GridPt2[i21].Z - GridPt2[i20].Z);
+      for ( k = 0 ; k < 41 ; k++ )
+      {
+/*------ CALCULATE X COORDINATE OF UN-CLIPPED LINE */
+         p0[nseg].X = GridPt2[i10].X + k*xd1;
+         p1[nseg].X = GridPt2[i20].X + k*xd2;
 
-   for ( k = 0 ; k < 41 ; k++ )
-   {
-      pcnt = 1;
+         if ( ! ((p0[nseg].X <= flmin) && (p1[nseg].X <= flmin)) )
+         {
+/*--------- CREATE UN-CLIPPED LINE */
+            p0[nseg].Y = GridPt2[i10].Y + k*yd1;
+            p0[nseg].Z = GridPt2[i10].Z + k*zd1;
+            p1[nseg].Y = GridPt2[i20].Y + k*yd2;
+            p1[nseg].Z = GridPt2[i20].Z + k*zd2;
+            nseg       = nseg + 1;
+         }
+      }
+   }
+   gridstat.Nseg = gridstat.Nseg + nseg;
 
-/*--- CALCULATE X COORDINATE OF UN-CLIPPED LINE */
-      vlist[pcnt][1].X = GridPt2[i10].X + k*xd1;
-      vlist[pcnt][2].X = GridPt2[i20].X + k*xd2;
+/* CLIP GRID LINES IN ONE BATCH */
 
-      if ( ! ((vlist[pcnt][1].X <= flmin) && (vlist[pcnt][2].X <= flmin)) )
-      {
-/*------ CREATE UN-CLIPPED LINE */
-         vlist[pcnt][1].Y = GridPt2[i10].Y + k*yd1;
-         vlist[pcnt][1].Z = GridPt2[i10].Z + k*zd1;
-         vlist[pcnt][2].Y = GridPt2[i20].Y + k*yd2;
-         vlist[pcnt][2].Z = GridPt2[i20].Z + k*zd2;
-         vlist[pcnt][3]   = vlist[pcnt][1];
-         vcnt[pcnt]       = 3;
+   nseg = LineClip(nseg, p0, p1);
+   gridstat.Dseg = gridstat.Dseg + nseg;
 
 #if DBG_LVL > 4
-         for (i=1; i<= vcnt[pcnt]; i++)
-            printf("DrawGrid3D:  %d %d %f %f %f\n",pcnt,i,
-                   vlist[pcnt][i].X,vlist[pcnt][i].Y,vlist[pcnt][i].Z);
+   for (i=0; i<nseg; i++)
+      printf("DrawGrid3D:  %ld %f %f %f  %f %f %f\n",i,
+             p0[i].X,p0[i].Y,p0[i].Z,p1[i].X,p1[i].Y,p1[i].Z);
 #endif
 
-/*------ CREATE CLIPPED LINE */
-         PolyClip( (Integer *)&pcnt, vcnt, vlist );
+/* DRAW CLIPPED LINES WITH ONE REQUEST */
 
-#if DBG_LVL > 4
-         for (i=1; i<= vcnt[pcnt]; i++)
-            printf("DrawGrid3D:  %d %d %f %f %f\n",pcnt,i,
-                   vlist[pcnt][i].X,vlist[pcnt][i].Y,vlist[pcnt][i].Z);
-#endif
+   for ( i = 0 ; i < nseg ; i++ )
+   {
+      xs         = p0[i].X;
+      ys         = p0[i].Y/sfacyAR;
+      zs         = p0[i].Z/sfacz;
+      sf         = fl/xs;
+      segs[i].x1 = lroundd(sf*ys) + floor(fovcx);
+      segs[i].y1 = lroundd(sf*zs) + floor(fovcy);
+      xs         = p1[i].X;
+      ys         = p1[i].Y/sfacyAR;
+      zs         = p1[i].Z/sfacz;
+      sf         = fl/xs;
+      segs[i].x2 = lroundd(sf*ys) + floor(fovcx);
+      segs[i].y2 = lroundd(sf*zs) + floor(fovcy);
+   }
+   if ( nseg > 0 )
+   {
+      RenSetForeground(display,White);
+      RenDrawSegments(display, drawable, segs, nseg);
+      gridstat.Nreq = gridstat.Nreq + 1;
+   }
 
-/*------ DRAW CLIPPED LINE */
-         if ( vcnt[pcnt] > 2 )
-         {
-            for ( i = 1 ; i < 3 ; i++ )
-            {
-                xs              = vlist[pcnt][i].X;
-                ys              = vlist[pcnt][i].Y/sfacyAR;
-                zs              = vlist[pcnt][i].Z/sfacz;
-                sf              = fl/xs;
-                tempLine[i-1].x = lroundd(sf*ys) + floor(fovcx);
-                tempLine[i-1].y = lroundd(sf*zs) + floor(fovcy);
-            }
-            XDrawLines(display, drawable, the_GC, tempLine, 2, CoordModeOrigin);
-         }
-      }
+   if ( sta_OUT == 1 ) gridstat.Sec = gridstat.Sec + RenSec() - tgrd;
+   TRACE_END(1);
+}
+
+/*
+ * SETS FRAMEBUFFER DEPTH PLANE OF POLYGON FOR Z-BUFFERED DRAWING
+*/
+void DepthPlane( Longint iPol, Extended tol )
+{
+   Extended  nx, ny, nz, d, a, b;
+
+/* A point (x,y,z) of the polygon plane N.P = N.C through its centroid
+   eye vector C projects to pixel offsets u = fl*y/x and v = fl*z/x
+   from the viewport center, where the inverse depth 1/x is the affine
+   function (nx + ny*u/fl + nz*v/fl)/d of pixel coordinates.  A plane
+   seen edge on is given the depth of its centroid.
+*/
+   nx = ctrlist.NX2[iPol];
+   ny = ctrlist.NY2[iPol];
+   nz = ctrlist.NZ2[iPol];
+   d  = nx*ctrlist.CX2[iPol] + ny*ctrlist.CY2[iPol] + nz*ctrlist.CZ2[iPol];
+   if ( fabs(d) < 1.0e-9*fabs(ctrlist.CX2[iPol]) ) {
+      FbSetDepth(fZero, fZero, fOne/ctrlist.CX2[iPol], tol);
+      return;
    }
+   a = ny/(fl*d);
+   b = nz/(fl*d);
+   FbSetDepth(a, b, nx/d - a*floor(fovcx) - b*floor(fovcy), tol);
 }
 
 /*
  * DRAWS POLYGON CLIPPED TO 3D VIEWING PYRAMID
 */
-void DrawPoly3D( Integer iPol, Display *display, Pixmap drawable )
+void DrawPoly3D( Longint iPol, Display *display, Pixmap drawable )
 {
-   PolPtr    aPolRec;
-   Integer   pcnt, icnt;
-   Integer   vcnt[8];
-   Pnt3D     vlist[8][mxvcnt];
+   Longint   j, jend;
+   Longint   pcnt, icnt;
+   Longint   vcnt[8];
+   Pnt3D   **vlist = clpvtx;
    Extended  xs, ys, zs, sf;
-   XPoint    tempPoly[mxvcnt];
-   Integer   i;
+   XPoint   *tempPoly;
+   Extended  tclp = 0.0;
+   Longint   i;
 
 /* GET UN-CLIPPED POLYGON */
 
 #if DBG_LVL > 4
-   printf("DrawPoly3D:  Drawing polygon %d...\n",iPol);
+   printf("DrawPoly3D:  Drawing polygon %ld...\n",iPol);
 #endif
 
-   aPolRec = pollist[iPol].Ptr;
-   pcnt    = 1;
-   icnt    = 0;
-   while ( aPolRec != NULL )
+   if ( ! ClipGrow(pollist[iPol].Vcnt + 1) ) return;
+
+   pcnt = 1;
+   icnt = 0;
+   jend = pollist[iPol].Voff + pollist[iPol].Vcnt;
+   for ( j = pollist[iPol].Voff ; j < jend ; j++ )
    {
-      icnt              = icnt + 1;
-      vlist[pcnt][icnt] = aPolRec->Pt2;
-      aPolRec           = aPolRec->Nxt;
+      icnt                = icnt + 1;
+      vlist[pcnt][icnt].X = vtxlist.X2[j];
+      vlist[pcnt][icnt].Y = vtxlist.Y2[j];
+      vlist[pcnt][icnt].Z = vtxlist.Z2[j];
    }
    icnt              = icnt + 1;
    vlist[pcnt][icnt] = vlist[pcnt][1];
@@ -902,17 +1746,21 @@ void DrawPoly3D( Integer iPol, Display *display, Pixmap drawable )
 
 #if DBG_LVL > 4
    for (i=1; i<= vcnt[pcnt]; i++)
-      printf("DrawPoly3D:  %d %d %f %f %f\n",pcnt,i,
+      printf("DrawPoly3D:  %ld %ld %f %f %f\n",pcnt,i,
              vlist[pcnt][i].X,vlist[pcnt][i].Y,vlist[pcnt][i].Z);
 #endif
 
 /* CREATE CLIPPED POLYGON */
 
-   PolyClip( (Integer *)&pcnt, vcnt, vlist );
+   TRACE_BEG(2,"PolyClip");
+   if ( ( sta_OUT == 1 ) || bench.On ) tclp = RenSec();
+   PolyClip( &pcnt, vcnt, vlist );
+   if ( ( sta_OUT == 1 ) || bench.On ) clipstat.Sec = clipstat.Sec + RenSec() - tclp;
+   TRACE_END(2);
 
 #if DBG_LVL > 4
    for (i=1; i<= vcnt[pcnt]; i++)
-      printf("DrawPoly3D:  %d %d %f %f %f\n",pcnt,i,
+      printf("DrawPoly3D:  %ld %ld %f %f %f\n",pcnt,i,
              vlist[pcnt][i].X,vlist[pcnt][i].Y,vlist[pcnt][i].Z);
 #endif
 
@@ -920,6 +1768,9 @@ void DrawPoly3D( Integer iPol, Display *display, Pixmap drawable )
 
    if ( vcnt[pcnt] > 3 )
    {
+      if ( ! GrowList((void **)&xptlist, &xptmax, vcnt[pcnt],
+                      sizeof(XPoint), mxvcnt) ) return;
+      tempPoly = xptlist;
       for ( i = 1 ; i <= vcnt[pcnt] ; i++ )
       {
          xs              = vlist[pcnt][i].X;
@@ -929,20 +1780,25 @@ void DrawPoly3D( Integer iPol, Display *display, Pixmap drawable )
          tempPoly[i-1].x = lroundd(sf*ys) + floor(fovcx);
          tempPoly[i-1].y = lroundd(sf*zs) + floor(fovcy);
       }
+      if ( ( zbf_MOD == 1 ) && ( iPol > 1 ) )
+      {
+         /*--- Outlines get a looser depth tolerance so edges remain
+               visible over their own and adjacent coplanar faces. */
+         DepthPlane(iPol, ( pollist[iPol].Vis > 0 ) ? 1.0e-6 : 1.0e-3);
+      }
       if ( pollist[iPol].Vis > 0 )
       {
-         XSetForeground(display,the_GC,pixels[pollist[iPol].Pat]);
-         XFillPolygon(display, drawable, the_GC,
-                      tempPoly, vcnt[pcnt], Convex, CoordModeOrigin);
+         RenSetForeground(display,pollist[iPol].Pat);
+         RenFillPolygon(display, drawable, tempPoly, vcnt[pcnt]);
       }
       else
       {
-         XSetForeground(display,the_GC,pixels[pollist[iPol].Pat]);
-         XSetLineAttributes(display,the_GC,2,LineSolid,CapButt,JoinMiter);
-         XDrawLines(display, drawable, the_GC,
-                    tempPoly, vcnt[pcnt], CoordModeOrigin);
-         XSetLineAttributes(display,the_GC,1,LineSolid,CapButt,JoinMiter);
+         RenSetForeground(display,pollist[iPol].Pat);
+         RenSetLineWidth(display,2);
+         RenDrawLines(display, drawable, tempPoly, vcnt[pcnt]);
+         RenSetLineWidth(display,1);
       }
+      FbNoDepth();
    }
 }
 
@@ -951,8 +1807,10 @@ void DrawPoly3D( Integer iPol, Display *display, Pixmap drawable )
 */
 void LoadPoly ( FILE *lfni, const char* polyfile )
 {
-   Integer   i,k;
-   Integer   polpnt, polpri, polcol, poltyp, polvis;
+   Longint   i;
+   Integer   k;
+   Longint   polpnt;
+   Integer   polpri, polcol, poltyp, polvis;
    Extended  polsfc;
    Extended  x, y, z;
    Extended  mdloffx, mdloffy, mdloffz, mdlsfc;
@@ -961,9 +1819,11 @@ void LoadPoly ( FILE *lfni, const char* polyfile )
    char      polnam[60];
 
    static char fmt0[]="%lf %lf %lf %lf %s\n";
-   static char fmt1[]="%hd %hd %hd %hd %hd %lf %s\n";
+   static char fmt1[]="%ld %hd %hd %hd %hd %lf %s\n";
    static char fmt2[]="%lf %lf %lf\n";
 
+   Longint   iPol1 = polcnt + 1;
+
 /* Read shape model offsets, scaling factor and name record. */
    sptr = fgets(sbuff,132,lfni);
    if ( sptr == NULL ) {
@@ -983,10 +1843,14 @@ void LoadPoly ( FILE *lfni, const char* polyfile )
       if ( k == 7 )
       {
 #if DBG_LVL > 1
-         printf("LoadPoly:  Loaded specs -  %d  %d  %d  %d  %d  %f  %s\n",
+         printf("LoadPoly:  Loaded specs -  %ld  %d  %d  %d  %d  %f  %s\n",
                  polpnt,polpri,polcol,poltyp,polvis,polsfc,polnam);
 #endif
 /*++++++ Load vertex points. */
+         if ( ! GrowList((void **)&pntlist, &pntmax, polpnt+1,
+                         sizeof(Pnt3D), maxpnt) ) {
+            break;
+         }
          for ( i = 1 ; i <= polpnt ; i++ )
          {
             fgets(sbuff,132,lfni);
@@ -1023,7 +1887,125 @@ void LoadPoly ( FILE *lfni, const char* polyfile )
             MakePol(polpnt,polpri,poltyp,polvis,Black,offset);
          }
       }
-   } while ( ! ( feof(lfni) || (polcnt == maxpol) ) );
+   } while ( ! feof(lfni) );
+
+/* Make objects from loaded polygons. */
+
+   if ( polcnt >= iPol1 ) {
+      MakeObj(iPol1, polcnt);
+   }
+}
+
+/*
+ * REPLICATES TARGET POLYGONS INTO A CUBIC LATTICE OF ncopy TARGETS,
+ * SPACED SO NO TWO TARGETS OVERLAP, TO MEASURE HOW FRAME TIME SCALES
+ * WITH POLYGON COUNT
+*/
+void ScaleModels( Longint ncopy )
+{
+   Pnt3D     off;
+   Extended  d;
+   Longint   iPol, iPol1, iPol2, iBeg;
+   Longint   iObj, k, m, i, j;
+
+/* Find range of target polygons and lattice spacing. */
+
+   iPol1 = polcnt + 1;
+   iPol2 = 0;
+   d     = fZero;
+   for ( iObj = 0 ; iObj < objcnt ; iObj++ ) {
+      if ( objlist[iObj].Typ != poltyp_tgt ) continue;
+      iPol1 = lmin(iPol1, objlist[iObj].Pol1);
+      iPol2 = lmax(iPol2, objlist[iObj].Pol2);
+      d     = dmax(d, fTwo*(MagP3D(objlist[iObj].Cen0) + objlist[iObj].Rad));
+   }
+   if ( iPol2 < iPol1 ) return;
+
+/* Make each copy of the target polygons an object of its own. */
+
+   m = 1;
+   while ( m*m*m < ncopy ) m = m + 1;
+   for ( k = 1 ; k < ncopy ; k++ )
+   {
+      off.X =  (k % m)*d;
+      off.Y = ((k/m) % m)*d;
+      off.Z = -(k/(m*m))*d;
+      iBeg  = polcnt + 1;
+      for ( iPol = iPol1 ; iPol <= iPol2 ; iPol++ )
+      {
+         if ( pollist[iPol].Typ != poltyp_tgt ) continue;
+         if ( ! GrowList((void **)&pntlist, &pntmax, pollist[iPol].Vcnt+1,
+                         sizeof(Pnt3D), maxpnt) ) return;
+         j = pollist[iPol].Voff;
+         for ( i = 1 ; i <= pollist[iPol].Vcnt ; i++, j++ ) {
+            pntlist[i].X = vtxlist.X0[j];
+            pntlist[i].Y = vtxlist.Y0[j];
+            pntlist[i].Z = vtxlist.Z0[j];
+         }
+         MakePol(pollist[iPol].Vcnt, (Integer)(pollist[iPol].Pri/100000000),
+                 pollist[iPol].Typ, pollist[iPol].Vis, pollist[iPol].Pat, off);
+      }
+      if ( polcnt < iBeg ) return;
+      MakeObj(iBeg, polcnt);
+   }
+#if DBG_LVL > 0
+   printf("ScaleModels:  %ld targets, %ld polygons, %ld vertice\n",
+          ncopy,polcnt,vtxlist.Cnt);
+#endif
+}
+
+/*
+ * LOADS POLYGONS OF MODEL FILE FROM MODEL PACK, OR PARSES THE FILE IF
+ * IT IS NOT PACKED OR HAS CHANGED SINCE PACKED
+*/
+void LoadFile( const char *fpath )
+{
+   FILE  *lfni;
+
+   if ( PackPoly(fpath) ) return;
+
+   lfni = fopen(fpath,"r");
+   if ( lfni )
+   {
+#if DBG_LVL > 0
+      printf("LoadFile:  Loading polygons from file %s\n",fpath);
+#endif
+      TRACE_BEG(1,"LoadPoly");
+      LoadPoly(lfni,fpath);
+      TRACE_END(1);
+      fclose(lfni);
+   }
+}
+
+/*
+ * READS AND MAKES GROUND, TARGET AND MISSILE OBJECT POLYGONS
+*/
+void LoadModels( void )
+{
+   char  grndpoly_fpath[24];
+   char  mislpoly_fpath[24];
+
+   polcnt      = 0;
+   objcnt      = 0;
+   vtxlist.Cnt = 0;
+   SortReset(&polSL);
+   TRACE_BEG(1,"LoadModels");
+   PackOpen();
+
+   sprintf(grndpoly_fpath,"./dat/grndpoly%1hd.dat",msl_TYP);
+   LoadFile(grndpoly_fpath);
+
+   LoadFile("./dat/fwngpoly.dat");
+
+   if ( scl_CNT > 1 ) {
+      ScaleModels(scl_CNT);
+   }
+
+   sprintf(mislpoly_fpath,"./dat/mislpoly%1hd.dat",msl_TYP);
+   LoadFile(mislpoly_fpath);
+
+   PackClose();
+   TRACE_END(1);
 }
 
 /*
@@ -1038,59 +2020,68 @@ void draw3D (Widget w, Display *display, Window drawable)
    Extended     last_tsec = -1.0/img_FPS;
    Extended     last_XM, last_YM, last_ZM;
    Extended     DXTM, DYTM, DZTM, RTM, UXTM, UYTM, UZTM;
+   Extended     tfrm;
    Integer      n = 0;
-   Integer      i, k, itot, ipad;
+   Longint      k;
    HeapElement  anElement;
    XEvent       event;
    XColor       screen_def, exact_def;
-   Colormap     cmap = XDefaultColormapOfScreen(XtScreen(w));
-   FILE         *lfni;
-   FILE         *lfnt;
+   Pixel        bkgpix;
+   Colormap     cmap = None;
+   TxyzFile     trj;
+   TxyzRate     rate;
+   TxyzRec      trec;
+   Integer      got;
    Boolean      paused = FALSE;
+   Boolean      stepped = FALSE;
+   Boolean      reverse = FALSE;
+   Longint      iseek = -1;
    Boolean      align_fov_toward_tgt = FALSE;
    Boolean      align_fov_toward_msl = FALSE;
    Boolean      align_fov_along_head = TRUE;
    Longint      waitmsec = 10;
+   Boolean      piped = ( ren_MOD == 1 ) && ( pip_USE == 1 );
    Integer      img_count= 0;
    Extended     img_dtsec= 1.0/img_FPS;
-   char         imgout_fpath[24];
-   char         grndpoly_fpath[24];
-   char         mislpoly_fpath[24];
-   char         txyzout_fpath[24];
+   char         imgout_fpath[280];
 
 /* GET PIXEL COLORS */
 
-   if ( XAllocNamedColor(display,cmap,"white",&exact_def,&screen_def) != 0 )
-   {
-      pixels[White] = screen_def.pixel;
-   }
-   if ( XAllocNamedColor(display,cmap,"black",&exact_def,&screen_def) != 0 )
-   {
-      pixels[Black] = screen_def.pixel;
-   }
-   if ( XAllocNamedColor(display,cmap,"red",&exact_def,&screen_def) != 0 )
-   {
-      pixels[Red] = screen_def.pixel;
-   }
-   if ( XAllocNamedColor(display,cmap,"green",&exact_def,&screen_def) != 0 )
-   {
-      pixels[Green] = screen_def.pixel;
-   }
-   if ( XAllocNamedColor(display,cmap,"blue",&exact_def,&screen_def) != 0 )
-   {
-      pixels[Blue] = screen_def.pixel;
-   }
-   if ( XAllocNamedColor(display,cmap,"cyan",&exact_def,&screen_def) != 0 )
-   {
-      pixels[Cyan] = screen_def.pixel;
-   }
-   if ( XAllocNamedColor(display,cmap,"yellow",&exact_def,&screen_def) != 0 )
-   {
-      pixels[Yellow] = screen_def.pixel;
-   }
-   if ( XAllocNamedColor(display,cmap,"brown",&exact_def,&screen_def) != 0 )
+   if ( ren_MOD != 1 )
    {
-      pixels[Brown] = screen_def.pixel;
+      cmap = XDefaultColormapOfScreen(XtScreen(w));
+      if ( XAllocNamedColor(display,cmap,"white",&exact_def,&screen_def) != 0 )
+      {
+         pixels[White] = screen_def.pixel;
+      }
+      if ( XAllocNamedColor(display,cmap,"black",&exact_def,&screen_def) != 0 )
+      {
+         pixels[Black] = screen_def.pixel;
+      }
+      if ( XAllocNamedColor(display,cmap,"red",&exact_def,&screen_def) != 0 )
+      {
+         pixels[Red] = screen_def.pixel;
+      }
+      if ( XAllocNamedColor(display,cmap,"green",&exact_def,&screen_def) != 0 )
+      {
+         pixels[Green] = screen_def.pixel;
+      }
+      if ( XAllocNamedColor(display,cmap,"blue",&exact_def,&screen_def) != 0 )
+      {
+         pixels[Blue] = screen_def.pixel;
+      }
+      if ( XAllocNamedColor(display,cmap,"cyan",&exact_def,&screen_def) != 0 )
+      {
+         pixels[Cyan] = screen_def.pixel;
+      }
+      if ( XAllocNamedColor(display,cmap,"yellow",&exact_def,&screen_def) != 0 )
+      {
+         pixels[Yellow] = screen_def.pixel;
+      }
+      if ( XAllocNamedColor(display,cmap,"brown",&exact_def,&screen_def) != 0 )
+      {
+         pixels[Brown] = screen_def.pixel;
+      }
    }
 #if DBG_LVL > 0
    printf("White = %lu\n",pixels[White]);
@@ -1105,9 +2096,15 @@ void draw3D (Widget w, Display *display, Window drawable)
 
 /* INITIALIZE VIEWPORT */
 
-   XtSetArg(args[n], XtNwidth,  &width ); n++;
-   XtSetArg(args[n], XtNheight, &height); n++;
-   XtGetValues(w, args, n);
+   if ( ren_MOD == 1 ) {
+      width  = win_WID;
+      height = win_HGT;
+      fovs   = height;
+   } else {
+      XtSetArg(args[n], XtNwidth,  &width ); n++;
+      XtSetArg(args[n], XtNheight, &height); n++;
+      XtGetValues(w, args, n);
+   }
    xAspect = width;
    yAspect = height;
    ratio = (xAspect*1.0)/(yAspect*1.0);
@@ -1122,34 +2119,104 @@ void draw3D (Widget w, Display *display, Window drawable)
    printf("draw3D:  fovcx,fovcy = %f %f\n",fovcx,fovcy);
 #endif
 
-/* DEFINE DRAWING ATTRIBUTES AND CLEAR DISPLAY */
-
-   XSetLineAttributes(display,the_GC,1,LineSolid,CapButt,JoinMiter);
-   XSetFillRule(display,the_GC,WindingRule);
-   XSetForeground(display,the_GC,pixels[White]);
-   XSetBackground(display,the_GC,pixels[Black]);
-   XClearArea(display, drawable, 0, 0, xMax, yMax, TRUE);
+/* DEFINE DRAWING ATTRIBUTES, CLEAR DISPLAY AND CREATE OFFSCREEN BUFFERS */
 
-/* FRAME VIEWPORT */
+   if ( ren_MOD != 0 )
+   {
+/*--- CREATE AND INITIALIZE DRAWN AND BLANK FRAMEBUFFERS */
+      if ( ! ( FbCreate(&fbDrawn,xMax,yMax) && FbCreate(&fbBlank,xMax,yMax) &&
+               ( ( zbf_MOD == 0 ) || FbCreateDepth(&fbDrawn) ) &&
+               TileCreate(&fbDrawn, (Integer)thr_CNT, piped) ) ) {
+         FbFree(&fbDrawn);
+         FbFree(&fbBlank);
+         quitflag = TRUE;
+         return;
+      }
+      fbFgClr  = White;
+      fbBgClr  = Black;
+      fbLinWid = 1;
+      FbClear(&fbBlank,fbBkgClr);
+      FbDrawRectangle(&fbBlank,0,0,xMax-1,yMax-1);
+      FbCopy(&fbDrawn,&fbBlank);
+
+/*--- CREATE WINDOW PRESENTATION IMAGE */
+      if ( ren_MOD == 2 ) {
+         n = 0;
+         XtSetArg(args[n], XtNbackground, &bkgpix); n++;
+         XtGetValues(w, args, n);
+         if ( ! ShmCreate(display,drawable,xMax,yMax,pixels,bkgpix,
+                          (Boolean)shm_USE) ) {
+            TileFree();
+            FbFree(&fbDrawn);
+            FbFree(&fbBlank);
+            quitflag = TRUE;
+            return;
+         }
+      }
+   }
+   else
+   {
+/*--- DEFINE DRAWING ATTRIBUTES AND CLEAR DISPLAY */
+      XSetLineAttributes(display,the_GC,1,LineSolid,CapButt,JoinMiter);
+      XSetFillRule(display,the_GC,WindingRule);
+      XSetForeground(display,the_GC,pixels[White]);
+      XSetBackground(display,the_GC,pixels[Black]);
+      XClearArea(display, drawable, 0, 0, xMax, yMax, TRUE);
+
+/*--- FRAME VIEWPORT */
 /* Fills viewport with black
-   XSetForeground(display,the_GC,pixels[Black]);
-   XFillRectangle(display,drawable,the_GC,0,0,xMax,yMax);
-   XSetForeground(display,the_GC,pixels[White]);
+      XSetForeground(display,the_GC,pixels[Black]);
+      XFillRectangle(display,drawable,the_GC,0,0,xMax,yMax);
+      XSetForeground(display,the_GC,pixels[White]);
 */
-   XDrawRectangle(display,drawable,the_GC,0,0,xMax-1,yMax-1);
-   XFlush(display);
+      XDrawRectangle(display,drawable,the_GC,0,0,xMax-1,yMax-1);
+      XFlush(display);
+
+/*--- DRAW INTO WINDOW BACK BUFFER, WHICH EACH SWAP CLEARS */
+      dbeOn = ( dbe_USE == 1 ) && DbeCreate(display,drawable);
+      if ( dbeOn ) {
+         drawn = dbeBack;
+         XCopyArea(display,drawable,drawn,the_GC,0,0,xMax,yMax,0,0);
+      }
+      else
+      {
+/*------ CREATE DRAWN AND BLANK PIXMAPS, KEPT ACROSS REPLAYS OF SAME SIZE */
+         if ( ( pixWid != xMax ) || ( pixHgt != yMax ) ) {
+            if ( pixWid > 0 ) {
+               XFreePixmap(display,drawn);
+               XFreePixmap(display,blank);
+            }
+            drawn = XCreatePixmap(display,drawable,xMax,yMax,
+                                   DefaultDepthOfScreen(XtScreen(w)));
+            blank = XCreatePixmap(display,drawable,xMax,yMax,
+                                   DefaultDepthOfScreen(XtScreen(w)));
+            pixWid = xMax;
+            pixHgt = yMax;
+         }
+
+/*------ INITIALIZE DRAWN AND BLANK PIXMAPS */
+         XCopyArea(display,drawable,drawn,the_GC,0,0,xMax,yMax,0,0);
+         XCopyArea(display,drawable,blank,the_GC,0,0,xMax,yMax,0,0);
+      }
+   }
 
-/* CREATE AND INITIALIZE DRAWN PIXMAP */
+/* OPEN FRAME STREAM (KEPT OPEN ACROSS REPLAYS) */
 
-   drawn = XCreatePixmap(display,drawable,xMax,yMax,
-                          DefaultDepthOfScreen(XtScreen(w)));
-   XCopyArea(display,drawable,drawn,the_GC,0,0,xMax,yMax,0,0);
+   if ( ( str_PATH != NULL ) && ( strmFile == NULL ) ) {
+      if ( ! StrmOpen(str_PATH,str_FMT,xMax,yMax,img_FPS) ) {
+         quitflag = TRUE;
+      }
+   }
 
-/* CREATE AND INITIALIZE BLANK PIXMAP */
+/* START WRITER THREADS OF CAPTURED IMAGES */
 
-   blank = XCreatePixmap(display,drawable,xMax,yMax,
-                          DefaultDepthOfScreen(XtScreen(w)));
-   XCopyArea(display,drawable,blank,the_GC,0,0,xMax,yMax,0,0);
+   if ( img_OUT == 1 ) {
+      CapCreate((Integer)wrt_CNT, (Integer)wrt_QUE,
+                ( wrt_DRP == 1 ) ? CapDrop : CapBlock, xMax, yMax);
+      if ( ( ren_MOD == 0 ) && ( cap.Nthr > 0 ) ) {
+         WritePalette(w, display, cmap);
+      }
+   }
 
 /* COMPUTE VIEWPORT FOV FOCAL LENGTHS */
 
@@ -1165,40 +2232,10 @@ void draw3D (Widget w, Display *display, Window drawable)
    printf("draw3D:  sfacx,sfacy,sfacyAR,sfacz = %f %f %f %f\n",sfacx,sfacy,sfacyAR,sfacz);
 #endif
 
-/* READ AND MAKE OBJECT POLYGONS */
-
-   polcnt = 0;
-
-   sprintf(grndpoly_fpath,"./dat/grndpoly%1hd.dat",msl_TYP);
-   lfni = fopen(grndpoly_fpath,"r");
-   if ( lfni )
-   {
-#if DBG_LVL > 0
-      printf("draw3D:  Loading polygons from file %s\n",grndpoly_fpath);
-#endif
-      LoadPoly(lfni,grndpoly_fpath);
-      fclose(lfni);
-   }
-
-   lfni = fopen("./dat/fwngpoly.dat","r");
-   if ( lfni )
-   {
-#if DBG_LVL > 0
-      printf("draw3D:  Loading polygons from file %s\n","fwngpoly.dat");
-#endif
-      LoadPoly(lfni,"./dat/fwngpoly.dat");
-      fclose(lfni);
-   }
+/* READ AND MAKE OBJECT POLYGONS UNLESS PRELOADED (E.G., FOR BATCH RUNS) */
 
-   sprintf(mislpoly_fpath,"./dat/mislpoly%1hd.dat",msl_TYP);
-   lfni = fopen(mislpoly_fpath,"r");
-   if ( lfni )
-   {
-#if DBG_LVL > 0
-      printf("draw3D:  Loading polygons from file %s\n",mislpoly_fpath);
-#endif
-      LoadPoly(lfni,mislpoly_fpath);
-      fclose(lfni);
+   if ( polcnt == 0 ) {
+      LoadModels();
    }
 
 /* MAY NEED TO SAVE LAST MISSILE POSITION */
@@ -1209,20 +2246,54 @@ void draw3D (Widget w, Display *display, Window drawable)
 
 /* OPEN TRAJECTORY DATA FILE */
 
-   sprintf(txyzout_fpath,"./txyz/TXYZ.OUT.%04hd",run_NUM);
-#if DBG_LVL > 0
-   printf("draw3D:  Opening trajectory file %s\n",txyzout_fpath);
-#endif
-   lfnt = fopen(txyzout_fpath,"r");
+   TRACE_BEG(1,"TxyzOpen");
+   memset(&trec, 0, sizeof(trec));
+   if ( fol_PATH != NULL ) {
+      if ( ! TxyzFollow(&trj,fol_PATH,
+                        (ren_MOD == 1) ? -1 : ConnectionNumber(display)) ) {
+         quitflag = TRUE;
+      }
+   } else if ( ! TxyzOpen(&trj,run_NUM) ) {
+      quitflag = TRUE;
+   } else if ( sek_TSEC >= 0.0 ) {
+      iseek = TxyzFind(&trj,sek_TSEC);
+   }
+   TRACE_END(1);
+
+/* START FIXED RATE FRAMES, PLAYED AT THEIR FRAME INTERVAL IN A WINDOW */
+
+   if ( rat_FPS > 0 ) {
+      TxyzRateStart(&rate,(Extended)rat_FPS);
+      waitmsec = lroundd(1000.0/rat_FPS);
+   }
+
+/* START FRAME PIPELINE STAGES, PARSING FROM SEEK POSITION */
+
+   if ( piped && ! quitflag ) {
+      if ( iseek >= 0 ) {
+         TxyzSeek(&trj,iseek);
+         iseek = -1;
+      }
+      if ( ! PipeCreate(&trj, ( rat_FPS > 0 ) ? &rate : NULL, &fbBlank,
+                        (Boolean)zbf_MOD) ) {
+         quitflag = TRUE;
+      }
+   }
 
 /* MAIN PROCESSING LOOP OVER TRAJECTORY DATA FILE */
 
-   while( ! ( feof(lfnt) || quitflag ) )
-   {
-      cpumsec1 = clock()/CpMsec;
+   SchdStart(waitmsec);
+   if ( bch_PATH != NULL ) {
+      BenchStart();
+   }
 
+   while( ! ( quitflag || ( pip.On ? PipeEof() :
+                            ( rat_FPS > 0 ) ? TxyzRateEof(&trj,&rate)
+                                            : TxyzEof(&trj) ) ) )
+   {
 /*--- CHECK FOR KEYPRESS EVENT */
-      if ( XCheckWindowEvent(XtDisplay(w),XtWindow(w),KeyPressMask,&event) ) {
+      if ( ( ren_MOD != 1 ) &&
+           XCheckWindowEvent(XtDisplay(w),XtWindow(w),KeyPressMask,&event) ) {
          if ( event.type == KeyPress ) {
             switch ( XkbKeycodeToKeysym(display, event.xkey.keycode, 0, event.xkey.state & ShiftMask ? 1 : 0) )
             {
@@ -1281,10 +2352,12 @@ void draw3D (Widget w, Display *display, Window drawable)
                } else {
                   waitmsec = lmax(10, waitmsec);
                }
+               SchdPeriod(waitmsec);
                break;
             case XK_Left :
                waitmsec += 10;
                waitmsec = lmin(250, waitmsec);
+               SchdPeriod(waitmsec);
                break;
             case XK_0 :
                if ( img_OUT == 1 ) {
@@ -1292,6 +2365,7 @@ void draw3D (Widget w, Display *display, Window drawable)
                } else {
                   waitmsec = 10;
                }
+               SchdPeriod(waitmsec);
                break;
             case XK_space :
                paused = ! paused;
@@ -1306,6 +2380,35 @@ void draw3D (Widget w, Display *display, Window drawable)
                } while ( paused );
                */
                break;
+            case XK_period :        /* step forward one record */
+               iseek   = trj.Irec;
+               paused  = TRUE;
+               stepped = TRUE;
+               break;
+            case XK_comma :         /* step backward one record */
+               iseek   = lmax(0, trj.Irec-2);
+               paused  = TRUE;
+               stepped = TRUE;
+               break;
+            case XK_bracketright :  /* scrub forward one second */
+               iseek   = TxyzFind(&trj,tsec+1.0);
+               stepped = paused;
+               break;
+            case XK_bracketleft :   /* scrub backward one second */
+               iseek   = TxyzFind(&trj,tsec-1.0);
+               stepped = paused;
+               break;
+            case XK_Home :          /* jump to first record */
+               iseek   = 0;
+               stepped = paused;
+               break;
+            case XK_End :           /* jump to last record */
+               iseek   = trj.Nrec-1;
+               stepped = paused;
+               break;
+            case XK_b :             /* toggle backward playback */
+               reverse = ! reverse;
+               break;
             case XK_q :
                quitflag = TRUE;
                break;
@@ -1315,9 +2418,27 @@ void draw3D (Widget w, Display *display, Window drawable)
          }
       }
 
-      if ( paused ) {
+      if ( paused && ! stepped ) {
+         if ( ren_MOD != 1 ) SchdIdle();
          continue;
       }
+      stepped = FALSE;
+
+/*--- POSITION TRAJECTORY FOR SEEK, STEP OR BACKWARD PLAYBACK */
+      if ( reverse && ( iseek < 0 ) ) {
+         if ( trj.Irec > 1 ) {
+            iseek = trj.Irec-2;
+         } else {
+            reverse = FALSE;
+            paused  = TRUE;
+            continue;
+         }
+      }
+      if ( iseek >= 0 ) {
+         TxyzSeek(&trj,iseek);
+         iseek = -1;
+         if ( rat_FPS > 0 ) TxyzRateStart(&rate,(Extended)rat_FPS);
+      }
 
       // Save last "true" missile position (i.e., that
       // read from a previous ktot >= 0 record).
@@ -1327,29 +2448,33 @@ void draw3D (Widget w, Display *display, Window drawable)
          last_ZM = ZM;
       }
 
-/*--- GET MISSILE AND TARGET POSITION */
-      fgets(sbuff,128,lfnt);
-      k = sscanf(sbuff,"%lf %hd %lf %lf %lf %lf %lf %lf\n",
-                       &tsec,&ktot,&XM,&YM,&ZM,&XT,&YT,&ZT);
-      if ( k == 8 )
+/*--- GET MISSILE AND TARGET POSITION AND ORIENTATION (OF RECORD OR FRAME) */
+      BenchBegin();
+      TRACE_BEG(1,"read");
+      got = pip.On ? PipeRead(&trec) :
+            ( rat_FPS > 0 ) ? TxyzReadRate(&trj,&rate,&trec)
+                            : TxyzRead(&trj,&trec);
+      TRACE_END(1);
+      if ( got == 1 )
       {
-/*------ GET MISSILE AND TARGET ORIENTATION */
-         fgets(sbuff,128,lfnt);
-         //sscanf(sbuff,"%hd ",&ipad);
-         if ( strstr(sbuff,"     -9999     -9999") ) {
-         /* PROPNAV1.MCD 3-DOF simulation trajectory output file */
-            sscanf(sbuff,"%hd %hd %lf %lf %lf %lf %lf %lf\n",
-                          &ipad,&ipad,&PHM,&THM,&PSM,&PHT,&THT,&PST);
-         } else {
-         /* Other 6-DOF simulation trajectory output file */
-            sscanf(sbuff,"%lf %lf %lf %lf %lf %lf\n",
-                          &PHM,&THM,&PSM,&PHT,&THT,&PST);
-         }
-/*------ SKIP DECOY POSITION AND RADIANCE */
-         for ( itot = 0 ; itot < ktot ; itot++ )
-         {
-            fgets(sbuff,128,lfnt);
-         }
+         BenchLap(bnParse);
+         TRACE_BEG(1,"frame");
+         TRACE_BEG(1,"move");
+         tfrm = RenSec();
+         tsec = trec.V[TxyzT];
+         ktot = trec.K;
+         XM   = trec.V[TxyzXM];
+         YM   = trec.V[TxyzYM];
+         ZM   = trec.V[TxyzZM];
+         XT   = trec.V[TxyzXT];
+         YT   = trec.V[TxyzYT];
+         ZT   = trec.V[TxyzZT];
+         PHM  = trec.V[TxyzPHM];
+         THM  = trec.V[TxyzTHM];
+         PSM  = trec.V[TxyzPSM];
+         PHT  = trec.V[TxyzPHT];
+         THT  = trec.V[TxyzTHT];
+         PST  = trec.V[TxyzPST];
 /*------ GET TARGET POSITION COMPONENTS */
          px = XT;
          py = YT;
@@ -1372,17 +2497,11 @@ void draw3D (Widget w, Display *display, Window drawable)
          printf("           %f  %f  %f\n",dcx2,dcy2,dcz2);
          printf("           %f  %f  %f\n",dcx3,dcy3,dcz3);
 #endif
-/*------ MOVE TARGET POLYGONS */
+/*------ PLACE TARGET OBJECTS */
 #if DBG_LVL > 2
-         printf("draw3D:  Move target polygons...\n");
+         printf("draw3D:  Place target objects...\n");
 #endif
-         for ( i = 1 ; i <= polcnt ; i++ )
-         {
-            if ( pollist[i].Typ == poltyp_tgt )
-            {
-               MovePoly(i,px,py,pz);
-            }
-         }
+         PlaceObject(poltyp_tgt,px,py,pz);
 /*------ GET MISSILE POSITION COMPONENTS */
          px = XM;
          py = YM;
@@ -1405,17 +2524,11 @@ void draw3D (Widget w, Display *display, Window drawable)
          printf("           %f  %f  %f\n",dcx2,dcy2,dcz2);
          printf("           %f  %f  %f\n",dcx3,dcy3,dcz3);
 #endif
-/*------ MOVE MISSILE POLYGONS */
+/*------ PLACE MISSILE OBJECTS */
 #if DBG_LVL > 2
-         printf("draw3D:  Move missile polygons...\n");
+         printf("draw3D:  Place missile objects...\n");
 #endif
-         for ( i = 1 ; i <= polcnt ; i++ )
-         {
-            if ( pollist[i].Typ == poltyp_msl )
-            {
-               MovePoly(i,px,py,pz);
-            }
-         }
+         PlaceObject(poltyp_msl,px,py,pz);
 /*------ CALCULATE UNIT VECTOR FROM MISSILE TO TARGET */
          // NOTE: RHS where +X is forward, +Y is to the
          //       right and +Z is down; -Z is up.
@@ -1472,11 +2585,37 @@ void draw3D (Widget w, Display *display, Window drawable)
          printf("           %f  %f  %f\n",dcx2,dcy2,dcz2);
          printf("           %f  %f  %f\n",dcx3,dcy3,dcz3);
 #endif
+/*------ CULL OBJECTS OUTSIDE VIEWING FRUSTUM */
+#if DBG_LVL > 2
+         printf("draw3D:  Cull objects...\n");
+#endif
+         CullObjects();
+
+/*------ MOVE POLYGONS OF OBJECTS NOT CULLED */
+#if DBG_LVL > 2
+         printf("draw3D:  Move object polygons...\n");
+#endif
+         MoveObjects();
+         TRACE_END(1);
+         BenchLap(bnMove);
+
+/*------ ORDER OBJECTS BY DEPTH FROM FOV POSITION */
+#if DBG_LVL > 2
+         printf("draw3D:  Order objects by depth...\n");
+#endif
+         TRACE_BEG(1,"order");
+         if ( zbf_MOD == 0 ) {
+            OrderObjects();
+         }
+         TRACE_END(1);
+         BenchLap(bnSort);
+
 /*------ TRANSFORM GROUND PLANE POLYGON INTO VIEWING PORT */
 #if DBG_LVL > 2
          printf("draw3D:  Transform ground plane polygon...\n");
 #endif
-         XfrmPoly(1);
+         TRACE_BEG(1,"xfrm");
+         XfrmPolys(1,1);
 
 /*------ TRANSFORM GROUND PLANE GRID INTO VIEWING PORT */
 #if DBG_LVL > 2
@@ -1488,17 +2627,23 @@ void draw3D (Widget w, Display *display, Window drawable)
 #if DBG_LVL > 2
          printf("draw3D:  Transform polygons...\n");
 #endif
-         ClearPQ(&polPQ);
-         for ( i = 2 ; i <= polcnt ; i++ )
-         {
-            XfrmPoly(i);
+         SortClear(&polSL);
+         XfrmObjects();
+         TRACE_END(1);
+         BenchLap(bnXfrm);
+
+/*------ TAKE FRAME OF PIPELINE TO RECORD DRAWING IN, ONCE IT IS WRITTEN */
+         if ( pip.On && ! PipeTake() ) {
+            TRACE_END(1);
+            break;
          }
+         TRACE_BEG(1,"draw");
 
 /*------ DRAW GROUND PLANE POLYGON */
 #if DBG_LVL > 2
          printf("draw3D:  Draw ground plane polygon...\n");
 #endif
-         XSetLineAttributes(display,the_GC,1,LineSolid,CapButt,JoinMiter);
+         RenSetLineWidth(display,1);
          if ( pollist[1].Flg ) {
             DrawPoly3D(1, display, drawn);
          }
@@ -1507,30 +2652,47 @@ void draw3D (Widget w, Display *display, Window drawable)
 #if DBG_LVL > 2
          printf("draw3D:  Draw ground plane grid...\n");
 #endif
-         XSetLineAttributes(display,the_GC,0,LineSolid,CapButt,JoinMiter);
-         DrawGrid3D(1, display, drawn);
-         DrawGrid3D(2, display, drawn);
+         RenSetLineWidth(display,0);
+         DrawGrid3D(display, drawn);
+         TRACE_END(1);
+         BenchLap(bnDraw);
 
 /*------ DRAW TARGET AND MISSILE POLYGONS */
 #if DBG_LVL > 2
          printf("draw3D:  Draw target and missile polygons...\n");
 #endif
-         XSetLineAttributes(display,the_GC,1,LineSolid,CapButt,JoinMiter);
-         while ( ! EmptyPQ(polPQ) )
+         RenSetLineWidth(display,1);
+         TRACE_BEG(1,"sort");
+         if ( zbf_MOD == 1 ) {
+            RenClearDepth();
+         } else if ( srt_BEN == 1 ) {
+            SortBench(&polSL);
+         } else {
+            SortOrder(&polSL);
+         }
+         TRACE_END(1);
+         BenchLap(bnSort);
+         TRACE_BEG(1,"draw");
+         for ( k = 0 ; k < polSL.Cnt ; k++ )
          {
-            PriorityDeq(&polPQ, &anElement);
+            anElement = polSL.Elements[k];
 #if DBG_LVL > 3
-            printf("  %ld  %hd  %hd  %hd  %ld\n", anElement.Key,
+            printf("  %ld  %ld  %hd  %hd  %ld\n", anElement.Key,
                    anElement.Info,
                    pollist[anElement.Info].Typ,
                    pollist[anElement.Info].Vis,
                    pollist[anElement.Info].Pri);
 #endif
+            TRACE_BEG(2,"DrawPoly3D");
             DrawPoly3D(anElement.Info, display, drawn);
+            TRACE_END(2);
          }
+         TRACE_END(1);
+         BenchLap(bnDraw);
 
 /*------ DISPLAY TIME, ZOOM, MISSILE AND TARGET STATE VARIABLES */
-         XSetForeground(display,the_GC,pixels[White]);
+         TRACE_BEG(1,"hud");
+         RenSetForeground(display,White);
          if ( ktot < 0 ) {
             // TXYZ padded time record
             sprintf(numstr,"Time= %8.4f",true_tsec);
@@ -1540,64 +2702,114 @@ void draw3D (Widget w, Display *display, Window drawable)
             true_tsec = tsec;
          }
 
-         XDrawImageString(display,drawn,the_GC, 10,12,numstr,14);
+         RenDrawImageString(display,drawn, 10,12,numstr,14);
          sprintf(numstr,"Zoom= %8.4f",zoom);
-         XDrawImageString(display,drawn,the_GC, 10,24,numstr,14);
+         RenDrawImageString(display,drawn, 10,24,numstr,14);
          sprintf(numstr,"Xm= %10.2f", XM);
-         XDrawImageString(display,drawn,the_GC,100,12,numstr,14);
+         RenDrawImageString(display,drawn,100,12,numstr,14);
          sprintf(numstr,"Ym= %10.2f", YM);
-         XDrawImageString(display,drawn,the_GC,100,24,numstr,14);
+         RenDrawImageString(display,drawn,100,24,numstr,14);
          sprintf(numstr,"Hm= %10.2f",-ZM);
-         XDrawImageString(display,drawn,the_GC,100,36,numstr,14);
+         RenDrawImageString(display,drawn,100,36,numstr,14);
          sprintf(numstr,"PSm= %8.3f",PSM);
-         XDrawImageString(display,drawn,the_GC,190,12,numstr,13);
+         RenDrawImageString(display,drawn,190,12,numstr,13);
          sprintf(numstr,"THm= %8.3f",THM);
-         XDrawImageString(display,drawn,the_GC,190,24,numstr,13);
+         RenDrawImageString(display,drawn,190,24,numstr,13);
          sprintf(numstr,"PHm= %8.3f",PHM);
-         XDrawImageString(display,drawn,the_GC,190,36,numstr,13);
+         RenDrawImageString(display,drawn,190,36,numstr,13);
          sprintf(numstr,"Xt= %10.2f", XT);
-         XDrawImageString(display,drawn,the_GC,280,12,numstr,14);
+         RenDrawImageString(display,drawn,280,12,numstr,14);
          sprintf(numstr,"Yt= %10.2f", YT);
-         XDrawImageString(display,drawn,the_GC,280,24,numstr,14);
+         RenDrawImageString(display,drawn,280,24,numstr,14);
          sprintf(numstr,"Ht= %10.2f",-ZT);
-         XDrawImageString(display,drawn,the_GC,280,36,numstr,14);
+         RenDrawImageString(display,drawn,280,36,numstr,14);
          sprintf(numstr,"PSt= %8.3f",PST);
-         XDrawImageString(display,drawn,the_GC,370,12,numstr,13);
+         RenDrawImageString(display,drawn,370,12,numstr,13);
          sprintf(numstr,"THt= %8.3f",THT);
-         XDrawImageString(display,drawn,the_GC,370,24,numstr,13);
+         RenDrawImageString(display,drawn,370,24,numstr,13);
          sprintf(numstr,"PHt= %8.3f",PHT);
-         XDrawImageString(display,drawn,the_GC,370,36,numstr,13);
+         RenDrawImageString(display,drawn,370,36,numstr,13);
 
 /*------ FRAME VIEWPORT */
-         XSetForeground(display,the_GC,pixels[White]);
-         XDrawRectangle(display,drawn,the_GC,0,0,xMax-1,yMax-1);
-
-/*------ COPY DRAWN PIXMAP TO DISPLAY WINDOW */
-         XCopyArea(display,drawn,drawable,the_GC,0,0,xMax,yMax,0,0);
+         RenSetForeground(display,White);
+         RenDrawRectangle(display,drawn,0,0,xMax-1,yMax-1);
+         TRACE_END(1);
+         BenchLap(bnHud);
+
+/*------ COMPLETE TILE-PARALLEL RASTERIZATION OF FRAME */
+         TRACE_BEG(1,"flush");
+         if ( ! RenFlush() ) {
+            printf("*** draw3D:  frame %ld is incomplete\n",frmcnt);
+            quitflag = TRUE;
+         }
+         TRACE_END(1);
+         BenchLap(bnDraw);
+
+/*------ COPY DRAWN PIXMAP OR PRESENT DRAWN FRAMEBUFFER TO DISPLAY WINDOW
+         (BACK BUFFER IS SWAPPED TO WINDOW AFTER IT IS SAVED) */
+         TRACE_BEG(1,"output");
+         if ( ( ren_MOD == 0 ) && ! dbeOn ) {
+            XCopyArea(display,drawn,drawable,the_GC,0,0,xMax,yMax,0,0);
+         } else if ( ren_MOD == 2 ) {
+            ShmPresent(display,the_GC,&fbDrawn);
+         }
 
-/*------ SAVE DRAWN PIXMAP TO X11 PIXMAP FILE */
+/*------ SAVE DRAWN PIXMAP TO X11 PIXMAP FILE AND/OR FRAME STREAM */
 
-         if ( img_OUT == 1 ) {
+         if ( ( img_OUT == 1 ) || ( strmFile != NULL ) ) {
             if ( (tsec+0.005 - last_tsec) >= img_dtsec  ) {
-               sprintf(imgout_fpath,"./Ximg/img_%04hd.xpm",img_count++);
-               XpmWriteFileFromPixmap(display,imgout_fpath,drawn,None,NULL);
+               if ( img_OUT == 1 ) {
+                  sprintf(imgout_fpath,"%s/img_%04hd.xpm",img_DIR,img_count++);
+                  WriteImage(display,imgout_fpath,drawn);
+               }
+               StreamImage(display,cmap,drawn);
                last_tsec = tsec;
             }
             if ( ktot < 0 ) {
                // Duplicate last image to ensure final frame in an animated
                // GIF or MP4 video file shows time of intercept.
-               sprintf(imgout_fpath,"./Ximg/img_%04hd.xpm",img_count);
-               XpmWriteFileFromPixmap(display,imgout_fpath,drawn,None,NULL);               
+               if ( img_OUT == 1 ) {
+                  sprintf(imgout_fpath,"%s/img_%04hd.xpm",img_DIR,img_count);
+                  WriteImage(display,imgout_fpath,drawn);
+               }
+               StreamImage(display,cmap,drawn);
             }
          }
 
-/*------ COPY BLANK PIXMAP TO DRAWN PIXMAP */
-         XCopyArea(display,blank,drawn,the_GC,0,0,xMax,yMax,0,0);
+/*------ PASS FRAME ON TO PIPELINE, COPY BLANK PIXMAP TO DRAWN PIXMAP, OR
+         SWAP AND CLEAR BACK BUFFER */
+         if ( pip.On ) {
+            if ( ! PipeSubmit() ) {
+               str_PATH = NULL;
+               quitflag = TRUE;
+            }
+         } else if ( ren_MOD != 0 ) {
+            FbCopy(&fbDrawn,&fbBlank);
+         } else if ( dbeOn ) {
+            DbeSwap(display);
+         } else {
+            XCopyArea(display,blank,drawn,the_GC,0,0,xMax,yMax,0,0);
+         }
 
-/*------ TIME DELAY */
-         do {
-            cpumsec2 = clock()/CpMsec;
-         } while ( (cpumsec2-cpumsec1) < waitmsec );
+/*------ ACCUMULATE FRAME TIME (INCLUDING X SERVER DRAWING FOR STATISTICS) */
+         if ( ( ren_MOD == 0 ) && ( sta_OUT == 1 ) ) {
+            TRACE_BEG(1,"XSync");
+            XSync(display,False);
+            TRACE_END(1);
+         }
+         TRACE_END(1);
+         frmsec = frmsec + RenSec() - tfrm;
+         frmcnt = frmcnt + 1;
+         BenchLap(bnOutput);
+         BenchFrame();
+         TRACE_END(1);
+
+/*------ SLEEP UNTIL NEXT FRAME (HEADLESS RENDERING RUNS AS FAST AS POSSIBLE) */
+         if ( ren_MOD != 1 ) {
+            TRACE_BEG(1,"SchdWait");
+            SchdWait();
+            TRACE_END(1);
+         }
 
 /*------ RESET STRING BUFFER */
          sbuff[0] = '\0';
@@ -1605,14 +2817,63 @@ void draw3D (Widget w, Display *display, Window drawable)
       }
    }
 
+/* FINISH FRAMES IN PIPELINE, UNLESS QUIT */
+
+   if ( piped ) {
+      PipeFree(quitflag);
+      if ( pip.Fail ) quitflag = TRUE;
+   }
+
 /* CLOSE TRAJECTORY DATA FILE */
 
-   fclose(lfnt);
+   TxyzClose(&trj);
+
+/* APPEND PER-STAGE FRAME TIMING OF RUN TO BENCHMARK FILE */
+
+   if ( bch_PATH != NULL ) {
+      BenchWrite(bch_PATH,(Integer)run_NUM,(Integer)msl_TYP,xMax,yMax,polcnt);
+   }
+
+/* FINISH WRITING CAPTURED IMAGES */
+
+   CapFree();
+   if ( cap.Fail ) quitflag = TRUE;
+
+/* REPORT DEPTH SORT BENCHMARK */
 
-/* FREE OFFSCREEN PIXMAPS */
+   if ( srt_BEN == 1 ) {
+      SortReport(&polSL);
+   }
+
+/* REPORT RENDERING STATISTICS */
+
+   if ( sta_OUT == 1 ) {
+      RenReport();
+      CullReport();
+      ClipReport(frmcnt);
+      GridReport();
+      ShmReport();
+      SchdReport();
+      CapReport();
+      PipeReport();
+   }
+
+/* CLOSE FRAME STREAM AFTER HEADLESS RUN, ELSE FLUSH IT FOR REPLAYS */
 
-   XFreePixmap(display,drawn);
-   XFreePixmap(display,blank);
+   if ( ren_MOD == 1 ) {
+      StrmClose();
+   } else if ( strmFile != NULL ) {
+      fflush(strmFile);
+   }
+
+/* FREE FRAMEBUFFERS (PIXMAPS AND BACK BUFFER ARE KEPT FOR REPLAYS) */
+
+   if ( ren_MOD != 0 ) {
+      if ( ren_MOD == 2 ) ShmFree(display);
+      TileFree();
+      FbFree(&fbDrawn);
+      FbFree(&fbBlank);
+   }
 
 }
 
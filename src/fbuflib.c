@@ -0,0 +1,771 @@
+/**********************************************************************/
+/* FILE:  fbuflib.c
+ * DATE:  16 OCT 2026
+ * AUTH:  G. E. Deschaines
+ * DESC:  Data structures and methods for a client-side framebuffer
+ *        and software rasterizer used to render threeD frames without
+ *        an X server.  Each framebuffer pixel holds an index into the
+ *        eight color pixels[] palette (plus the DrawingArea widget
+ *        background), and the rasterizing methods reproduce the pixel
+ *        coverage rules of the X11 sample server (mi and fb) for the
+ *        primitives threeD draws:
+ *
+ *          XFillPolygon      - convex fill with spans [ceil(xl),ceil(xr))
+ *                              over scanlines [ymin,ymax)
+ *          XDrawLines (w=0)  - Bresenham zero width lines using the
+ *                              default zero line octant bias
+ *          XDrawLines (w>0)  - wide lines as filled segment rectangles
+ *                              with CapButt ends and JoinMiter joins
+ *                              on edges offset as in miWideLine
+ *          XDrawSegments     - unjoined lines, each drawn as above
+ *          XDrawRectangle    - one pixel rectangle outline
+ *          XDrawImageString  - 6x13 "fixed" font glyphs on a filled
+ *                              background box (ascent 11, descent 2)
+ *
+ *        Only glyphs for characters which appear in the threeD HUD
+ *        text are provided; other characters render as blank cells.
+ *
+ *        A framebuffer may also hold a depth buffer of inverse view
+ *        depths.  While a depth plane is set, polygon fills and lines
+ *        only color pixels at which the plane is no farther than the
+ *        depth already stored, within a relative tolerance so that of
+ *        coplanar primitives the last drawn stays in front, as with
+ *        the painter's algorithm.
+ *
+ *        Drawing is limited to the framebuffer clip rectangle, which
+ *        is the whole framebuffer unless a view of it is made for one
+ *        screen tile.  Graphics context state is thread local, so that
+ *        tiles of one framebuffer may be rasterized concurrently and
+ *        yield exactly the pixels of unclipped single thread drawing.
+*/
+/**********************************************************************/
+
+#define fbNumClr  9  /* number of framebuffer palette colors        */
+#define fbBkgClr  8  /* palette index of DrawingArea background     */
+#define fbFntWid  6  /* fixed font character cell width  (pixels)   */
+#define fbFntAsc 11  /* fixed font ascent above baseline (pixels)   */
+#define fbFntHgt 13  /* fixed font character cell height (pixels)   */
+
+typedef struct
+{
+  Integer         Wid;
+  Integer         Hgt;
+  unsigned char  *Pix;
+  float          *Dep;  /* inverse depths, 0 for none, or NULL */
+  Integer         X0;   /* clip rectangle [X0,X1) x [Y0,Y1)    */
+  Integer         Y0;
+  Integer         X1;
+  Integer         Y1;
+} FrmBuf;
+
+typedef struct
+{
+  double  Dx;  /* edge line direction x component  */
+  double  Dy;  /* edge line direction y component  */
+  double  K;   /* edge line constant x*Dy - y*Dx   */
+  double  Y0;  /* edge starting y coordinate       */
+  double  Y1;  /* edge ending y coordinate         */
+} FbEdge;
+
+/* Palette RGB values of the X11 named colors allocated in draw3D(),
+ * in the same order as the White, Black, Red, Green, Blue, Cyan,
+ * Yellow and Brown color indices, followed by the Motif DrawingArea
+ * default background color (#c4c4c4).
+*/
+unsigned char fbRGB[fbNumClr][3] = {
+   {255, 255, 255},  /* white  */
+   {  0,   0,   0},  /* black  */
+   {255,   0,   0},  /* red    */
+   {  0, 255,   0},  /* green  */
+   {  0,   0, 255},  /* blue   */
+   {  0, 255, 255},  /* cyan   */
+   {255, 255,   0},  /* yellow */
+   {165,  42,  42},  /* brown  */
+   {196, 196, 196}   /* DrawingArea background */
+};
+
+/* Framebuffer graphics context state of calling thread. */
+
+__thread unsigned char  fbFgClr = 0;  /* foreground color index */
+__thread unsigned char  fbBgClr = 1;  /* background color index */
+__thread Integer        fbLinWid = 0; /* line width in pixels   */
+
+/* Depth plane of primitive being drawn, giving inverse view depth at
+ * pixel (x,y) as A*x + B*y + C, and relative depth test tolerance.
+*/
+__thread Boolean  fbDepTst = FALSE;
+__thread double   fbDepA, fbDepB, fbDepC;
+__thread double   fbDepTol = 0.0;
+
+/* Glyph bitmaps of the 6x13 fixed font for HUD text characters; bit 7
+ * of each row byte is the leftmost pixel of the character cell.
+*/
+static const char fbGlyphChr[] = " -.0123456789=HPSTXYZeimot";
+
+static const unsigned char fbGlyphBits[][fbFntHgt] = {
+   { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },  /* ' ' */
+   { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xF8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },  /* '-' */
+   { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x20, 0x70, 0x20, 0x00 },  /* '.' */
+   { 0x00, 0x00, 0x20, 0x50, 0x88, 0x88, 0x88, 0x88, 0x88, 0x50, 0x20, 0x00, 0x00 },  /* '0' */
+   { 0x00, 0x00, 0x20, 0x60, 0xA0, 0x20, 0x20, 0x20, 0x20, 0x20, 0xF8, 0x00, 0x00 },  /* '1' */
+   { 0x00, 0x00, 0x70, 0x88, 0x88, 0x08, 0x10, 0x20, 0x40, 0x80, 0xF8, 0x00, 0x00 },  /* '2' */
+   { 0x00, 0x00, 0xF8, 0x08, 0x10, 0x20, 0x70, 0x08, 0x08, 0x88, 0x70, 0x00, 0x00 },  /* '3' */
+   { 0x00, 0x00, 0x10, 0x10, 0x30, 0x50, 0x50, 0x90, 0xF8, 0x10, 0x10, 0x00, 0x00 },  /* '4' */
+   { 0x00, 0x00, 0xF8, 0x80, 0x80, 0xB0, 0xC8, 0x08, 0x08, 0x88, 0x70, 0x00, 0x00 },  /* '5' */
+   { 0x00, 0x00, 0x70, 0x88, 0x80, 0x80, 0xF0, 0x88, 0x88, 0x88, 0x70, 0x00, 0x00 },  /* '6' */
+   { 0x00, 0x00, 0xF8, 0x08, 0x10, 0x10, 0x20, 0x20, 0x40, 0x40, 0x40, 0x00, 0x00 },  /* '7' */
+   { 0x00, 0x00, 0x70, 0x88, 0x88, 0x88, 0x70, 0x88, 0x88, 0x88, 0x70, 0x00, 0x00 },  /* '8' */
+   { 0x00, 0x00, 0x70, 0x88, 0x88, 0x88, 0x78, 0x08, 0x08, 0x88, 0x70, 0x00, 0x00 },  /* '9' */
+   { 0x00, 0x00, 0x00, 0x00, 0x00, 0xF8, 0x00, 0x00, 0xF8, 0x00, 0x00, 0x00, 0x00 },  /* '=' */
+   { 0x00, 0x00, 0x88, 0x88, 0x88, 0x88, 0xF8, 0x88, 0x88, 0x88, 0x88, 0x00, 0x00 },  /* 'H' */
+   { 0x00, 0x00, 0xF0, 0x88, 0x88, 0x88, 0xF0, 0x80, 0x80, 0x80, 0x80, 0x00, 0x00 },  /* 'P' */
+   { 0x00, 0x00, 0x70, 0x88, 0x80, 0x80, 0x70, 0x08, 0x08, 0x88, 0x70, 0x00, 0x00 },  /* 'S' */
+   { 0x00, 0x00, 0xF8, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x00, 0x00 },  /* 'T' */
+   { 0x00, 0x00, 0x88, 0x88, 0x50, 0x50, 0x20, 0x50, 0x50, 0x88, 0x88, 0x00, 0x00 },  /* 'X' */
+   { 0x00, 0x00, 0x88, 0x88, 0x50, 0x50, 0x20, 0x20, 0x20, 0x20, 0x20, 0x00, 0x00 },  /* 'Y' */
+   { 0x00, 0x00, 0xF8, 0x08, 0x10, 0x10, 0x20, 0x40, 0x40, 0x80, 0xF8, 0x00, 0x00 },  /* 'Z' */
+   { 0x00, 0x00, 0x00, 0x00, 0x00, 0x70, 0x88, 0xF8, 0x80, 0x88, 0x70, 0x00, 0x00 },  /* 'e' */
+   { 0x00, 0x00, 0x00, 0x20, 0x00, 0x60, 0x20, 0x20, 0x20, 0x20, 0x70, 0x00, 0x00 },  /* 'i' */
+   { 0x00, 0x00, 0x00, 0x00, 0x00, 0xD0, 0xA8, 0xA8, 0xA8, 0xA8, 0x88, 0x00, 0x00 },  /* 'm' */
+   { 0x00, 0x00, 0x00, 0x00, 0x00, 0x70, 0x88, 0x88, 0x88, 0x88, 0x70, 0x00, 0x00 },  /* 'o' */
+   { 0x00, 0x00, 0x00, 0x40, 0x40, 0xF0, 0x40, 0x40, 0x40, 0x48, 0x30, 0x00, 0x00 }   /* 't' */
+};
+
+/*
+ * Allocates framebuffer pixel memory of given width and height.
+*/
+Boolean FbCreate( FrmBuf *fb, Integer wid, Integer hgt )
+{
+   fb->Wid = wid;
+   fb->Hgt = hgt;
+   fb->Dep = NULL;
+   fb->X0  = 0;
+   fb->Y0  = 0;
+   fb->X1  = wid;
+   fb->Y1  = hgt;
+   fb->Pix = (unsigned char *)malloc((size_t)wid*(size_t)hgt);
+   if ( fb->Pix == NULL ) {
+      printf("FbCreate:  malloc error for %dx%d framebuffer.\n",wid,hgt);
+      fb->Wid = 0;
+      fb->Hgt = 0;
+      return FALSE;
+   }
+   return TRUE;
+}
+
+/*
+ * Frees framebuffer pixel memory.
+*/
+void FbFree( FrmBuf *fb )
+{
+   if ( fb->Pix != NULL ) free(fb->Pix);
+   if ( fb->Dep != NULL ) free(fb->Dep);
+   fb->Pix = NULL;
+   fb->Dep = NULL;
+   fb->Wid = 0;
+   fb->Hgt = 0;
+}
+
+/*
+ * Fills entire framebuffer with given color index.
+*/
+void FbClear( FrmBuf *fb, unsigned char clr )
+{
+   memset(fb->Pix, clr, (size_t)fb->Wid*(size_t)fb->Hgt);
+}
+
+/*
+ * Allocates depth buffer for framebuffer.
+*/
+Boolean FbCreateDepth( FrmBuf *fb )
+{
+   fb->Dep = (float *)malloc((size_t)fb->Wid*(size_t)fb->Hgt*sizeof(float));
+   if ( fb->Dep == NULL ) {
+      printf("FbCreateDepth:  malloc error for %dx%d depth buffer.\n",
+             fb->Wid,fb->Hgt);
+      return FALSE;
+   }
+   return TRUE;
+}
+
+/*
+ * Sets depth buffer within clip rectangle to infinite depth.
+*/
+void FbClearDepth( FrmBuf *fb )
+{
+   Longint  y;
+
+   for ( y = fb->Y0 ; y < fb->Y1 ; y++ ) {
+      memset(&fb->Dep[y*fb->Wid + fb->X0], 0,
+             (size_t)(fb->X1 - fb->X0)*sizeof(float));
+   }
+}
+
+/*
+ * Makes view of framebuffer fb clipped to rectangle [x0,x1) x [y0,y1).
+*/
+void FbView( FrmBuf *view, FrmBuf *fb, Integer x0, Integer y0,
+                                       Integer x1, Integer y1 )
+{
+   *view    = *fb;
+   view->X0 = (Integer)lmax(x0, fb->X0);
+   view->Y0 = (Integer)lmax(y0, fb->Y0);
+   view->X1 = (Integer)lmin(x1, fb->X1);
+   view->Y1 = (Integer)lmin(y1, fb->Y1);
+}
+
+/*
+ * Sets depth plane and tolerance for depth testing primitives drawn
+ * until FbNoDepth is called.
+*/
+void FbSetDepth( double a, double b, double c, double tol )
+{
+   fbDepTst = TRUE;
+   fbDepA   = a;
+   fbDepB   = b;
+   fbDepC   = c;
+   fbDepTol = tol;
+}
+
+void FbNoDepth( void )
+{
+   fbDepTst = FALSE;
+}
+
+/*
+ * Colors pixel at offset k if depth plane value w passes depth test.
+*/
+static inline void FbDepPix( FrmBuf *fb, Longint k, float w )
+{
+   if ( w >= fb->Dep[k] - (float)fbDepTol*fb->Dep[k] ) {
+      fb->Pix[k] = fbFgClr;
+      fb->Dep[k] = w;
+   }
+}
+
+/*
+ * Copies framebuffer src pixels to framebuffer dst of same size.
+*/
+void FbCopy( FrmBuf *dst, FrmBuf *src )
+{
+   memcpy(dst->Pix, src->Pix, (size_t)src->Wid*(size_t)src->Hgt);
+}
+
+/*
+ * Sets framebuffer pixel to foreground color if inside clip rectangle.
+*/
+static inline void FbPoint( FrmBuf *fb, Longint x, Longint y )
+{
+   if ( ( x >= fb->X0 ) && ( x < fb->X1 ) && ( y >= fb->Y0 ) && ( y < fb->Y1 ) ) {
+      if ( fbDepTst ) {
+         FbDepPix(fb, y*fb->Wid + x, (float)(fbDepA*x + fbDepB*y + fbDepC));
+      } else {
+         fb->Pix[y*fb->Wid + x] = fbFgClr;
+      }
+   }
+}
+
+/*
+ * Fills half-open scanline span [x1,x2) with foreground color.  Depth
+ * plane values are evaluated at each pixel, rather than accumulated
+ * along the span, so they do not depend on where the span is clipped.
+*/
+static inline void FbSpan( FrmBuf *fb, Longint y, Longint x1, Longint x2 )
+{
+   double   w;
+   Longint  k;
+
+   if ( ( y < fb->Y0 ) || ( y >= fb->Y1 ) ) return;
+   if ( x1 < fb->X0 ) x1 = fb->X0;
+   if ( x2 > fb->X1 ) x2 = fb->X1;
+   if ( x2 <= x1 ) return;
+   if ( fbDepTst ) {
+      w = fbDepB*y + fbDepC;
+      for ( k = y*fb->Wid + x1 ; x1 < x2 ; x1++, k++ ) {
+         FbDepPix(fb, k, (float)(fbDepA*x1 + w));
+      }
+   } else {
+      memset(&fb->Pix[y*fb->Wid + x1], fbFgClr, (size_t)(x2 - x1));
+   }
+}
+
+/*
+ * Returns ceiling of n/d for d > 0 using integer arithmetic.
+*/
+static inline Longint FbCeilDiv( Longint n, Longint d )
+{
+   if ( n >= 0 ) return (n + d - 1)/d;
+   else          return -((-n)/d);
+}
+
+/*
+ * Fills convex polygon with integer vertex coordinates.  For each
+ * scanline y in [ymin,ymax) the span [ceil(xl),ceil(xr)) between
+ * left and right edge intercepts is filled, which is the pixel
+ * coverage produced by miFillConvexPoly in the X11 sample server.
+*/
+void FbFillPolygon( FrmBuf *fb, XPoint *pts, Longint npts )
+{
+   Longint  ymin, ymax, y;
+   Longint  xl, xr, xc;
+   Longint  x1, y1, x2, y2;
+   Longint  i, j;
+
+   if ( npts < 3 ) return;
+
+   ymin = pts[0].y;
+   ymax = pts[0].y;
+   for ( i = 1 ; i < npts ; i++ ) {
+      if ( pts[i].y < ymin ) ymin = pts[i].y;
+      if ( pts[i].y > ymax ) ymax = pts[i].y;
+   }
+   if ( ymin < fb->Y0 ) ymin = fb->Y0;
+   if ( ymax > fb->Y1 ) ymax = fb->Y1;
+
+   for ( y = ymin ; y < ymax ; y++ ) {
+      xl = 0x7FFFFFFF;
+      xr = -0x7FFFFFFF;
+      for ( i = 0 ; i < npts ; i++ ) {
+         j = ( i + 1 < npts ) ? i + 1 : 0;
+         if ( pts[i].y == pts[j].y ) continue;
+         if ( pts[i].y < pts[j].y ) {
+            x1 = pts[i].x; y1 = pts[i].y;
+            x2 = pts[j].x; y2 = pts[j].y;
+         } else {
+            x1 = pts[j].x; y1 = pts[j].y;
+            x2 = pts[i].x; y2 = pts[i].y;
+         }
+         if ( ( y < y1 ) || ( y >= y2 ) ) continue;
+         xc = x1 + FbCeilDiv((y - y1)*(x2 - x1), y2 - y1);
+         if ( xc < xl ) xl = xc;
+         if ( xc > xr ) xr = xc;
+      }
+      if ( xr > xl ) FbSpan(fb, y, xl, xr);
+   }
+}
+
+/*
+ * Fills convex polygon described by its edges, each lying on a line
+ * x*Dy - y*Dx = K relative to origin (xo,yo), and spanning scanlines
+ * [ceil(Y0),ceil(Y1)).  As in miPolyBuildEdge of the X11 sample
+ * server, edge intercepts are ceil((ceil(K) + y*Dx)/Dy), where the
+ * direction components Dx and Dy are integer valued.
+*/
+static void FbFillEdges( FrmBuf *fb, Longint xo, Longint yo,
+                         FbEdge *edges, Integer nedge )
+{
+   double   dx, dy, k;
+   Longint  y, ybeg, yend;
+   Longint  xl, xr, xc;
+   Integer  i;
+
+   ybeg =  0x7FFFFFFF;
+   yend = -0x7FFFFFFF;
+   for ( i = 0 ; i < nedge ; i++ ) {
+      if ( edges[i].Dy < 0.0 ) {
+         edges[i].Dx = -edges[i].Dx;
+         edges[i].Dy = -edges[i].Dy;
+         edges[i].K  = -edges[i].K;
+      }
+      if ( edges[i].Y0 > edges[i].Y1 ) {
+         k = edges[i].Y0; edges[i].Y0 = edges[i].Y1; edges[i].Y1 = k;
+      }
+      if ( edges[i].Dy == 0.0 ) continue;
+      ybeg = lmin(ybeg, (Longint)ceil(edges[i].Y0));
+      yend = lmax(yend, (Longint)ceil(edges[i].Y1));
+   }
+   ybeg = lmax(ybeg, fb->Y0 - yo);
+   yend = lmin(yend, fb->Y1 - yo);
+
+   for ( y = ybeg ; y < yend ; y++ ) {
+      xl = 0x7FFFFFFF;
+      xr = -0x7FFFFFFF;
+      for ( i = 0 ; i < nedge ; i++ ) {
+         if ( edges[i].Dy == 0.0 ) continue;
+         if ( ( y <  (Longint)ceil(edges[i].Y0) ) ||
+              ( y >= (Longint)ceil(edges[i].Y1) ) ) continue;
+         dx = edges[i].Dx;
+         dy = edges[i].Dy;
+         xc = (Longint)ceil((ceil(edges[i].K) + (double)y*dx)/dy);
+         if ( xc < xl ) xl = xc;
+         if ( xc > xr ) xr = xc;
+      }
+      if ( xr > xl ) FbSpan(fb, yo + y, xo + xl, xo + xr);
+   }
+}
+
+/*
+ * Sets edge on line through (x0,y0) with direction (dx,dy) spanning
+ * from y0 to y1.
+*/
+static inline void FbSetEdge( FbEdge *edge, double dx, double dy,
+                              double k, double y0, double y1 )
+{
+   edge->Dx = dx;
+   edge->Dy = dy;
+   edge->K  = k;
+   edge->Y0 = y0;
+   edge->Y1 = y1;
+}
+
+/*
+ * Returns number of Bresenham steps, from initial error term e with
+ * increments e1 and e3, before m minor axis steps have been taken.
+ * After k steps the minor step count is the least m for which the
+ * error term e + k*e1 + m*e3 is in [e3,0).
+*/
+static inline Longint FbZeroSteps( Longint e, Longint e1, Longint e3,
+                                   Longint m )
+{
+   if ( m <= 0 )  return 0;
+   if ( e1 == 0 ) return 0x7FFFFFFF;
+   return ((m - 1)*(-e3) - e + e1 - 1)/e1;
+}
+
+/*
+ * Draws zero width line segment from (x1,y1) to (x2,y2) with the
+ * Bresenham algorithm as implemented in the X11 sample server, with
+ * error term fixup from the default octant bias (octants 2 to 5).
+ * Only steps at which the line is within the clip rectangle are
+ * taken, the error term and coordinates being advanced over the
+ * steps before them as if they were taken.
+*/
+static void FbZeroSeg( FrmBuf *fb, Longint x1, Longint y1,
+                                   Longint x2, Longint y2, Boolean last )
+{
+   Longint  adx, ady, sdx, sdy;
+   Longint  e, e1, e3, len;
+   Longint  p, s, plo, phi;
+   Longint  q, t, qlo, qhi;
+   Longint  k0, k1, m;
+   Integer  octant = 0;
+   Integer  bias   = (1<<6) | (1<<7) | (1<<3) | (1<<4);
+   Boolean  ymajor;
+
+   adx = x2 - x1;
+   ady = y2 - y1;
+   sdx = 1;
+   sdy = 1;
+   if ( adx < 0 ) { adx = -adx; sdx = -1; octant |= 4; }
+   if ( ady < 0 ) { ady = -ady; sdy = -1; octant |= 2; }
+   if ( adx > ady ) {
+      ymajor = FALSE;
+      e1     = ady << 1;
+      e3     = (e1 - (adx << 1)) - e1;
+      e      = e1 - adx;
+      len    = adx;
+   } else {
+      ymajor = TRUE;
+      e1     = adx << 1;
+      e3     = (e1 - (ady << 1)) - e1;
+      e      = e1 - ady;
+      octant |= 1;
+      len    = ady;
+   }
+   e -= ( bias >> octant ) & 1;
+   e -= e1;
+   if ( last ) len++;
+
+   if ( ymajor ) {
+      p = y1; s = sdy; plo = fb->Y0; phi = fb->Y1;
+      q = x1; t = sdx; qlo = fb->X0; qhi = fb->X1;
+   } else {
+      p = x1; s = sdx; plo = fb->X0; phi = fb->X1;
+      q = y1; t = sdy; qlo = fb->Y0; qhi = fb->Y1;
+   }
+   k0 = ( s > 0 ) ? plo - p : p - phi + 1;
+   k1 = ( s > 0 ) ? phi - p : p - plo + 1;
+   k0 = lmax(k0, FbZeroSteps(e, e1, e3, ( t > 0 ) ? qlo - q : q - qhi + 1));
+   k1 = lmin(k1, FbZeroSteps(e, e1, e3, ( t > 0 ) ? qhi - q : q - qlo + 1));
+   if ( len > k1 ) len = k1;
+   if ( k0 >= len ) return;
+   if ( k0 > 0 ) {
+      e = e + k0*e1;
+      m = ( e >= 0 ) ? e/(-e3) + 1 : 0;
+      e = e + m*e3;
+      if ( ymajor ) { y1 += k0*sdy; x1 += m*sdx; }
+      else          { x1 += k0*sdx; y1 += m*sdy; }
+      len -= k0;
+   }
+
+   while ( len-- > 0 ) {
+      FbPoint(fb, x1, y1);
+      if ( ymajor ) y1 += sdy;
+      else          x1 += sdx;
+      e += e1;
+      if ( e >= 0 ) {
+         if ( ymajor ) x1 += sdx;
+         else          y1 += sdy;
+         e += e3;
+      }
+   }
+}
+
+/*
+ * Draws wide line segment from a to b as a filled rectangle of the
+ * current line width with CapButt ends.  Horizontal and vertical
+ * segments are filled as pixel aligned rectangles, and the sides of
+ * slanted segments lie on lines offset +/- (width/2)*length from
+ * the segment, as in miWideSegment of the X11 sample server.
+*/
+static void FbWideSeg( FrmBuf *fb, XPoint a, XPoint b )
+{
+   Longint  dx, dy, hw;
+   Longint  y;
+   double   L, k, py;
+   FbEdge   edges[4];
+
+   dx = b.x - a.x;
+   dy = b.y - a.y;
+   hw = fbLinWid >> 1;
+   if ( ( dx == 0 ) && ( dy == 0 ) ) return;
+   if ( dy == 0 ) {
+      for ( y = a.y - hw ; y < a.y - hw + fbLinWid ; y++ ) {
+         FbSpan(fb, y, lmin(a.x,b.x), lmax(a.x,b.x));
+      }
+      return;
+   }
+   if ( dx == 0 ) {
+      for ( y = lmin(a.y,b.y) ; y < lmax(a.y,b.y) ; y++ ) {
+         FbSpan(fb, y, a.x - hw, a.x - hw + fbLinWid);
+      }
+      return;
+   }
+
+   L  = hypot((double)dx, (double)dy);
+   k  = (fbLinWid/2.0)*L;
+   py = dx*(fbLinWid/2.0)/L;
+
+   FbSetEdge(&edges[0], dx, dy, -k, py,      dy + py);  /* side at +p */
+   FbSetEdge(&edges[1], dx, dy,  k, -py,     dy - py);  /* side at -p */
+   FbSetEdge(&edges[2], -dy, dx, 0.0, py,    -py);      /* start cap  */
+   FbSetEdge(&edges[3], -dy, dx, (double)(dx*dx + dy*dy),
+             dy + py, dy - py);                         /* end cap    */
+   FbFillEdges(fb, a.x, a.y, edges, 4);
+}
+
+/*
+ * Fills JoinMiter join between wide line segments a-b and b-c at b,
+ * reverting to a bevel join when the interior angle is less than the
+ * X11 miter limit of 11 degrees.  The outer edges of the join lie on
+ * the sides of the joined segments.
+*/
+static void FbWideJoin( FrmBuf *fb, XPoint a, XPoint b, XPoint c )
+{
+   Longint  d1x, d1y, d2x, d2y;
+   double   l1, l2, hw, crs, cosa, t;
+   double   n1x, n1y, n2x, n2y;
+   double   k1, k2, my;
+   FbEdge   edges[4];
+
+   d1x = b.x - a.x;
+   d1y = b.y - a.y;
+   d2x = c.x - b.x;
+   d2y = c.y - b.y;
+   if ( ( ( d1x == 0 ) && ( d1y == 0 ) ) ||
+        ( ( d2x == 0 ) && ( d2y == 0 ) ) ) return;
+   crs = (double)d1x*d2y - (double)d1y*d2x;
+   if ( crs == 0.0 ) return;
+   l1  = hypot((double)d1x, (double)d1y);
+   l2  = hypot((double)d2x, (double)d2y);
+   hw  = fbLinWid/2.0;
+
+   /* Offset normals on the outside of the turn. */
+   if ( crs > 0.0 ) {
+      n1x =  d1y*hw/l1; n1y = -d1x*hw/l1; k1 =  hw*l1;
+      n2x =  d2y*hw/l2; n2y = -d2x*hw/l2; k2 =  hw*l2;
+   } else {
+      n1x = -d1y*hw/l1; n1y =  d1x*hw/l1; k1 = -hw*l1;
+      n2x = -d2y*hw/l2; n2y =  d2x*hw/l2; k2 = -hw*l2;
+   }
+
+   cosa = -((double)d1x*d2x + (double)d1y*d2y)/(l1*l2);
+   if ( cosa < cos(11.0*0.01745329) ) {
+      /* Miter point at intersection of the outer segment sides. */
+      t  = ((n2x - n1x)*d2y - (n2y - n1y)*d2x)/crs;
+      my = n1y + t*d1y;
+      FbSetEdge(&edges[0], -d1y, d1x, 0.0, 0.0, n1y);
+      FbSetEdge(&edges[1], d1x, d1y, k1, n1y, my);
+      FbSetEdge(&edges[2], d2x, d2y, k2, my, n2y);
+      FbSetEdge(&edges[3], -d2y, d2x, 0.0, n2y, 0.0);
+      FbFillEdges(fb, b.x, b.y, edges, 4);
+   } else {
+      FbSetEdge(&edges[0], -d1y, d1x, 0.0, 0.0, n1y);
+      FbSetEdge(&edges[1], n2x - n1x, n2y - n1y,
+                n1x*(n2y - n1y) - n1y*(n2x - n1x), n1y, n2y);
+      FbSetEdge(&edges[2], -d2y, d2x, 0.0, n2y, 0.0);
+      FbFillEdges(fb, b.x, b.y, edges, 3);
+   }
+}
+
+/*
+ * Draws connected lines through given points with current line width.
+ * Zero length segments of wide lines are skipped, and joins are made
+ * between consecutive drawn segments, including the join between the
+ * last and first segments when the line closes on its first point.
+*/
+void FbDrawLines( FrmBuf *fb, XPoint *pts, Longint npts )
+{
+   Longint  i;
+   Longint  ifst, iprv;
+
+   if ( npts < 2 ) return;
+
+   if ( fbLinWid == 0 ) {
+      for ( i = 1 ; i < npts ; i++ ) {
+         FbZeroSeg(fb, pts[i-1].x, pts[i-1].y, pts[i].x, pts[i].y,
+                   (Boolean)( i == npts-1 ));
+      }
+   } else {
+      ifst = 0;
+      iprv = 0;
+      for ( i = 1 ; i < npts ; i++ ) {
+         if ( ( pts[i].x == pts[i-1].x ) && ( pts[i].y == pts[i-1].y ) ) {
+            continue;
+         }
+         FbWideSeg(fb, pts[i-1], pts[i]);
+         if ( iprv > 0 ) {
+            FbWideJoin(fb, pts[iprv-1], pts[i-1], pts[i]);
+         } else {
+            ifst = i;
+         }
+         iprv = i;
+      }
+      if ( ( iprv > 0 ) &&
+           ( pts[0].x == pts[npts-1].x ) && ( pts[0].y == pts[npts-1].y ) ) {
+         FbWideJoin(fb, pts[iprv-1], pts[iprv], pts[ifst]);
+      }
+   }
+}
+
+/*
+ * Draws unconnected line segments with current line width, each
+ * including its last point when zero width.
+*/
+void FbDrawSegments( FrmBuf *fb, XSegment *segs, Longint nsegs )
+{
+   XPoint   a, b;
+   Longint  i;
+
+   for ( i = 0 ; i < nsegs ; i++ ) {
+      if ( fbLinWid == 0 ) {
+         FbZeroSeg(fb, segs[i].x1, segs[i].y1, segs[i].x2, segs[i].y2, TRUE);
+      } else {
+         a.x = segs[i].x1; a.y = segs[i].y1;
+         b.x = segs[i].x2; b.y = segs[i].y2;
+         FbWideSeg(fb, a, b);
+      }
+   }
+}
+
+/*
+ * Draws one pixel wide outline of rectangle with upper left corner
+ * at (x,y), covering pixels x to x+w and y to y+h inclusive.
+*/
+void FbDrawRectangle( FrmBuf *fb, Integer x, Integer y,
+                                  Integer w, Integer h )
+{
+   Longint  i;
+
+   FbSpan(fb, y,   x, x+w+1);
+   FbSpan(fb, y+h, x, x+w+1);
+   for ( i = lmax(y+1, fb->Y0) ; i < lmin(y+h, fb->Y1) ; i++ ) {
+      FbPoint(fb, x,   i);
+      FbPoint(fb, x+w, i);
+   }
+}
+
+/*
+ * Draws text string with baseline starting at (x,y) in foreground
+ * color over a background color filled character cell box.
+*/
+void FbDrawImageString( FrmBuf *fb, Integer x, Integer y,
+                        const char *str, Integer len )
+{
+   const char  *cp;
+   Longint      r, c, row, col;
+   Integer      i, g;
+   unsigned char  bits;
+
+   for ( i = 0 ; i < len ; i++ ) {
+      cp = ( str[i] != '\0' ) ? strchr(fbGlyphChr, str[i]) : NULL;
+      g  = ( cp != NULL ) ? (Integer)(cp - fbGlyphChr) : 0;
+      for ( r = 0 ; r < fbFntHgt ; r++ ) {
+         row  = y - fbFntAsc + r;
+         if ( ( row < fb->Y0 ) || ( row >= fb->Y1 ) ) continue;
+         bits = fbGlyphBits[g][r];
+         for ( c = 0 ; c < fbFntWid ; c++ ) {
+            col = x + i*fbFntWid + c;
+            if ( ( col < fb->X0 ) || ( col >= fb->X1 ) ) continue;
+            fb->Pix[row*fb->Wid + col] = ( bits & (0x80 >> c) ) ? fbFgClr
+                                                                 : fbBgClr;
+         }
+      }
+   }
+}
+
+/*
+ * Converts framebuffer color indices to packed RGB24 pixels.
+*/
+void FbToRGB( FrmBuf *fb, unsigned char *rgb )
+{
+   Longint  i, n;
+
+   n = (Longint)fb->Wid*fb->Hgt;
+   for ( i = 0 ; i < n ; i++ ) {
+      memcpy(rgb + 3*i, fbRGB[fb->Pix[i]], 3);
+   }
+}
+
+/*
+ * Writes framebuffer to X11 pixmap (XPM) file with given palette RGB
+ * values.
+*/
+Boolean FbWriteXPMRGB( FrmBuf *fb, const char *fpath,
+                       unsigned char rgb[fbNumClr][3] )
+{
+   FILE     *lfno;
+   char     *line;
+   Longint   x, y;
+   Integer   i;
+
+   lfno = fopen(fpath,"w");
+   if ( lfno == NULL ) {
+      printf("FbWriteXPMRGB:  fopen error for file %s.\n",fpath);
+      return FALSE;
+   }
+   line = (char *)malloc((size_t)fb->Wid + 4);
+   if ( line == NULL ) {
+      printf("FbWriteXPMRGB:  malloc error for %d pixel line.\n",fb->Wid);
+      fclose(lfno);
+      remove(fpath);
+      return FALSE;
+   }
+   fprintf(lfno,"/* XPM */\nstatic char * image_name[] = {\n");
+   fprintf(lfno,"\"%d %d %d 1\",\n",fb->Wid,fb->Hgt,fbNumClr);
+   for ( i = 0 ; i < fbNumClr ; i++ ) {
+      fprintf(lfno,"\"%c c #%02X%02X%02X\",\n",'a'+i,
+              rgb[i][0],rgb[i][1],rgb[i][2]);
+   }
+   for ( y = 0 ; y < fb->Hgt ; y++ ) {
+      for ( x = 0 ; x < fb->Wid ; x++ ) {
+         line[x] = 'a' + fb->Pix[y*fb->Wid + x];
+      }
+      line[fb->Wid] = '\0';
+      fprintf(lfno,"\"%s\"%s\n",line,(y < fb->Hgt-1) ? "," : "};");
+   }
+   free(line);
+   fclose(lfno);
+   return TRUE;
+}
+
+/*
+ * Writes framebuffer pixels to an X11 pixmap (XPM) file.
+*/
+Boolean FbWriteXPM( FrmBuf *fb, const char *fpath )
+{
+   return FbWriteXPMRGB(fb, fpath, fbRGB);
+}
+
+/**********************************************************************/
+/**********************************************************************/
@@ -0,0 +1,441 @@
+/**********************************************************************/
+/* FILE:  packlib.c
+ * DATE:  16 OCT 2026
+ * AUTH:  G. E. Deschaines
+ * DESC:  Data structures and methods to compile the ./dat polygon
+ *        model files into one binary model pack, ./dat/models.pak,
+ *        and to load models from the memory mapped pack instead of
+ *        parsing the model files.
+ *
+ *        With the "-topak" option, each model file is loaded with
+ *        LoadPoly as for rendering, and the polygons and vertice it
+ *        makes are written to the pack as one section.  The pack,
+ *        written in native byte order, holds a header, a table of
+ *        sections, one record per polygon and one array (column) per
+ *        polygon centroid or normal component and vertex coordinate.
+ *
+ *          PackHdr   header
+ *          PackSec   sections[nsec]   model file path, size, mod time
+ *                                     and ranges of its polygons and
+ *                                     vertice
+ *          PackPol   polygons[npol]   priority, color, type, visibility,
+ *                                     vertex offset and count
+ *          Extended  CX[npol], CY[npol], CZ[npol],  model centroids
+ *                    NX[npol], NY[npol], NZ[npol]   model unit normals
+ *          Extended  X[nvtx], Y[nvtx], Z[nvtx]      offset and scaled
+ *                                                   model vertice
+ *
+ *        LoadModels asks PackPoly for each model file first.  The pack
+ *        is mapped read-only, so concurrent threeD processes share its
+ *        pages, and a section is copied directly into the polygon list,
+ *        vertex store and centroid and normal store, with no parsing,
+ *        scaling, or centroid and normal computation.  Since the values
+ *        were made by the same LoadPoly and MakePol code, they are the
+ *        same as those of parsing the file.  A model file which is not
+ *        in the pack, or whose size or modification time differs from
+ *        that of the packed file, is parsed instead.
+*/
+/**********************************************************************/
+
+#define PackMagic  "MDLPACK\n"
+#define PackVer    1
+#define PackBom    0x01020304
+#define PackPath   "./dat/models.pak"
+#define PackNctr   6   /* centroid and normal columns  */
+#define PackNvtx   3   /* vertex coordinate columns    */
+#define PackNsrc   5   /* number of model files        */
+
+typedef struct
+{
+  char      Mag[8];  /* PackMagic                     */
+  uint32_t  Ver;     /* PackVer                       */
+  uint32_t  Bom;     /* PackBom in native byte order  */
+  uint32_t  Nsec;    /* number of model file sections */
+  uint32_t  Pad;
+  int64_t   Npol;    /* number of polygons            */
+  int64_t   Nvtx;    /* number of vertice             */
+} PackHdr;
+
+typedef struct
+{
+  char      Path[32];  /* model file path                       */
+  int64_t   Siz;       /* model file size                       */
+  int64_t   Mtm;       /* model file mod time                   */
+  int64_t   Pol1;      /* index of first polygon record         */
+  int64_t   Npol;      /* number of polygons                    */
+  int64_t   Vtx1;      /* index of first vertex                 */
+  int64_t   Nvtx;      /* number of vertice                     */
+} PackSec;
+
+typedef struct
+{
+  int64_t   Pri;   /* polygon priority code                     */
+  int64_t   Voff;  /* offset of first vertice in section        */
+  int32_t   Vcnt;  /* number of polygon vertice                 */
+  int32_t   Pat;   /* polygon color                             */
+  int16_t   Typ;   /* polygon type                              */
+  int16_t   Vis;   /* polygon visibility (> 0 filled)           */
+  int32_t   Pad;
+} PackPol;
+
+typedef struct
+{
+  unsigned char  *Map;              /* mapped pack file          */
+  size_t          Len;              /* mapped pack file length   */
+  const PackHdr  *Hdr;
+  const PackSec  *Sec;
+  const PackPol  *Pol;
+  const Extended *Ctr[PackNctr];
+  const Extended *Vtx[PackNvtx];
+} Pack;
+
+Pack  pack;
+
+static const char *packSrc[PackNsrc] = {
+   "./dat/grndpoly1.dat", "./dat/grndpoly2.dat", "./dat/fwngpoly.dat",
+   "./dat/mislpoly1.dat", "./dat/mislpoly2.dat"
+};
+
+void LoadPoly ( FILE *lfni, const char* polyfile );
+
+/*
+ * RETURNS BYTE OFFSET OF POLYGON RECORDS
+*/
+static size_t PackPolOff( Longint nsec )
+{
+   return sizeof(PackHdr) + nsec*sizeof(PackSec);
+}
+
+/*
+ * RETURNS BYTE OFFSET OF CENTROID OR NORMAL COLUMN k
+*/
+static size_t PackCtrOff( Longint nsec, Longint npol, Integer k )
+{
+   return PackPolOff(nsec) + npol*sizeof(PackPol) + k*npol*sizeof(Extended);
+}
+
+/*
+ * RETURNS BYTE OFFSET OF VERTEX COORDINATE COLUMN k (k = PackNvtx
+ * GIVES PACK LENGTH)
+*/
+static size_t PackVtxOff( Longint nsec, Longint npol, Longint nvtx, Integer k )
+{
+   return PackCtrOff(nsec,npol,PackNctr) + k*nvtx*sizeof(Extended);
+}
+
+/*
+ * CHECKS SECTION AND POLYGON RANGES OF MAPPED PACK
+*/
+static Boolean PackValid( void )
+{
+   const PackHdr  *hdr = pack.Hdr;
+   const PackSec  *sec;
+   const PackPol  *pol;
+   Longint         i, k;
+
+   if ( ( pack.Len < sizeof(PackHdr) ) ||
+        ( memcmp(hdr->Mag, PackMagic, 8) != 0 ) ||
+        ( hdr->Ver != PackVer ) || ( hdr->Bom != PackBom ) ||
+        ( hdr->Npol < 0 ) || ( hdr->Nvtx < 0 ) ||
+        ( PackVtxOff(hdr->Nsec,hdr->Npol,hdr->Nvtx,PackNvtx) != pack.Len ) ) {
+      return FALSE;
+   }
+   for ( k = 0 ; k < hdr->Nsec ; k++ ) {
+      sec = &pack.Sec[k];
+      if ( ( memchr(sec->Path, '\0', sizeof(sec->Path)) == NULL ) ||
+           ( sec->Pol1 < 0 ) || ( sec->Npol < 0 ) ||
+           ( sec->Pol1 + sec->Npol > hdr->Npol ) ||
+           ( sec->Vtx1 < 0 ) || ( sec->Nvtx < 0 ) ||
+           ( sec->Vtx1 + sec->Nvtx > hdr->Nvtx ) ) {
+         return FALSE;
+      }
+      for ( i = sec->Pol1 ; i < sec->Pol1 + sec->Npol ; i++ ) {
+         pol = &pack.Pol[i];
+         if ( ( pol->Voff < 0 ) || ( pol->Vcnt < 2 ) ||
+              ( pol->Voff + pol->Vcnt > sec->Nvtx ) ) {
+            return FALSE;
+         }
+      }
+   }
+   return TRUE;
+}
+
+/*
+ * UNMAPS MODEL PACK
+*/
+void PackClose( void )
+{
+   if ( pack.Map != NULL ) munmap(pack.Map, pack.Len);
+   memset(&pack, 0, sizeof(pack));
+}
+
+/*
+ * MAPS MODEL PACK, IF ANY, FOR LOADING MODELS WITH PackPoly
+*/
+void PackOpen( void )
+{
+   struct stat  sbuf;
+   Longint      n;
+   Integer      k;
+   int          fd;
+
+   memset(&pack, 0, sizeof(pack));
+   fd = open(PackPath, O_RDONLY);
+   if ( fd < 0 ) return;
+#if DBG_LVL > 0
+   printf("PackOpen:  Mapping model pack %s\n",PackPath);
+#endif
+   if ( ( fstat(fd, &sbuf) == 0 ) && ( sbuf.st_size > 0 ) ) {
+      pack.Len = (size_t)sbuf.st_size;
+      pack.Map = (unsigned char *)mmap(NULL, pack.Len, PROT_READ,
+                                       MAP_PRIVATE, fd, 0);
+      if ( pack.Map == (unsigned char *)MAP_FAILED ) pack.Map = NULL;
+   }
+   close(fd);
+   if ( pack.Map == NULL ) {
+      memset(&pack, 0, sizeof(pack));
+      return;
+   }
+
+   pack.Hdr = (const PackHdr *)pack.Map;
+   if ( pack.Len >= sizeof(PackHdr) ) {
+      n        = pack.Hdr->Npol;
+      pack.Sec = (const PackSec *)(pack.Map + sizeof(PackHdr));
+      pack.Pol = (const PackPol *)(pack.Map + PackPolOff(pack.Hdr->Nsec));
+      for ( k = 0 ; k < PackNctr ; k++ ) {
+         pack.Ctr[k] = (const Extended *)(pack.Map +
+                                          PackCtrOff(pack.Hdr->Nsec,n,k));
+      }
+      for ( k = 0 ; k < PackNvtx ; k++ ) {
+         pack.Vtx[k] = (const Extended *)(pack.Map +
+                       PackVtxOff(pack.Hdr->Nsec,n,pack.Hdr->Nvtx,k));
+      }
+   }
+   if ( ! PackValid() ) {
+      printf("PackOpen:  invalid model pack %s.\n",PackPath);
+      PackClose();
+   }
+}
+
+/*
+ * LOADS POLYGONS AND OBJECTS OF MODEL FILE fpath FROM ITS PACK SECTION,
+ * RETURNING FALSE IF THE FILE IS TO BE PARSED INSTEAD
+*/
+Boolean PackPoly( const char *fpath )
+{
+   const PackSec  *sec = NULL;
+   const PackPol  *rec;
+   Pol3D          *pol;
+   struct stat     sbuf;
+   Extended       *dst0[PackNctr];
+   Extended       *dst1[PackNctr];
+   Extended       *vtx0[PackNvtx];
+   Extended       *vtx1[PackNvtx];
+   Extended       *vtx2[PackNvtx];
+   Longint         iPol1 = polcnt + 1;
+   Longint         voff  = vtxlist.Cnt;
+   Longint         i, npol, nvtx;
+   Integer         k;
+
+   if ( pack.Map == NULL ) return FALSE;
+   for ( k = 0 ; k < pack.Hdr->Nsec ; k++ ) {
+      if ( strcmp(pack.Sec[k].Path, fpath) == 0 ) {
+         sec = &pack.Sec[k];
+         break;
+      }
+   }
+   if ( sec == NULL ) return FALSE;
+   if ( ( stat(fpath, &sbuf) == 0 ) &&
+        ( ( (int64_t)sbuf.st_size  != sec->Siz ) ||
+          ( (int64_t)sbuf.st_mtime != sec->Mtm ) ) ) {
+      printf("PackPoly:  %s changed since packed; parsing it (rerun -topak).\n",fpath);
+      return FALSE;
+   }
+#if DBG_LVL > 0
+   printf("PackPoly:  Loading %ld polygons of %s from model pack\n",
+          (Longint)sec->Npol,fpath);
+#endif
+   npol = sec->Npol;
+   nvtx = sec->Nvtx;
+   if ( npol == 0 ) return TRUE;
+   if ( ! GrowPol(polcnt + npol) ) return TRUE;
+   if ( ! GrowVtx(vtxlist.Cnt + nvtx) ) return TRUE;
+
+/* Copy model vertice, also as world vertice. */
+
+   vtx0[0] = vtxlist.X0;  vtx0[1] = vtxlist.Y0;  vtx0[2] = vtxlist.Z0;
+   vtx1[0] = vtxlist.X1;  vtx1[1] = vtxlist.Y1;  vtx1[2] = vtxlist.Z1;
+   vtx2[0] = vtxlist.X2;  vtx2[1] = vtxlist.Y2;  vtx2[2] = vtxlist.Z2;
+   for ( k = 0 ; k < PackNvtx ; k++ ) {
+      memcpy(vtx0[k] + voff, pack.Vtx[k] + sec->Vtx1, nvtx*sizeof(Extended));
+      memcpy(vtx1[k] + voff, pack.Vtx[k] + sec->Vtx1, nvtx*sizeof(Extended));
+      memset(vtx2[k] + voff, 0, nvtx*sizeof(Extended));
+   }
+   vtxlist.Cnt = vtxlist.Cnt + nvtx;
+
+/* Copy model centroids and normals, also as world centroids and normals. */
+
+   dst0[0] = ctrlist.CX0;  dst0[1] = ctrlist.CY0;  dst0[2] = ctrlist.CZ0;
+   dst0[3] = ctrlist.NX0;  dst0[4] = ctrlist.NY0;  dst0[5] = ctrlist.NZ0;
+   dst1[0] = ctrlist.CX1;  dst1[1] = ctrlist.CY1;  dst1[2] = ctrlist.CZ1;
+   dst1[3] = ctrlist.NX1;  dst1[4] = ctrlist.NY1;  dst1[5] = ctrlist.NZ1;
+   for ( k = 0 ; k < PackNctr ; k++ ) {
+      memcpy(dst0[k] + iPol1, pack.Ctr[k] + sec->Pol1, npol*sizeof(Extended));
+      memcpy(dst1[k] + iPol1, pack.Ctr[k] + sec->Pol1, npol*sizeof(Extended));
+   }
+
+/* Make polygon list entries. */
+
+   for ( i = 0 ; i < npol ; i++ ) {
+      rec       = &pack.Pol[sec->Pol1 + i];
+      pol       = &pollist[iPol1 + i];
+      pol->Flg  = FALSE;
+      pol->Pri  = (Longint)rec->Pri;
+      pol->Pat  = (Word)rec->Pat;
+      pol->Typ  = (Integer)rec->Typ;
+      pol->Vis  = (Integer)rec->Vis;
+      pol->Voff = voff + (Longint)rec->Voff;
+      pol->Vcnt = (Longint)rec->Vcnt;
+   }
+   polcnt = polcnt + npol;
+
+/* Make objects from loaded polygons. */
+
+   MakeObj(iPol1, polcnt);
+   return TRUE;
+}
+
+/*
+ * COMPILES ./dat POLYGON MODEL FILES INTO MODEL PACK ./dat/models.pak
+*/
+Boolean PackWrite( void )
+{
+   char         tpath[48];
+   FILE        *lfni;
+   FILE        *lfno;
+   struct stat  sbuf;
+   PackHdr      hdr;
+   PackSec      sec[PackNsrc];
+   PackPol     *rec = NULL;
+   Longint      mrec = 0;
+   Extended    *col[PackNctr+PackNvtx];
+   Longint      mcol[PackNctr+PackNvtx];
+   Extended    *src[PackNctr+PackNvtx];
+   Longint      nsec = 0, npol = 0, nvtx = 0;
+   Longint      i, n;
+   Integer      k, m;
+   Boolean      okay = TRUE;
+
+   memset(col, 0, sizeof(col));
+   memset(mcol, 0, sizeof(mcol));
+
+/* Load each model file by itself and append its polygons and vertice. */
+
+   for ( m = 0 ; okay && ( m < PackNsrc ) ; m++ ) {
+      lfni = fopen(packSrc[m],"r");
+      if ( lfni == NULL ) continue;
+      if ( fstat(fileno(lfni), &sbuf) != 0 ) {
+         fclose(lfni);
+         continue;
+      }
+      polcnt      = 0;
+      objcnt      = 0;
+      vtxlist.Cnt = 0;
+      LoadPoly(lfni,packSrc[m]);
+      fclose(lfni);
+
+      memset(&sec[nsec], 0, sizeof(PackSec));
+      strncpy(sec[nsec].Path, packSrc[m], sizeof(sec[nsec].Path)-1);
+      sec[nsec].Siz  = (int64_t)sbuf.st_size;
+      sec[nsec].Mtm  = (int64_t)sbuf.st_mtime;
+      sec[nsec].Pol1 = npol;
+      sec[nsec].Npol = polcnt;
+      sec[nsec].Vtx1 = nvtx;
+      sec[nsec].Nvtx = vtxlist.Cnt;
+
+      okay = GrowList((void **)&rec, &mrec, npol+polcnt, sizeof(PackPol), maxpol);
+      for ( k = 0 ; okay && ( k < PackNctr+PackNvtx ) ; k++ ) {
+         n    = ( k < PackNctr ) ? npol+polcnt : nvtx+vtxlist.Cnt;
+         okay = GrowList((void **)&col[k], &mcol[k], n, sizeof(Extended), maxpol);
+      }
+      if ( ! okay ) break;
+
+      for ( i = 1 ; i <= polcnt ; i++ ) {
+         memset(&rec[npol+i-1], 0, sizeof(PackPol));
+         rec[npol+i-1].Pri  = (int64_t)pollist[i].Pri;
+         rec[npol+i-1].Voff = (int64_t)pollist[i].Voff;
+         rec[npol+i-1].Vcnt = (int32_t)pollist[i].Vcnt;
+         rec[npol+i-1].Pat  = (int32_t)pollist[i].Pat;
+         rec[npol+i-1].Typ  = (int16_t)pollist[i].Typ;
+         rec[npol+i-1].Vis  = (int16_t)pollist[i].Vis;
+      }
+      src[0] = ctrlist.CX0;  src[1] = ctrlist.CY0;  src[2] = ctrlist.CZ0;
+      src[3] = ctrlist.NX0;  src[4] = ctrlist.NY0;  src[5] = ctrlist.NZ0;
+      src[6] = vtxlist.X0;   src[7] = vtxlist.Y0;   src[8] = vtxlist.Z0;
+      for ( k = 0 ; k < PackNctr ; k++ ) {
+         if ( polcnt > 0 ) {
+            memcpy(col[k] + npol, src[k] + 1, polcnt*sizeof(Extended));
+         }
+      }
+      for ( k = PackNctr ; k < PackNctr+PackNvtx ; k++ ) {
+         if ( vtxlist.Cnt > 0 ) {
+            memcpy(col[k] + nvtx, src[k], vtxlist.Cnt*sizeof(Extended));
+         }
+      }
+      printf("PackWrite:  %s - %ld polygons, %ld vertice\n",
+             packSrc[m],polcnt,vtxlist.Cnt);
+      npol = npol + polcnt;
+      nvtx = nvtx + vtxlist.Cnt;
+      nsec = nsec + 1;
+   }
+   polcnt      = 0;
+   objcnt      = 0;
+   vtxlist.Cnt = 0;
+
+/* Write pack, renamed into place so readers never see a partial file. */
+
+   if ( okay && ( nsec == 0 ) ) {
+      printf("PackWrite:  no model files found in ./dat.\n");
+      okay = FALSE;
+   }
+   sprintf(tpath,"%s.%ld",PackPath,(long)getpid());
+   lfno = okay ? fopen(tpath,"wb") : NULL;
+   if ( okay && ( lfno == NULL ) ) {
+      printf("PackWrite:  fopen error for model pack %s.\n",tpath);
+      okay = FALSE;
+   }
+   if ( okay ) {
+      memset(&hdr, 0, sizeof(hdr));
+      memcpy(hdr.Mag, PackMagic, 8);
+      hdr.Ver  = PackVer;
+      hdr.Bom  = PackBom;
+      hdr.Nsec = (uint32_t)nsec;
+      hdr.Npol = (int64_t)npol;
+      hdr.Nvtx = (int64_t)nvtx;
+      fwrite(&hdr, sizeof(hdr), 1, lfno);
+      fwrite(sec, sizeof(PackSec), nsec, lfno);
+      fwrite(rec, sizeof(PackPol), npol, lfno);
+      for ( k = 0 ; k < PackNctr ; k++ ) {
+         fwrite(col[k], sizeof(Extended), npol, lfno);
+      }
+      for ( k = PackNctr ; k < PackNctr+PackNvtx ; k++ ) {
+         fwrite(col[k], sizeof(Extended), nvtx, lfno);
+      }
+      okay = ( ferror(lfno) == 0 );
+      okay = ( fclose(lfno) == 0 ) && okay;
+      if ( okay && ( rename(tpath, PackPath) != 0 ) ) {
+         printf("PackWrite:  rename error for model pack %s.\n",PackPath);
+         okay = FALSE;
+      }
+      if ( ! okay ) {
+         remove(tpath);
+      } else {
+         printf("PackWrite:  wrote %ld sections, %ld polygons, %ld vertice to %s\n",
+                nsec,npol,nvtx,PackPath);
+      }
+   }
+
+   free(rec);
+   for ( k = 0 ; k < PackNctr+PackNvtx ; k++ ) free(col[k]);
+   return okay;
+}
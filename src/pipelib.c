@@ -0,0 +1,556 @@
+/**********************************************************************/
+/* FILE:  pipelib.c
+ * DATE:  16 OCT 2026
+ * AUTH:  G. E. Deschaines
+ * DESC:  Frame pipeline of headless rendering across threads.
+ *
+ *        With the "-pipeline" option, headless frames (ren_MOD=1) are
+ *        produced by four stages running concurrently on their own
+ *        threads, so record N+1 is parsed and transformed while frame
+ *        N is rasterized and frame N-1 is written:
+ *
+ *          parse      reads trajectory records (or fixed rate frames)
+ *          transform  places, culls, orders and transforms the scene
+ *                     of each record in draw3D(), and records its
+ *                     primitives in the display list of a frame
+ *          raster     rasterizes each frame's display list into the
+ *                     frame's framebuffer through tilelib (with any
+ *                     tile worker threads)
+ *          output     writes each frame to XPM files (or queues it
+ *                     for caplib writer threads) and the frame stream,
+ *                     and clears it for reuse
+ *
+ *        Stages are joined by lock-free single-producer, single-
+ *        consumer ring buffers: parsed records flow from parse to
+ *        transform, frames from transform to raster to output, and
+ *        written frames back from output to transform for reuse.  A
+ *        fixed number of frames circulate, bounding the frames in
+ *        flight.  Each ring keeps its items in order and each stage
+ *        is one thread, so frames are written in record order, and
+ *        since frames are rasterized from display lists exactly as
+ *        with tiled rasterization, they are identical to frames drawn
+ *        without the pipeline.
+ *
+ *        A stage waiting on a full output ring or an empty input ring
+ *        spins briefly, then yields, then sleeps on the ring's condition
+ *        variable until the other end pushes or pops an item, so idle
+ *        stages (as with "-follow" on a quiet FIFO) use no CPU time.
+ *        Pushes and pops only take the ring's lock when a thread is
+ *        sleeping on it.
+ *        Queue occupancy of each ring and busy time of each stage are
+ *        reported with the "-stats" option; the stage busy the largest
+ *        fraction of the time, with a full input queue and an empty
+ *        output queue, limits throughput.
+*/
+/**********************************************************************/
+
+#include <sched.h>
+
+#define pipRecs   16   /* capacity of parsed record ring            */
+#define pipFrms    4   /* number of frames circulating              */
+#define pipOps     4   /* maximum output operations of a frame      */
+
+#define pipWrite   0   /* write frame to XPM file                   */
+#define pipStream  1   /* write frame to frame stream               */
+
+#define pipParse   0   /* stage indices                             */
+#define pipXfrm    1
+#define pipRaster  2
+#define pipOutput  3
+
+typedef struct
+{
+  char      *Buf;     /* item storage                               */
+  size_t     Isz;     /* item size                                  */
+  Longint    Cap;     /* capacity, a power of two                   */
+  Boolean    End;     /* producer has pushed its last item          */
+  pthread_mutex_t  Lock;  /* guards sleeping on Wake                  */
+  pthread_cond_t   Wake;  /* signalled as items are pushed or popped  */
+  Integer    Nwait;   /* threads sleeping on Wake                   */
+  Longint    Tail __attribute__((aligned(64)));
+                      /* producer side: count of items pushed       */
+  Longint    Sum;     /* sum of occupancy after each push           */
+  Longint    Max;     /* maximum occupancy                          */
+  Longint    Nfull;   /* pushes waiting for a free entry            */
+  Extended   Tfull;   /* time waiting for free entries (sec)        */
+  Longint    Head __attribute__((aligned(64)));
+                      /* consumer side: count of items popped       */
+  Longint    Nempty;  /* pops waiting for an item                   */
+  Extended   Tempty;  /* time waiting for items (sec)               */
+} PipeRing;
+
+typedef struct
+{
+  FrmBuf     Fb;                 /* framebuffer of frame             */
+  TileList   Lst;                /* display list of frame            */
+  Integer    Nop;                /* number of output operations      */
+  Integer    Op[pipOps];         /* output operations, in order      */
+  char       Path[pipOps][280];  /* XPM file paths of writes         */
+} PipeFrame;
+
+typedef struct
+{
+  Boolean     On;            /* pipeline is running                  */
+  Boolean     Quit;          /* stages to exit without draining      */
+  Boolean     Fail;          /* frame stream or pipeline failed      */
+  TxyzFile   *Trj;           /* trajectory read by parse stage       */
+  TxyzRate   *Rate;          /* fixed rate frames, or NULL           */
+  FrmBuf     *Blank;         /* blank frame copied to written frames */
+  PipeFrame   Frm[pipFrms];
+  PipeFrame  *Cur;           /* frame being recorded                 */
+  PipeRing    Rec;           /* parse to transform (TxyzRec)         */
+  PipeRing    Ras;           /* transform to raster (PipeFrame *)    */
+  PipeRing    Out;           /* raster to output (PipeFrame *)       */
+  PipeRing    Free;          /* output to transform (PipeFrame *)    */
+  Extended    Tbeg;          /* start time of pipeline               */
+  Extended    Twall;         /* run time of pipeline (sec)           */
+  Extended    Tcur;          /* start time of current record         */
+  Extended    Sec[4];        /* busy time of stages (sec)            */
+  Longint     Cnt[4];        /* items processed by stages            */
+  pthread_t   Thr[3];        /* parse, raster and output threads     */
+  Integer     Nthr;          /* number of stage threads started      */
+} PipeLine;
+
+PipeLine  pip;
+
+void PipeFree( Boolean quit );
+
+/*
+ * ALLOCATES RING OF GIVEN ITEM SIZE, CAPACITY ROUNDED UP TO A POWER
+ * OF TWO
+*/
+static Boolean PipeRingCreate( PipeRing *ring, size_t isz, Longint cap )
+{
+   memset(ring, 0, sizeof(PipeRing));
+   pthread_mutex_init(&ring->Lock, NULL);
+   pthread_cond_init(&ring->Wake, NULL);
+   ring->Cap = 1;
+   while ( ring->Cap < cap ) ring->Cap = 2*ring->Cap;
+   ring->Isz = isz;
+   ring->Buf = (char *)malloc(ring->Cap*isz);
+   if ( ring->Buf == NULL ) {
+      printf("PipeRingCreate:  malloc error for %ld items.\n",ring->Cap);
+      return FALSE;
+   }
+   return TRUE;
+}
+
+/*
+ * FREES RING
+*/
+static void PipeRingFree( PipeRing *ring )
+{
+   free(ring->Buf);
+   ring->Buf = NULL;
+   pthread_cond_destroy(&ring->Wake);
+   pthread_mutex_destroy(&ring->Lock);
+}
+
+/*
+ * WAITS WHILE THE OTHER END OF A RING LEAVES *cnt (ITS Head OR Tail)
+ * EQUAL TO val, SPINNING, THEN YIELDING, THEN SLEEPING ON THE RING'S
+ * CONDITION VARIABLE UNTIL *cnt CHANGES, THE RING IS ENDED (IF end IS
+ * TRUE) OR THE PIPELINE IS QUIT
+*/
+static void PipeWait( PipeRing *ring, Longint *cnt, Longint val,
+                      Boolean end, Longint *spin )
+{
+   *spin = *spin + 1;
+   if ( *spin < 4 ) return;
+   if ( *spin < 16 ) {
+      sched_yield();
+      return;
+   }
+   /*--- Nwait is raised before *cnt is checked again, and pushes and
+         pops fence before checking Nwait, so no wakeup is missed */
+   pthread_mutex_lock(&ring->Lock);
+   __atomic_add_fetch(&ring->Nwait, 1, __ATOMIC_SEQ_CST);
+   while ( ( __atomic_load_n(cnt, __ATOMIC_SEQ_CST) == val ) &&
+           ( ! ( end && __atomic_load_n(&ring->End, __ATOMIC_SEQ_CST) ) ) &&
+           ( ! __atomic_load_n(&pip.Quit, __ATOMIC_SEQ_CST) ) ) {
+      pthread_cond_wait(&ring->Wake, &ring->Lock);
+   }
+   __atomic_sub_fetch(&ring->Nwait, 1, __ATOMIC_SEQ_CST);
+   pthread_mutex_unlock(&ring->Lock);
+}
+
+/*
+ * WAKES THREADS SLEEPING ON RING AFTER ITS Head, Tail OR End CHANGED
+ * OR THE PIPELINE WAS QUIT
+*/
+static void PipeWake( PipeRing *ring )
+{
+   __atomic_thread_fence(__ATOMIC_SEQ_CST);
+   if ( __atomic_load_n(&ring->Nwait, __ATOMIC_RELAXED) > 0 ) {
+      pthread_mutex_lock(&ring->Lock);
+      pthread_cond_broadcast(&ring->Wake);
+      pthread_mutex_unlock(&ring->Lock);
+   }
+}
+
+/*
+ * PUSHES ITEM ONTO RING, WAITING WHILE IT IS FULL; RETURNS FALSE IF
+ * THE PIPELINE IS QUIT
+*/
+static Boolean PipePush( PipeRing *ring, const void *item )
+{
+   Longint   tail = ring->Tail;
+   Longint   spin = 0;
+   Longint   occ;
+   Extended  t0 = 0.0;
+
+   while ( tail - __atomic_load_n(&ring->Head, __ATOMIC_ACQUIRE) == ring->Cap ) {
+      if ( __atomic_load_n(&pip.Quit, __ATOMIC_ACQUIRE) ) return FALSE;
+      if ( spin == 0 ) {
+         ring->Nfull = ring->Nfull + 1;
+         t0 = RenSec();
+      }
+      PipeWait(ring, &ring->Head, tail - ring->Cap, FALSE, &spin);
+   }
+   if ( spin > 0 ) ring->Tfull = ring->Tfull + RenSec() - t0;
+
+   memcpy(ring->Buf + (tail & (ring->Cap - 1))*ring->Isz, item, ring->Isz);
+   __atomic_store_n(&ring->Tail, tail + 1, __ATOMIC_RELEASE);
+   PipeWake(ring);
+
+   occ = tail + 1 - __atomic_load_n(&ring->Head, __ATOMIC_ACQUIRE);
+   ring->Sum = ring->Sum + occ;
+   if ( occ > ring->Max ) ring->Max = occ;
+   return TRUE;
+}
+
+/*
+ * MARKS LAST ITEM OF RING AS PUSHED
+*/
+static void PipeEnd( PipeRing *ring )
+{
+   __atomic_store_n(&ring->End, TRUE, __ATOMIC_RELEASE);
+   PipeWake(ring);
+}
+
+/*
+ * WAITS WHILE RING IS EMPTY; RETURNS FALSE IF IT IS EMPTY AFTER THE
+ * LAST ITEM WAS PUSHED OR THE PIPELINE IS QUIT
+*/
+static Boolean PipePeek( PipeRing *ring )
+{
+   Longint   head = ring->Head;
+   Longint   spin = 0;
+   Extended  t0 = 0.0;
+
+   while ( __atomic_load_n(&ring->Tail, __ATOMIC_ACQUIRE) == head ) {
+      if ( __atomic_load_n(&ring->End, __ATOMIC_ACQUIRE) &&
+           ( __atomic_load_n(&ring->Tail, __ATOMIC_ACQUIRE) == head ) ) break;
+      if ( __atomic_load_n(&pip.Quit, __ATOMIC_ACQUIRE) ) break;
+      if ( spin == 0 ) {
+         ring->Nempty = ring->Nempty + 1;
+         t0 = RenSec();
+      }
+      PipeWait(ring, &ring->Tail, head, TRUE, &spin);
+   }
+   if ( spin > 0 ) ring->Tempty = ring->Tempty + RenSec() - t0;
+   return ( __atomic_load_n(&ring->Tail, __ATOMIC_ACQUIRE) != head );
+}
+
+/*
+ * POPS ITEM FROM RING, WAITING WHILE IT IS EMPTY; RETURNS FALSE IF
+ * NO MORE ITEMS WILL BE PUSHED
+*/
+static Boolean PipePop( PipeRing *ring, void *item )
+{
+   Longint  head = ring->Head;
+
+   if ( ! PipePeek(ring) ) return FALSE;
+   memcpy(item, ring->Buf + (head & (ring->Cap - 1))*ring->Isz, ring->Isz);
+   __atomic_store_n(&ring->Head, head + 1, __ATOMIC_RELEASE);
+   PipeWake(ring);
+   return TRUE;
+}
+
+/*
+ * PARSE STAGE THREAD READING TRAJECTORY RECORDS OR FIXED RATE FRAMES
+*/
+static void *PipeParse( void *arg )
+{
+   TxyzRec   rec;
+   Integer   got;
+   Extended  t0;
+
+   (void)arg;
+   TRACE_THREAD("parse");
+   memset(&rec, 0, sizeof(rec));
+   while ( ! ( ( pip.Rate != NULL ) ? TxyzRateEof(pip.Trj, pip.Rate)
+                                    : TxyzEof(pip.Trj) ) ) {
+      TRACE_BEG(1,"parse");
+      t0  = RenSec();
+      got = ( pip.Rate != NULL ) ? TxyzReadRate(pip.Trj, pip.Rate, &rec)
+                                 : TxyzRead(pip.Trj, &rec);
+      TRACE_END(1);
+      pip.Sec[pipParse] = pip.Sec[pipParse] + RenSec() - t0;
+      if ( got != 1 ) continue;
+      pip.Cnt[pipParse] = pip.Cnt[pipParse] + 1;
+      if ( ! PipePush(&pip.Rec, &rec) ) break;
+   }
+   PipeEnd(&pip.Rec);
+   return NULL;
+}
+
+/*
+ * RASTER STAGE THREAD RASTERIZING DISPLAY LISTS OF FRAMES
+*/
+static void *PipeRaster( void *arg )
+{
+   PipeFrame  *frm;
+   Extended    t0;
+
+   (void)arg;
+   TRACE_THREAD("raster");
+   while ( PipePop(&pip.Ras, &frm) ) {
+      t0 = RenSec();
+      if ( ! TileRaster(&frm->Lst) ) {
+         __atomic_store_n(&pip.Fail, TRUE, __ATOMIC_RELEASE);
+      }
+      pip.Sec[pipRaster] = pip.Sec[pipRaster] + RenSec() - t0;
+      pip.Cnt[pipRaster] = pip.Cnt[pipRaster] + 1;
+      if ( ! PipePush(&pip.Out, &frm) ) break;
+   }
+   PipeEnd(&pip.Out);
+   return NULL;
+}
+
+/*
+ * OUTPUT STAGE THREAD WRITING FRAMES AND CLEARING THEM FOR REUSE
+*/
+static void *PipeOutput( void *arg )
+{
+   PipeFrame  *frm;
+   Integer     i;
+   Extended    t0;
+
+   (void)arg;
+   TRACE_THREAD("output");
+   while ( PipePop(&pip.Out, &frm) ) {
+      TRACE_BEG(1,"output");
+      t0 = RenSec();
+      for ( i = 0 ; i < frm->Nop ; i++ ) {
+         if ( frm->Op[i] == pipWrite ) {
+            if ( cap.Nthr > 0 ) {
+               CapPutFb(&frm->Fb, frm->Path[i]);
+            } else if ( ! FbWriteXPM(&frm->Fb, frm->Path[i]) ) {
+               __atomic_store_n(&pip.Fail, TRUE, __ATOMIC_RELEASE);
+            }
+         } else if ( ! pip.Fail ) {
+            FbToRGB(&frm->Fb, strmRGB);
+            if ( ! StrmFrame() ) {
+               __atomic_store_n(&pip.Fail, TRUE, __ATOMIC_RELEASE);
+            }
+         }
+      }
+      FbCopy(&frm->Fb, pip.Blank);
+      TRACE_END(1);
+      pip.Sec[pipOutput] = pip.Sec[pipOutput] + RenSec() - t0;
+      pip.Cnt[pipOutput] = pip.Cnt[pipOutput] + 1;
+      if ( ! PipePush(&pip.Free, &frm) ) break;
+   }
+   return NULL;
+}
+
+/*
+ * STARTS PIPELINE OF FRAMES COPIED FROM BLANK FRAMEBUFFER, WITH DEPTH
+ * BUFFERS IF depth IS TRUE, READ FROM TRAJECTORY trj (AT FIXED RATE
+ * IF rate IS NOT NULL); TILED RASTERIZATION MUST BE ENABLED
+*/
+Boolean PipeCreate( TxyzFile *trj, TxyzRate *rate, FrmBuf *blank,
+                    Boolean depth )
+{
+   static void *(*stage[3])( void * ) = { PipeParse, PipeRaster, PipeOutput };
+   PipeFrame  *frm;
+   Integer     i;
+
+   memset(&pip, 0, sizeof(pip));
+   pip.Trj   = trj;
+   pip.Rate  = rate;
+   pip.Blank = blank;
+   if ( ! ( PipeRingCreate(&pip.Rec, sizeof(TxyzRec), pipRecs) &&
+            PipeRingCreate(&pip.Ras, sizeof(PipeFrame *), pipFrms) &&
+            PipeRingCreate(&pip.Out, sizeof(PipeFrame *), pipFrms) &&
+            PipeRingCreate(&pip.Free, sizeof(PipeFrame *), pipFrms) ) ) {
+      PipeFree(TRUE);
+      return FALSE;
+   }
+   for ( i = 0 ; i < pipFrms ; i++ ) {
+      frm = &pip.Frm[i];
+      if ( ! ( FbCreate(&frm->Fb, blank->Wid, blank->Hgt) &&
+               ( ( ! depth ) || FbCreateDepth(&frm->Fb) ) &&
+               TileListCreate(&frm->Lst, &frm->Fb) ) ) {
+         PipeFree(TRUE);
+         return FALSE;
+      }
+      FbCopy(&frm->Fb, blank);
+      PipePush(&pip.Free, &frm);
+   }
+
+   pip.Tbeg = RenSec();
+   for ( i = 0 ; i < 3 ; i++ ) {
+      if ( pthread_create(&pip.Thr[i], NULL, stage[i], NULL) != 0 ) {
+         printf("PipeCreate:  pthread_create error for stage %d.\n",i);
+         break;
+      }
+   }
+   pip.Nthr = i;
+   if ( pip.Nthr < 3 ) {
+      PipeFree(TRUE);
+      return FALSE;
+   }
+   pip.On = TRUE;
+#if DBG_LVL > 0
+   printf("PipeCreate:  %d frames, %ld records ahead\n",pipFrms,pip.Rec.Cap);
+#endif
+   return TRUE;
+}
+
+/*
+ * WAITS FOR NEXT PARSED RECORD; RETURNS TRUE IF THERE ARE NO MORE
+*/
+Boolean PipeEof( void )
+{
+   return ! PipePeek(&pip.Rec);
+}
+
+/*
+ * GETS NEXT PARSED RECORD, RETURNING 1 IF ONE WAS AVAILABLE (AS FOR
+ * TxyzRead)
+*/
+Integer PipeRead( TxyzRec *rec )
+{
+   if ( ! PipePop(&pip.Rec, rec) ) return 0;
+   pip.Tcur = RenSec();
+   return 1;
+}
+
+/*
+ * TAKES FREE FRAME, WAITING UNTIL ONE HAS BEEN WRITTEN (NOT COUNTED
+ * AS TRANSFORM STAGE BUSY TIME), AND RECORDS PRIMITIVES DRAWN FROM
+ * NOW ON IN ITS DISPLAY LIST
+*/
+Boolean PipeTake( void )
+{
+   Extended  t0 = RenSec();
+   Boolean   got;
+
+   TRACE_BEG(1,"PipeTake");
+   got = PipePop(&pip.Free, &pip.Cur);
+   TRACE_END(1);
+   if ( ! got ) return FALSE;
+   pip.Tcur = pip.Tcur + RenSec() - t0;
+   pip.Cur->Nop = 0;
+   TileRecord(&pip.Cur->Lst);
+   return TRUE;
+}
+
+/*
+ * ADDS WRITE OF CURRENT FRAME TO XPM FILE TO ITS OUTPUT OPERATIONS
+*/
+void PipeWrite( const char *fpath )
+{
+   PipeFrame  *frm = pip.Cur;
+
+   if ( ( frm == NULL ) || ( frm->Nop == pipOps ) ) return;
+   frm->Op[frm->Nop] = pipWrite;
+   strncpy(frm->Path[frm->Nop], fpath, sizeof(frm->Path[0]) - 1);
+   frm->Path[frm->Nop][sizeof(frm->Path[0]) - 1] = '\0';
+   frm->Nop = frm->Nop + 1;
+}
+
+/*
+ * ADDS WRITE OF CURRENT FRAME TO FRAME STREAM TO ITS OUTPUT OPERATIONS
+*/
+void PipeStream( void )
+{
+   PipeFrame  *frm = pip.Cur;
+
+   if ( ( frm == NULL ) || ( frm->Nop == pipOps ) ) return;
+   frm->Op[frm->Nop] = pipStream;
+   frm->Nop = frm->Nop + 1;
+}
+
+/*
+ * PASSES CURRENT FRAME ON TO BE RASTERIZED AND WRITTEN; RETURNS FALSE
+ * IF IT COULD NOT BE PASSED ON, A FRAME FAILED TO BE RASTERIZED OR THE
+ * FRAME STREAM COULD NOT BE WRITTEN
+*/
+Boolean PipeSubmit( void )
+{
+   if ( pip.Cur != NULL ) {
+      pip.Sec[pipXfrm] = pip.Sec[pipXfrm] + RenSec() - pip.Tcur;
+      pip.Cnt[pipXfrm] = pip.Cnt[pipXfrm] + 1;
+      if ( ! PipePush(&pip.Ras, &pip.Cur) ) {
+         printf("PipeSubmit:  pipeline quit; frame not rasterized.\n");
+         __atomic_store_n(&pip.Fail, TRUE, __ATOMIC_RELEASE);
+         pip.Cur = NULL;
+         return FALSE;
+      }
+      pip.Cur = NULL;
+   }
+   return ! __atomic_load_n(&pip.Fail, __ATOMIC_ACQUIRE);
+}
+
+/*
+ * DRAINS PIPELINE OF FRAMES SUBMITTED (UNLESS quit IS TRUE), STOPS
+ * STAGE THREADS AND FREES FRAMES AND RINGS
+*/
+void PipeFree( Boolean quit )
+{
+   Integer  i;
+
+   if ( quit ) {
+      __atomic_store_n(&pip.Quit, TRUE, __ATOMIC_RELEASE);
+      PipeWake(&pip.Rec);
+      PipeWake(&pip.Out);
+      PipeWake(&pip.Free);
+   }
+   PipeEnd(&pip.Ras);
+   for ( i = 0 ; i < pip.Nthr ; i++ ) pthread_join(pip.Thr[i], NULL);
+   if ( pip.On ) pip.Twall = RenSec() - pip.Tbeg;
+   pip.Nthr = 0;
+   pip.On   = FALSE;
+   TileRecord(&tiles.Own);
+   for ( i = 0 ; i < pipFrms ; i++ ) {
+      TileListFree(&pip.Frm[i].Lst);
+      FbFree(&pip.Frm[i].Fb);
+   }
+   PipeRingFree(&pip.Rec);
+   PipeRingFree(&pip.Ras);
+   PipeRingFree(&pip.Out);
+   PipeRingFree(&pip.Free);
+}
+
+/*
+ * PRINTS STAGE BUSY TIME AND RING OCCUPANCY STATISTICS
+*/
+void PipeReport( void )
+{
+   static const char *name[4] = { "parse", "transform", "raster", "output" };
+   static const char *qnam[4] = { "record", "raster", "output", "free" };
+   PipeRing  *ring[4] = { &pip.Rec, &pip.Ras, &pip.Out, &pip.Free };
+   Extended   wall = ( pip.Twall > 0.0 ) ? pip.Twall : 1.0;
+   Integer    i;
+
+   if ( pip.Cnt[pipXfrm] == 0 ) return;
+
+   printf("PipeReport:  %ld frames in %.3f s, %.1f frames/s\n",
+          pip.Cnt[pipOutput], pip.Twall, pip.Cnt[pipOutput]/wall);
+   for ( i = 0 ; i < 4 ; i++ ) {
+      printf("PipeReport:  %-9s %6ld items, %.3f ms each, %5.1f%% busy\n",
+             name[i], pip.Cnt[i], 1.0e3*pip.Sec[i]/lmax(pip.Cnt[i],1),
+             100.0*pip.Sec[i]/wall);
+   }
+   for ( i = 0 ; i < 4 ; i++ ) {
+      printf("PipeReport:  %-9s queue %5.2f of %ld mean, %ld max, "
+             "%ld full (%.3f s), %ld empty (%.3f s)\n",
+             qnam[i],
+             (Extended)ring[i]->Sum/lmax(ring[i]->Tail,1), ring[i]->Cap,
+             ring[i]->Max, ring[i]->Nfull, ring[i]->Tfull,
+             ring[i]->Nempty, ring[i]->Tempty);
+   }
+}
@@ -13,23 +13,22 @@
 */
 /**********************************************************************/
 
-#define MaxElements  1024 
+#define MaxElements  1024  /* initial element capacity */
 #define FALSE           0
 #define TRUE            1
  
 typedef struct
 {
   Longint  Key;
-  Integer  Info;
+  Longint  Info;
 } HeapElement;
 
-typedef HeapElement  HeapArray[MaxElements];
-
 typedef struct PQ_type  *PQtypePtr;
 typedef struct PQ_type
 {
-  HeapElement  Elements[MaxElements];
-  Integer      Bottom;
+  HeapElement  *Elements;  /* heap array, element 0 unused */
+  Longint       Bottom;
+  Longint       Max;       /* allocated element capacity    */
 } PQtype;
 
 void ClearPQ( PQtypePtr pPQueue )
@@ -37,20 +36,40 @@ void ClearPQ( PQtypePtr pPQueue )
    pPQueue->Bottom = 0;
 }
 
-Boolean EmptyPQ( PQtype aPQueue )
+Boolean EmptyPQ( PQtypePtr pPQueue )
 {
-   return (Boolean)( aPQueue.Bottom == 0 );
+   return (Boolean)( pPQueue->Bottom == 0 );
 }
 
-Boolean FullPQ( PQtype aPQueue )
+Boolean FullPQ( PQtypePtr pPQueue )
 {
-   return (Boolean)( aPQueue.Bottom == MaxElements );
+   return (Boolean)( pPQueue->Bottom == pPQueue->Max );
+}
+
+/*
+ * Grows heap array to hold at least nelm elements, returning FALSE
+ * if memory could not be allocated.
+*/
+Boolean GrowPQ( PQtypePtr pPQueue, Longint nelm )
+{
+   HeapElement  *elm;
+   Longint       max;
+
+   if ( nelm <= pPQueue->Max ) return TRUE;
+
+   max = ( pPQueue->Max == 0 ) ? MaxElements : pPQueue->Max;
+   while ( max < nelm ) max = 2*max;
+   elm = (HeapElement *)realloc(pPQueue->Elements, (max+1)*sizeof(HeapElement));
+   if ( elm == NULL ) return FALSE;
+   pPQueue->Elements = elm;
+   pPQueue->Max      = max;
+   return TRUE;
 }
 
-void ReHeapUp( HeapElement *HeapElements, Integer Bottom )
+void ReHeapUp( HeapElement *HeapElements, Longint Bottom )
 {
-   Integer      CurrentIndex;
-   Integer      ParentIndex;
+   Longint      CurrentIndex;
+   Longint      ParentIndex;
    Boolean      HeapOk;
    HeapElement  TempElement;
 
@@ -75,12 +94,12 @@ void ReHeapUp( HeapElement *HeapElements, Integer Bottom )
    }
 }
 
-void ReHeapDown( HeapElement *HeapElements, Integer Root, Integer Bottom )
+void ReHeapDown( HeapElement *HeapElements, Longint Root, Longint Bottom )
 {
    Boolean      HeapOk;
-   Integer      MaxChild;
-   Integer      Root2;
-   Integer      Root2p1;
+   Longint      MaxChild;
+   Longint      Root2;
+   Longint      Root2p1;
    HeapElement  TempElement;
 
    Root2   = Root*2;
@@ -121,6 +140,7 @@ void ReHeapDown( HeapElement *HeapElements, Integer Root, Integer Bottom )
 
 void PriorityEnq( PQtypePtr pPQueue, HeapElement NewElement )
 {
+   if ( FullPQ(pPQueue) && ( ! GrowPQ(pPQueue, pPQueue->Bottom+1) ) ) return;
    pPQueue->Bottom                    = pPQueue->Bottom + 1;
    pPQueue->Elements[pPQueue->Bottom] = NewElement;
    ReHeapUp(pPQueue->Elements, pPQueue->Bottom);
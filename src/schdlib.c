@@ -0,0 +1,163 @@
+/**********************************************************************/
+/* FILE:  schdlib.c
+ * DATE:  16 OCT 2026
+ * AUTH:  G. E. Deschaines
+ * DESC:  Wall clock frame scheduler pacing animation played to an X11
+ *        window.
+ *
+ *        Frame deadlines are absolute times on the monotonic clock,
+ *        each one frame period after the last, and the process sleeps
+ *        until a deadline with clock_nanosleep(TIMER_ABSTIME), so the
+ *        processor is free between frames and sleep overshoot on one
+ *        frame does not delay the frames after it.  A frame finishing
+ *        later than its next deadline starts the next frame at once,
+ *        and deadlines are then resynchronized to the current time
+ *        rather than hurrying later frames to catch up.
+ *
+ *        The interval between successive frame starts is recorded,
+ *        and its deviation from the frame period (jitter) is reported
+ *        as percentiles with the "-stats" option.
+*/
+/**********************************************************************/
+
+#include <errno.h>
+
+#define SchdPause  10  /* wake interval while paused (msec) */
+
+typedef struct
+{
+  struct timespec  Next;   /* deadline of current frame             */
+  Longint          Per;    /* frame period (msec)                   */
+  Extended         Last;   /* start time of last frame, 0 if none   */
+  Extended        *Jit;    /* frame start interval jitter (sec)     */
+  Longint          Cnt;
+  Longint          Max;
+  Extended         Sum;    /* sum of frame start intervals (sec)    */
+  Longint          Late;   /* frames started after next deadline    */
+} Schd;
+
+Schd  schd;
+
+/*
+ * ADDS msec MILLISECONDS TO TIME
+*/
+static void SchdAdd( struct timespec *t, Longint msec )
+{
+   t->tv_sec  = t->tv_sec + msec/1000;
+   t->tv_nsec = t->tv_nsec + (msec%1000)*1000000L;
+   if ( t->tv_nsec >= 1000000000L ) {
+      t->tv_sec  = t->tv_sec + 1;
+      t->tv_nsec = t->tv_nsec - 1000000000L;
+   }
+}
+
+/*
+ * RETURNS TRUE IF TIME a IS BEFORE TIME b
+*/
+static Boolean SchdBefore( struct timespec *a, struct timespec *b )
+{
+   return ( a->tv_sec < b->tv_sec ) ||
+          ( ( a->tv_sec == b->tv_sec ) && ( a->tv_nsec < b->tv_nsec ) );
+}
+
+/*
+ * RESYNCHRONIZES FRAME DEADLINES TO CURRENT TIME
+*/
+void SchdSync( void )
+{
+   clock_gettime(CLOCK_MONOTONIC, &schd.Next);
+   schd.Last = 0.0;
+}
+
+/*
+ * STARTS SCHEDULE OF FRAMES AT GIVEN PERIOD FROM CURRENT TIME
+*/
+void SchdStart( Longint msec )
+{
+   schd.Per  = msec;
+   schd.Cnt  = 0;
+   schd.Sum  = 0.0;
+   schd.Late = 0;
+   SchdSync();
+}
+
+/*
+ * CHANGES FRAME PERIOD, APPLIED FROM THE NEXT DEADLINE
+*/
+void SchdPeriod( Longint msec )
+{
+   schd.Per = msec;
+}
+
+/*
+ * SLEEPS UNTIL DEADLINE OF NEXT FRAME AND RECORDS INTERVAL BETWEEN
+ * STARTS OF LAST AND NEXT FRAMES
+*/
+void SchdWait( void )
+{
+   struct timespec  now;
+   Extended         tsec;
+
+   SchdAdd(&schd.Next, schd.Per);
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   if ( SchdBefore(&schd.Next, &now) ) {
+      schd.Next = now;
+      if ( schd.Per > 0 ) schd.Late = schd.Late + 1;
+   } else {
+      while ( clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+                              &schd.Next, NULL) == EINTR );
+      clock_gettime(CLOCK_MONOTONIC, &now);
+   }
+
+   tsec = (Extended)now.tv_sec + 1.0e-9*(Extended)now.tv_nsec;
+   if ( ( schd.Last > 0.0 ) &&
+        GrowList((void **)&schd.Jit, &schd.Max, schd.Cnt+1,
+                 sizeof(Extended), 1024) ) {
+      schd.Jit[schd.Cnt++] = fabs(tsec - schd.Last - 1.0e-3*schd.Per);
+      schd.Sum = schd.Sum + tsec - schd.Last;
+   }
+   schd.Last = tsec;
+}
+
+/*
+ * SLEEPS WHILE PLAYBACK IS PAUSED, RESYNCHRONIZING DEADLINES FOR
+ * RESUMPTION
+*/
+void SchdIdle( void )
+{
+   struct timespec  t;
+
+   clock_gettime(CLOCK_MONOTONIC, &t);
+   SchdAdd(&t, SchdPause);
+   while ( clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &t, NULL) == EINTR );
+   SchdSync();
+}
+
+/*
+ * JITTER COMPARISON FOR qsort
+*/
+static int SchdCmp( const void *a, const void *b )
+{
+   Extended  ja = *(const Extended *)a;
+   Extended  jb = *(const Extended *)b;
+
+   return ( ja < jb ) ? -1 : ( ja > jb ) ? 1 : 0;
+}
+
+/*
+ * PRINTS FRAME INTERVAL AND JITTER PERCENTILE STATISTICS
+*/
+void SchdReport( void )
+{
+   Longint  n = schd.Cnt;
+
+   if ( n == 0 ) return;
+
+   qsort(schd.Jit, n, sizeof(Extended), SchdCmp);
+
+   printf("SchdReport:  %ld frame intervals, %.3f ms mean, %ld ms period, %ld late\n",
+          n, 1.0e3*schd.Sum/n, schd.Per, schd.Late);
+   printf("SchdReport:  jitter %.3f ms p50, %.3f ms p95, %.3f ms p99, %.3f ms max\n",
+          1.0e3*schd.Jit[(n-1)*50/100], 1.0e3*schd.Jit[(n-1)*95/100],
+          1.0e3*schd.Jit[(n-1)*99/100], 1.0e3*schd.Jit[n-1]);
+}
@@ -0,0 +1,250 @@
+/**********************************************************************/
+/* FILE:  shmlib.c
+ * DATE:  16 OCT 2026
+ * AUTH:  G. E. Deschaines
+ * DESC:  Presentation of client-side framebuffer frames to an X11
+ *        window through the MIT shared memory (MIT-SHM) extension.
+ *
+ *        When frames are rendered into the client-side framebuffer
+ *        and shown in a window (ren_MOD=2), each frame's palette
+ *        indices are converted to screen pixel values in an XImage
+ *        which the X server reads directly from a shared memory
+ *        segment on XShmPutImage, rather than receiving the whole
+ *        image through the connection as with XPutImage.  The image
+ *        is not written again until the server reports completion of
+ *        the put, so the server never reads a partly converted frame.
+ *
+ *        If the display does not support the extension (e.g., it is
+ *        remote), the shared memory segment cannot be created or the
+ *        server cannot attach it, or shared memory is disabled with
+ *        the "-noshm" option, frames are presented with XPutImage
+ *        from an ordinary client memory image instead.
+ *
+ *        Present latency, from issuing the put request until the
+ *        server has completed it, is accumulated for each frame and
+ *        reported with the "-stats" option, so the two paths can be
+ *        compared by running with and without "-noshm".
+*/
+/**********************************************************************/
+
+#include <stdint.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <X11/extensions/XShm.h>
+
+typedef struct
+{
+  XImage           *Img;             /* presentation image              */
+  XShmSegmentInfo   Seg;             /* shared memory segment of image  */
+  Boolean           Shm;             /* image is in shared memory       */
+  Boolean           Fast;            /* image is 32 bpp in host order   */
+  int               Evt;             /* ShmCompletion event type        */
+  Window            Win;             /* window presented to             */
+  unsigned long     Pix[fbNumClr];   /* pixel values of palette indices */
+  Longint           Cnt;             /* number of frames presented      */
+  Extended          Sec;             /* total present latency (sec)     */
+  Extended          Max;             /* maximum present latency (sec)   */
+} ShmPres;
+
+ShmPres  shmPres;
+
+static Boolean  shmAttErr = FALSE;  /* XShmAttach failed on server */
+
+/*
+ * X ERROR HANDLER NOTING FAILURE OF SERVER TO ATTACH SHARED MEMORY
+*/
+static int ShmAttachError( Display *display, XErrorEvent *error )
+{
+   shmAttErr = TRUE;
+   return 0;
+}
+
+/*
+ * CREATES PRESENTATION IMAGE IN SHARED MEMORY, RETURNING FALSE IF
+ * THE EXTENSION OR A SHARED MEMORY SEGMENT IS NOT AVAILABLE
+*/
+static Boolean ShmCreateShared( Display *display, Visual *visual,
+                                int depth, Integer wid, Integer hgt )
+{
+   XImage   *img;
+   int     (*handler)(Display *, XErrorEvent *);
+
+   if ( ! XShmQueryExtension(display) ) return FALSE;
+
+   img = XShmCreateImage(display, visual, depth, ZPixmap, NULL,
+                         &shmPres.Seg, wid, hgt);
+   if ( img == NULL ) return FALSE;
+
+   shmPres.Seg.shmid = shmget(IPC_PRIVATE,
+                              (size_t)img->bytes_per_line*img->height,
+                              IPC_CREAT | 0600);
+   if ( shmPres.Seg.shmid < 0 ) {
+      XDestroyImage(img);
+      return FALSE;
+   }
+   shmPres.Seg.shmaddr = (char *)shmat(shmPres.Seg.shmid, NULL, 0);
+   if ( shmPres.Seg.shmaddr == (char *)-1 ) {
+      shmctl(shmPres.Seg.shmid, IPC_RMID, NULL);
+      XDestroyImage(img);
+      return FALSE;
+   }
+   img->data = shmPres.Seg.shmaddr;
+   shmPres.Seg.readOnly = False;
+
+/*--- SERVER ATTACH FAILS WITH BadAccess ON A REMOTE OR RESTRICTED DISPLAY */
+   shmAttErr = FALSE;
+   XSync(display, False);
+   handler = XSetErrorHandler(ShmAttachError);
+   XShmAttach(display, &shmPres.Seg);
+   XSync(display, False);
+   XSetErrorHandler(handler);
+
+/*--- SEGMENT IS REMOVED ONCE DETACHED BY BOTH CLIENT AND SERVER */
+   shmctl(shmPres.Seg.shmid, IPC_RMID, NULL);
+
+   if ( shmAttErr ) {
+      shmdt(shmPres.Seg.shmaddr);
+      img->data = NULL;
+      XDestroyImage(img);
+      return FALSE;
+   }
+   shmPres.Img = img;
+   shmPres.Evt = XShmGetEventBase(display) + ShmCompletion;
+   return TRUE;
+}
+
+/*
+ * CREATES PRESENTATION IMAGE OF GIVEN SIZE FOR WINDOW, IN SHARED
+ * MEMORY IF ALLOWED AND AVAILABLE, ELSE IN CLIENT MEMORY
+*/
+Boolean ShmCreate( Display *display, Window win, Integer wid, Integer hgt,
+                   Pixel pix[], Pixel bkg, Boolean useshm )
+{
+   Screen   *screen = DefaultScreenOfDisplay(display);
+   Visual   *visual = DefaultVisualOfScreen(screen);
+   int       depth  = DefaultDepthOfScreen(screen);
+   int       one    = 1;
+   Integer   i;
+
+   memset(&shmPres, 0, sizeof(shmPres));
+   shmPres.Win = win;
+   for ( i = 0 ; i < fbBkgClr ; i++ ) {
+      shmPres.Pix[i] = pix[i];
+   }
+   shmPres.Pix[fbBkgClr] = bkg;
+
+   shmPres.Shm = useshm && ShmCreateShared(display, visual, depth, wid, hgt);
+   if ( ! shmPres.Shm ) {
+      shmPres.Img = XCreateImage(display, visual, depth, ZPixmap, 0, NULL,
+                                 wid, hgt, 32, 0);
+      if ( shmPres.Img == NULL ) {
+         fprintf(stderr,"ShmCreate:  XCreateImage error.\n");
+         return FALSE;
+      }
+      shmPres.Img->data = (char *)malloc((size_t)shmPres.Img->bytes_per_line*
+                                         shmPres.Img->height);
+      if ( shmPres.Img->data == NULL ) {
+         fprintf(stderr,"ShmCreate:  malloc error for image data.\n");
+         XDestroyImage(shmPres.Img);
+         shmPres.Img = NULL;
+         return FALSE;
+      }
+   }
+   shmPres.Fast = ( shmPres.Img->bits_per_pixel == 32 ) &&
+                  ( shmPres.Img->byte_order ==
+                    ( *(char *)&one ? LSBFirst : MSBFirst ) );
+#if DBG_LVL > 0
+   printf("ShmCreate:  presenting with %s, %d bpp\n",
+          shmPres.Shm ? "XShmPutImage" : "XPutImage",
+          shmPres.Img->bits_per_pixel);
+#endif
+   return TRUE;
+}
+
+/*
+ * RETURNS TRUE FOR SHARED MEMORY PUT COMPLETION EVENT OF PRESENTED
+ * WINDOW (XIfEvent PREDICATE)
+*/
+static Bool ShmIsCompletion( Display *display, XEvent *event, XPointer arg )
+{
+   return ( event->type == shmPres.Evt ) &&
+          ( ((XShmCompletionEvent *)event)->drawable == shmPres.Win );
+}
+
+/*
+ * CONVERTS FRAMEBUFFER TO PRESENTATION IMAGE AND PUTS IT TO WINDOW,
+ * WAITING UNTIL THE SERVER HAS COMPLETED THE PUT
+*/
+void ShmPresent( Display *display, GC gc, FrmBuf *fb )
+{
+   XImage         *img = shmPres.Img;
+   unsigned char  *src = fb->Pix;
+   uint32_t       *row;
+   XEvent          event;
+   Extended        tput;
+   Longint         x, y;
+
+   if ( img == NULL ) return;
+   TRACE_BEG(1,"ShmPresent");
+
+/*--- CONVERT PALETTE INDICES TO SCREEN PIXEL VALUES */
+   for ( y = 0 ; y < fb->Hgt ; y++ ) {
+      if ( shmPres.Fast ) {
+         row = (uint32_t *)(img->data + y*img->bytes_per_line);
+         for ( x = 0 ; x < fb->Wid ; x++ ) {
+            row[x] = (uint32_t)shmPres.Pix[*src++];
+         }
+      } else {
+         for ( x = 0 ; x < fb->Wid ; x++ ) {
+            XPutPixel(img, x, y, shmPres.Pix[*src++]);
+         }
+      }
+   }
+
+/*--- PUT IMAGE AND WAIT FOR SERVER TO COMPLETE IT */
+   tput = RenSec();
+   if ( shmPres.Shm ) {
+      XShmPutImage(display, shmPres.Win, gc, img,
+                   0, 0, 0, 0, fb->Wid, fb->Hgt, True);
+      XFlush(display);
+      XIfEvent(display, &event, ShmIsCompletion, NULL);
+   } else {
+      XPutImage(display, shmPres.Win, gc, img,
+                0, 0, 0, 0, fb->Wid, fb->Hgt);
+      XSync(display, False);
+   }
+   tput = RenSec() - tput;
+
+   shmPres.Cnt = shmPres.Cnt + 1;
+   shmPres.Sec = shmPres.Sec + tput;
+   if ( tput > shmPres.Max ) shmPres.Max = tput;
+   TRACE_END(1);
+}
+
+/*
+ * DETACHES SHARED MEMORY AND FREES PRESENTATION IMAGE
+*/
+void ShmFree( Display *display )
+{
+   if ( shmPres.Img == NULL ) return;
+   if ( shmPres.Shm ) {
+      XShmDetach(display, &shmPres.Seg);
+      XSync(display, False);
+      shmdt(shmPres.Seg.shmaddr);
+      shmPres.Img->data = NULL;
+   }
+   XDestroyImage(shmPres.Img);
+   shmPres.Img = NULL;
+}
+
+/*
+ * PRINTS PRESENT LATENCY STATISTICS
+*/
+void ShmReport( void )
+{
+   if ( shmPres.Cnt == 0 ) return;
+   printf("ShmReport:  %ld frames presented with %s\n",
+          shmPres.Cnt, shmPres.Shm ? "XShmPutImage" : "XPutImage");
+   printf("ShmReport:  %.3f ms mean, %.3f ms max present latency\n",
+          1000.0*shmPres.Sec/shmPres.Cnt, 1000.0*shmPres.Max);
+}
@@ -0,0 +1,377 @@
+/**********************************************************************/
+/* FILE:  sortlib.c
+ * DATE:  16 OCT 2026
+ * AUTH:  G. E. Deschaines
+ * DESC:  Data structures and methods for a temporally coherent depth
+ *        sort of polygons into back to front drawing order.
+ *
+ *        Polygon depths change little between consecutive trajectory
+ *        records, so rather than building a priority queue from
+ *        scratch every frame, the polygon drawing order of the last
+ *        frame is kept.  Each frame, polygons queued for drawing are
+ *        first arranged in last frame's order (newly visible polygons
+ *        appended), which leaves them nearly sorted, and the order is
+ *        then repaired by an insertion sort.  When the repair would
+ *        take too many element moves, as after a camera cut or view
+ *        change, the frame is fully sorted instead.
+ *
+ *        Each element is queued with a group number, the drawing rank
+ *        of the cluster of objects its polygon belongs to, and groups
+ *        are drawn in increasing group number without any comparison
+ *        of elements across groups.  Within a group, elements are
+ *        ordered by decreasing key, then by increasing polygon number
+ *        for equal keys, so the drawing order depends only on the keys
+ *        and groups of a frame and not on which sort produced it.  The
+ *        repair move budget and any full sort apply per group, so sort
+ *        cost grows with group size rather than with total polygons.
+ *
+ *        SortBench times each frame's ordering against the binary heap
+ *        priority queue of pquelib.c on the same elements, and
+ *        SortReport prints the comparison at the end of a run.
+*/
+/**********************************************************************/
+
+#define SortMoveMax(n)  ( 4*(n) + 64 )  /* insertion sort move budget */
+
+typedef struct
+{
+  Longint      Cnt;        /* number of elements queued          */
+  Longint      Max;        /* allocated element capacity         */
+  HeapElement *Elements;   /* elements in drawing order          */
+  Longint     *Grp;        /* group number of each element       */
+  Longint      Ngrp1;      /* one more than largest group        */
+  Longint      Gmax;       /* allocated group start capacity     */
+  Longint     *Beg;        /* start of each group's elements     */
+  Longint     *Pos;        /* next free slot in each group       */
+  HeapElement *Work;       /* elements in last frame order       */
+  Longint      Prv;        /* number of polygons last frame      */
+  Longint     *Order;      /* polygon drawing order              */
+  Longint     *Slot;       /* element slot+1 of polygon          */
+  Longint      Smax;       /* allocated polygon slot capacity    */
+  Longint      Nfrm;       /* number of frames sorted            */
+  Longint      Nfull;      /* number of full sorts               */
+  Longint      Nmove;      /* number of insertion moves          */
+  Longint      Ngrp;       /* number of groups sorted            */
+  Longint      Nbig;       /* sum of largest group sizes         */
+} SortList;
+
+typedef SortList  *SortListPtr;
+
+/*
+ * RETURNS TRUE IF ELEMENT a IS DRAWN BEFORE ELEMENT b
+*/
+static Boolean SortBefore( const HeapElement *a, const HeapElement *b )
+{
+   if ( a->Key != b->Key ) return (Boolean)( a->Key > b->Key );
+   return (Boolean)( a->Info < b->Info );
+}
+
+static int SortCmp( const void *a, const void *b )
+{
+   if ( SortBefore((const HeapElement *)a, (const HeapElement *)b) ) return -1;
+   if ( SortBefore((const HeapElement *)b, (const HeapElement *)a) ) return  1;
+   return 0;
+}
+
+/*
+ * EMPTIES LIST OF ELEMENTS QUEUED FOR THE FRAME; THE POLYGON ORDER OF
+ * THE LAST FRAME IS KEPT
+*/
+void SortClear( SortListPtr pSL )
+{
+   pSL->Cnt   = 0;
+   pSL->Ngrp1 = 0;
+}
+
+/*
+ * FORGETS POLYGON ORDER OF LAST FRAME, AS WHEN MODELS ARE RELOADED
+*/
+void SortReset( SortListPtr pSL )
+{
+   pSL->Cnt   = 0;
+   pSL->Ngrp1 = 0;
+   pSL->Prv   = 0;
+}
+
+/*
+ * GROWS ARRAY *pArr OF *pMax ITEMS OF GIVEN SIZE TO HOLD AT LEAST n
+ * ITEMS, CLEARING THE ADDED ITEMS; RETURNS FALSE IF OUT OF MEMORY
+*/
+static Boolean SortGrow( void **pArr, Longint *pMax, Longint n, size_t size )
+{
+   char     *arr;
+   Longint   max;
+
+   if ( n <= *pMax ) return TRUE;
+
+   max = ( *pMax == 0 ) ? MaxElements : *pMax;
+   while ( max < n ) max = 2*max;
+   arr = (char *)realloc(*pArr, max*size);
+   if ( arr == NULL ) {
+      printf("SortGrow:  realloc error for %ld items.\n",max);
+      return FALSE;
+   }
+   memset(arr + (*pMax)*size, 0, (max - *pMax)*size);
+   *pArr = arr;
+   *pMax = max;
+   return TRUE;
+}
+
+/*
+ * GROWS ELEMENT, GROUP AND POLYGON ARRAYS TO QUEUE nelm ELEMENTS IN
+ * ngrp GROUPS FOR POLYGONS NUMBERED BELOW npol
+*/
+static Boolean SortCapacity( SortListPtr pSL, Longint nelm, Longint ngrp,
+                             Longint npol )
+{
+   Longint  max;
+
+   if ( nelm > pSL->Max ) {
+      max = pSL->Max;
+      if ( ! SortGrow((void **)&pSL->Elements, &max, nelm, sizeof(HeapElement)) ) return FALSE;
+      max = pSL->Max;
+      if ( ! SortGrow((void **)&pSL->Work,     &max, nelm, sizeof(HeapElement)) ) return FALSE;
+      max = pSL->Max;
+      if ( ! SortGrow((void **)&pSL->Grp,      &max, nelm, sizeof(Longint)) )     return FALSE;
+      max = pSL->Max;
+      if ( ! SortGrow((void **)&pSL->Order,    &max, nelm, sizeof(Longint)) )     return FALSE;
+      pSL->Max = max;
+   }
+   if ( ngrp+1 > pSL->Gmax ) {
+      max = pSL->Gmax;
+      if ( ! SortGrow((void **)&pSL->Beg, &max, ngrp+1, sizeof(Longint)) ) return FALSE;
+      max = pSL->Gmax;
+      if ( ! SortGrow((void **)&pSL->Pos, &max, ngrp+1, sizeof(Longint)) ) return FALSE;
+      pSL->Gmax = max;
+   }
+   if ( npol > pSL->Smax ) {
+      if ( ! SortGrow((void **)&pSL->Slot, &pSL->Smax, npol, sizeof(Longint)) ) return FALSE;
+   }
+   return TRUE;
+}
+
+/*
+ * QUEUES ELEMENT FOR DRAWING IN GROUP theGrp, GROWING THE LIST AS
+ * NEEDED; RETURNS FALSE IF OUT OF MEMORY
+*/
+Boolean SortAdd( SortListPtr pSL, HeapElement NewElement, Longint theGrp )
+{
+   if ( theGrp < 0 ) theGrp = 0;
+   if ( ( pSL->Cnt == pSL->Max ) || ( theGrp+1 >= pSL->Gmax ) ||
+        ( NewElement.Info >= pSL->Smax ) ) {
+      if ( ! SortCapacity(pSL, pSL->Cnt+1, theGrp+1, NewElement.Info+1) ) {
+         return FALSE;
+      }
+   }
+   pSL->Elements[pSL->Cnt] = NewElement;
+   pSL->Grp[pSL->Cnt]      = theGrp;
+   if ( theGrp >= pSL->Ngrp1 ) pSL->Ngrp1 = theGrp + 1;
+   pSL->Cnt                = pSL->Cnt + 1;
+   return TRUE;
+}
+
+/*
+ * REPAIRS NEARLY SORTED ORDER OF n ELEMENTS BY INSERTION, UNLESS TOO
+ * MANY MOVES ARE NEEDED, IN WHICH CASE FULLY SORTS THE ELEMENTS
+*/
+static void SortRange( SortListPtr pSL, HeapElement *wk, Longint n )
+{
+   HeapElement  anElement;
+   Longint      nmove, mmax;
+   Longint      i, k;
+
+   nmove = 0;
+   mmax  = SortMoveMax(n);
+   for ( k = 1 ; ( k < n ) && ( nmove <= mmax ) ; k++ ) {
+      anElement = wk[k];
+      i         = k;
+      while ( ( i > 0 ) && SortBefore(&anElement, &wk[i-1]) ) {
+         wk[i] = wk[i-1];
+         i     = i - 1;
+      }
+      wk[i] = anElement;
+      nmove = nmove + (k - i);
+   }
+   if ( nmove > mmax ) {
+      qsort(wk, n, sizeof(HeapElement), SortCmp);
+      pSL->Nfull = pSL->Nfull + 1;
+   } else {
+      pSL->Nmove = pSL->Nmove + nmove;
+   }
+}
+
+/*
+ * ORDERS QUEUED ELEMENTS BACK TO FRONT BY INCREASING GROUP AND THEN
+ * DECREASING KEY
+*/
+void SortOrder( SortListPtr pSL )
+{
+   HeapElement  *el = pSL->Elements;
+   HeapElement  *wk  = pSL->Work;
+   Longint      *beg = pSL->Beg;
+   Longint      *pos = pSL->Pos;
+   Longint       n, ng, i, k, g, p, big;
+
+   n  = pSL->Cnt;
+   ng = pSL->Ngrp1;
+   if ( n == 0 ) {
+      pSL->Prv  = 0;
+      pSL->Nfrm = pSL->Nfrm + 1;
+      return;
+   }
+
+/* Find start of each group's range of elements. */
+
+   for ( g = 0 ; g <= ng ; g++ ) {
+      beg[g] = 0;
+   }
+   for ( k = 0 ; k < n ; k++ ) {
+      beg[pSL->Grp[k]+1] = beg[pSL->Grp[k]+1] + 1;
+   }
+   for ( g = 0 ; g < ng ; g++ ) {
+      beg[g+1] = beg[g+1] + beg[g];
+      pos[g]   = beg[g];
+   }
+
+/* Arrange elements of each group in last frame's polygon order,
+   followed by those of newly visible polygons in queued order.
+*/
+   for ( k = 0 ; k < n ; k++ ) {
+      pSL->Slot[el[k].Info] = k + 1;
+   }
+   for ( i = 0 ; i < pSL->Prv ; i++ ) {
+      p = pSL->Order[i];
+      if ( pSL->Slot[p] > 0 ) {
+         k            = pSL->Slot[p] - 1;
+         g            = pSL->Grp[k];
+         wk[pos[g]++] = el[k];
+         pSL->Slot[p] = 0;
+      }
+   }
+   for ( k = 0 ; k < n ; k++ ) {
+      p = el[k].Info;
+      if ( pSL->Slot[p] > 0 ) {
+         g            = pSL->Grp[k];
+         wk[pos[g]++] = el[k];
+         pSL->Slot[p] = 0;
+      }
+   }
+
+/* Repair order within each group. */
+
+   big = 0;
+   for ( g = 0 ; g < ng ; g++ ) {
+      if ( beg[g+1] > beg[g] ) {
+         SortRange(pSL, wk+beg[g], beg[g+1]-beg[g]);
+         pSL->Ngrp = pSL->Ngrp + 1;
+         if ( beg[g+1]-beg[g] > big ) big = beg[g+1] - beg[g];
+      }
+   }
+   pSL->Nbig = pSL->Nbig + big;
+   pSL->Nfrm = pSL->Nfrm + 1;
+
+/* Keep drawing order for next frame. */
+
+   for ( k = 0 ; k < n ; k++ ) {
+      el[k]          = wk[k];
+      pSL->Order[k]  = wk[k].Info;
+   }
+   pSL->Prv = n;
+}
+
+/*
+ * SORT BENCHMARK STATISTICS
+*/
+
+typedef struct
+{
+  Longint   Nfrm;     /* number of frames timed            */
+  Longint   Nelm;     /* number of elements ordered        */
+  Longint   Ndif;     /* frames where orders differ in key */
+  Extended  Theap;    /* total heap ordering time (sec)    */
+  Extended  Tsort;    /* total coherent sort time (sec)    */
+  Extended  Mheap;    /* maximum heap frame time (sec)     */
+  Extended  Msort;    /* maximum sort frame time (sec)     */
+} SortStat;
+
+static SortStat     srtStat;
+static PQtype       srtPQ;
+static HeapElement *srtOut = NULL;  /* heap ordered elements */
+static Longint      srtMax = 0;
+
+static Extended SortSec( void )
+{
+   struct timespec  ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (Extended)ts.tv_sec + 1.0e-9*(Extended)ts.tv_nsec;
+}
+
+/*
+ * ORDERS QUEUED ELEMENTS WITH SortOrder, TIMING IT AGAINST ORDERING
+ * THE SAME ELEMENTS WITH THE BINARY HEAP PRIORITY QUEUE
+*/
+void SortBench( SortListPtr pSL )
+{
+   HeapElement  anElement;
+   HeapElement *heapOut;
+   Extended     t0, th, ts;
+   Longint      k, n;
+
+   n = pSL->Cnt;
+   if ( ( ! SortGrow((void **)&srtOut, &srtMax, n, sizeof(HeapElement)) ) ||
+        ( ! GrowPQ(&srtPQ, n) ) ) {
+      SortOrder(pSL);
+      return;
+   }
+   heapOut = srtOut;
+
+   t0 = SortSec();
+   ClearPQ(&srtPQ);
+   for ( k = 0 ; k < n ; k++ ) {
+      PriorityEnq(&srtPQ, pSL->Elements[k]);
+   }
+   k = 0;
+   while ( ! EmptyPQ(&srtPQ) ) {
+      PriorityDeq(&srtPQ, &anElement);
+      heapOut[k++] = anElement;
+   }
+   th = SortSec() - t0;
+
+   t0 = SortSec();
+   SortOrder(pSL);
+   ts = SortSec() - t0;
+
+   for ( k = 0 ; k < n ; k++ ) {
+      if ( heapOut[k].Key != pSL->Elements[k].Key ) {
+         srtStat.Ndif = srtStat.Ndif + 1;
+         break;
+      }
+   }
+   srtStat.Nfrm  = srtStat.Nfrm + 1;
+   srtStat.Nelm  = srtStat.Nelm + n;
+   srtStat.Theap = srtStat.Theap + th;
+   srtStat.Tsort = srtStat.Tsort + ts;
+   if ( th > srtStat.Mheap ) srtStat.Mheap = th;
+   if ( ts > srtStat.Msort ) srtStat.Msort = ts;
+}
+
+/*
+ * PRINTS SORT BENCHMARK STATISTICS
+*/
+void SortReport( SortListPtr pSL )
+{
+   Longint  nfrm = ( srtStat.Nfrm > 0 ) ? srtStat.Nfrm : 1;
+
+   printf("SortReport:  %ld frames, %.1f polygons per frame\n",
+          srtStat.Nfrm, (Extended)srtStat.Nelm/nfrm);
+   printf("SortReport:  heap   mean %8.3f us  max %8.3f us\n",
+          1.0e6*srtStat.Theap/nfrm, 1.0e6*srtStat.Mheap);
+   printf("SortReport:  sort   mean %8.3f us  max %8.3f us\n",
+          1.0e6*srtStat.Tsort/nfrm, 1.0e6*srtStat.Msort);
+   printf("SortReport:  %.2f groups per frame, %.1f polygons in largest\n",
+          (Extended)pSL->Ngrp/nfrm, (Extended)pSL->Nbig/nfrm);
+   printf("SortReport:  %ld full sorts, %.2f insertion moves per frame, "
+          "%ld key order mismatches\n",
+          pSL->Nfull, (Extended)pSL->Nmove/nfrm, srtStat.Ndif);
+}
@@ -0,0 +1,146 @@
+/**********************************************************************/
+/* FILE:  strmlib.c
+ * DATE:  16 OCT 2026
+ * AUTH:  G. E. Deschaines
+ * DESC:  Methods to write rendered frames as an uncompressed video
+ *        stream to standard output, a named pipe or a file, so frames
+ *        can be piped directly into a video encoder such as ffmpeg
+ *        without intermediate image files.
+ *
+ *        Two stream formats are supported:
+ *
+ *          Y4M    - YUV4MPEG2 stream with header declaring frame size
+ *                   and rate, and 4:4:4 BT.601 YCbCr frames; e.g.,
+ *
+ *                     threeD.exe 0000 1 0 -headless -stream - |
+ *                        ffmpeg -i - img_anim.mp4
+ *
+ *          RGB24  - headerless packed RGB24 frames; e.g.,
+ *
+ *                     threeD.exe 0000 1 0 -headless -stream - -sfmt rgb |
+ *                        ffmpeg -f rawvideo -pix_fmt rgb24 -s 800x600
+ *                               -r 50 -i - img_anim.mp4
+ *
+ *        When streaming to standard output, the process standard
+ *        output is redirected to standard error so program messages
+ *        do not corrupt the frame stream.
+*/
+/**********************************************************************/
+
+#include <signal.h>
+
+#define StrmY4M  0  /* YUV4MPEG2 4:4:4 stream */
+#define StrmRGB  1  /* raw packed RGB24 stream */
+
+FILE           *strmFile = NULL;  /* frame stream output file        */
+Integer         strmFmt  = StrmY4M;
+Integer         strmWid  = 0;
+Integer         strmHgt  = 0;
+unsigned char  *strmRGB  = NULL;  /* packed RGB24 frame buffer       */
+unsigned char  *strmYUV  = NULL;  /* planar YCbCr 4:4:4 frame buffer */
+
+void StrmClose( void );
+
+/*
+ * OPENS FRAME STREAM TO GIVEN PATH ("-" FOR STANDARD OUTPUT) AND
+ * WRITES STREAM HEADER
+*/
+Boolean StrmOpen( const char *path, Integer fmt,
+                  Integer wid, Integer hgt, int fps )
+{
+   size_t  npix = (size_t)wid*(size_t)hgt;
+   int     fd;
+
+   if ( strcmp(path, "-") == 0 ) {
+      fflush(stdout);
+      fd = dup(fileno(stdout));
+      if ( ( fd < 0 ) || ( ( strmFile = fdopen(fd, "wb") ) == NULL ) ) {
+         fprintf(stderr,"StrmOpen:  dup error for standard output.\n");
+         return FALSE;
+      }
+      dup2(fileno(stderr), fileno(stdout));
+   } else {
+      strmFile = fopen(path, "wb");
+      if ( strmFile == NULL ) {
+         printf("StrmOpen:  fopen error for stream %s.\n",path);
+         return FALSE;
+      }
+   }
+   strmRGB = (unsigned char *)malloc(3*npix);
+   strmYUV = (unsigned char *)malloc(3*npix);
+   if ( ( strmRGB == NULL ) || ( strmYUV == NULL ) ) {
+      printf("StrmOpen:  malloc error for %dx%d frame buffers.\n",wid,hgt);
+      StrmClose();
+      return FALSE;
+   }
+
+   /* Report a closed reading end as a write error instead of dying. */
+   signal(SIGPIPE, SIG_IGN);
+
+   strmFmt = fmt;
+   strmWid = wid;
+   strmHgt = hgt;
+   if ( strmFmt == StrmY4M ) {
+      fprintf(strmFile,"YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n",
+              wid,hgt,fps);
+   }
+   return TRUE;
+}
+
+/*
+ * WRITES PACKED RGB24 FRAME IN strmRGB TO FRAME STREAM; RETURNS FALSE
+ * AND CLOSES STREAM IF IT CAN NO LONGER BE WRITTEN
+*/
+Boolean StrmFrame( void )
+{
+   size_t          npix = (size_t)strmWid*(size_t)strmHgt;
+   size_t          i;
+   unsigned char  *ptr;
+   unsigned char  *pY, *pU, *pV;
+   int             R, G, B;
+   Boolean         okay;
+
+   if ( strmFile == NULL ) return FALSE;
+   TRACE_BEG(1,"StrmFrame");
+
+   if ( strmFmt == StrmY4M ) {
+      pY  = strmYUV;
+      pU  = strmYUV + npix;
+      pV  = strmYUV + 2*npix;
+      ptr = strmRGB;
+      for ( i = 0 ; i < npix ; i++ ) {
+         R = ptr[0];
+         G = ptr[1];
+         B = ptr[2];
+         ptr += 3;
+         pY[i] = (unsigned char)( (( 66*R + 129*G +  25*B + 128) >> 8) +  16 );
+         pU[i] = (unsigned char)( ((-38*R -  74*G + 112*B + 128) >> 8) + 128 );
+         pV[i] = (unsigned char)( ((112*R -  94*G -  18*B + 128) >> 8) + 128 );
+      }
+      okay = ( fputs("FRAME\n", strmFile) >= 0 ) &&
+             ( fwrite(strmYUV, 1, 3*npix, strmFile) == 3*npix );
+   } else {
+      okay = ( fwrite(strmRGB, 1, 3*npix, strmFile) == 3*npix );
+   }
+   if ( ! okay ) {
+      fprintf(stderr,"StrmFrame:  write error on frame stream.\n");
+      StrmClose();
+   }
+   TRACE_END(1);
+   return okay;
+}
+
+/*
+ * FLUSHES AND CLOSES FRAME STREAM
+*/
+void StrmClose( void )
+{
+   if ( strmFile != NULL ) {
+      fclose(strmFile);
+      strmFile = NULL;
+   }
+   free(strmRGB);
+   free(strmYUV);
+   strmRGB = NULL;
+   strmYUV = NULL;
+}
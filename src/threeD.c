@@ -32,6 +32,7 @@
 #include <X11/keysym.h>
 #include <Xm/Xm.h>
 #include <Xm/DrawingA.h>
+#include <X11/extensions/Xdbe.h>
 
 static GC         the_GC;
 static XGCValues  the_GCv;
@@ -39,11 +40,38 @@ static int        img_FPS = 50;
 static int        run_NUM = 0;
 static int        msl_TYP = 1;
 static int        img_OUT = 0;
+static int        ren_MOD = 0;    /* 0=X11 server, 1=headless framebuffer, 2=framebuffer presented to window */
+static int        win_WID = 800;  // NOTE: Value for fovs in draw3D.c should
+static int        win_HGT = 600;  //       match the value of height here.
+static char       img_DIR[256] = "./Ximg";
+static char*      str_PATH = NULL;  /* frame stream path, "-"=stdout */
+static int        str_FMT = 0;      /* 0=Y4M, 1=raw RGB24 */
+static double     sek_TSEC = -1.0;  /* start time (sec), < 0 for first record */
+static char*      fol_PATH = NULL;  /* followed trajectory input, "-"=stdin */
+static int        txy_CNV = 0;    /* 1=TXYZ text to binary, 2=binary to text */
+static int        pak_CNV = 0;    /* 1=compile model files to model pack */
+static int        bat_MOD = 0;    /* 0=single run, 1=batch of runs */
+static int        bat_JOBS = 0;   /* batch workers, 0=all processors */
+static int        vec_ISA = -1;   /* -1=auto, 0=scalar, 1=SSE2, 2=AVX2 */
+static int        srt_BEN = 0;    /* 1=time depth sort against heap */
+static int        sta_OUT = 0;    /* 1=print rendering statistics */
+static long       scl_CNT = 1;    /* number of target model copies */
+static int        zbf_MOD = 0;    /* 1=z-buffered headless rendering */
+static int        thr_CNT = 1;    /* headless rasterizing threads, 0=all processors */
+static int        rat_FPS = 0;    /* fixed frame rate of interpolated poses, 0=per record */
+static int        wrt_CNT = 2;    /* captured image writer threads, 0=write inline */
+static int        wrt_QUE = 8;    /* captured image queue capacity (frames) */
+static int        wrt_DRP = 0;    /* 1=drop captured images while queue is full */
+static int        pip_USE = 0;    /* 1=run headless frames through threaded pipeline */
+static char*      bch_PATH = NULL;  /* per-stage frame timing JSON output file */
+static int        shm_USE = 1;    /* 1=present framebuffer with MIT-SHM when available */
+static int        dbe_USE = 0;    /* 1=draw into DBE window back buffer when available */
 static Pixel      pixels[8];
 static Boolean    quitflag = FALSE;
 
 
 #include "draw3D.c"
+#include "batchlib.c"
 
 void do_draw3D(w, client_data, event)
    Widget   w;
@@ -86,6 +114,124 @@ void do_keypress(w, client_data, event)
    }
 }
 
+/* Removes threeD specific options from the command line argument
+ * list, leaving positional arguments and any X Toolkit options in
+ * place for subsequent processing.
+*/
+void ParseOptions(pargc, argv)
+   int*   pargc;
+   char*  argv[];
+{
+   int  i, j;
+   int  hdl = 0;  /* -headless given */
+   int  cli = 0;  /* -client given */
+
+   for ( i = 1, j = 1 ; i < *pargc ; i++ ) {
+      if ( strcmp(argv[i], "-headless") == 0 ) {
+         /* Render into client-side framebuffer without an X server. */
+         hdl = 1;
+      } else if ( strcmp(argv[i], "-batch") == 0 ) {
+         /* Run number argument is a list, range or glob of runs. */
+         bat_MOD = 1;
+      } else if ( ( strcmp(argv[i], "-stream") == 0 ) && ( i+1 < *pargc ) ) {
+         /* Write frames as video stream to file, pipe or stdout ("-"). */
+         str_PATH = argv[++i];
+      } else if ( ( strcmp(argv[i], "-sfmt") == 0 ) && ( i+1 < *pargc ) ) {
+         /* Frame stream format: y4m or rgb. */
+         str_FMT = ( strcmp(argv[++i], "rgb") == 0 ) ? 1 : 0;
+      } else if ( ( strcmp(argv[i], "-seek") == 0 ) && ( i+1 < *pargc ) ) {
+         /* Start animation at given trajectory time (sec). */
+         sek_TSEC = atof(argv[++i]);
+      } else if ( ( strcmp(argv[i], "-rate") == 0 ) && ( i+1 < *pargc ) ) {
+         /* Frames per trajectory second, interpolating between records. */
+         rat_FPS = atoi(argv[++i]);
+         if ( rat_FPS > 0 ) img_FPS = rat_FPS;
+      } else if ( ( strcmp(argv[i], "-follow") == 0 ) && ( i+1 < *pargc ) ) {
+         /* Render records as written to stdin ("-"), FIFO or file. */
+         fol_PATH = argv[++i];
+      } else if ( strcmp(argv[i], "-tobin") == 0 ) {
+         /* Convert TXYZ.OUT.#### text file to TXYZ.BIN.#### binary. */
+         txy_CNV = 1;
+      } else if ( strcmp(argv[i], "-totxt") == 0 ) {
+         /* Convert TXYZ.BIN.#### binary file to TXYZ.TXT.#### text. */
+         txy_CNV = 2;
+      } else if ( strcmp(argv[i], "-topak") == 0 ) {
+         /* Compile ./dat polygon model files to ./dat/models.pak pack. */
+         pak_CNV = 1;
+      } else if ( ( strcmp(argv[i], "-jobs") == 0 ) && ( i+1 < *pargc ) ) {
+         /* Number of batch worker processes. */
+         bat_JOBS = atoi(argv[++i]);
+      } else if ( strcmp(argv[i], "-sortbench") == 0 ) {
+         /* Time depth sort against heap priority queue each frame. */
+         srt_BEN = 1;
+      } else if ( strcmp(argv[i], "-stats") == 0 ) {
+         /* Print object culling and other rendering statistics. */
+         sta_OUT = 1;
+      } else if ( strcmp(argv[i], "-zbuffer") == 0 ) {
+         /* Render headless with depth buffer instead of depth sort. */
+         zbf_MOD = 1;
+      } else if ( strcmp(argv[i], "-client") == 0 ) {
+         /* Render into client-side framebuffer presented to window. */
+         cli = 1;
+      } else if ( strcmp(argv[i], "-noshm") == 0 ) {
+         /* Present framebuffer with XPutImage instead of MIT-SHM. */
+         shm_USE = 0;
+      } else if ( strcmp(argv[i], "-dbe") == 0 ) {
+         /* Swap DBE window buffers instead of copying pixmaps. */
+         dbe_USE = 1;
+      } else if ( ( strcmp(argv[i], "-threads") == 0 ) && ( i+1 < *pargc ) ) {
+         /* Number of tile-parallel headless rasterizing threads. */
+         thr_CNT = atoi(argv[++i]);
+      } else if ( ( strcmp(argv[i], "-writers") == 0 ) && ( i+1 < *pargc ) ) {
+         /* Number of captured image writer threads, 0=write inline. */
+         wrt_CNT = atoi(argv[++i]);
+      } else if ( ( strcmp(argv[i], "-wqueue") == 0 ) && ( i+1 < *pargc ) ) {
+         /* Captured image queue capacity (frames). */
+         wrt_QUE = atoi(argv[++i]);
+      } else if ( strcmp(argv[i], "-wdrop") == 0 ) {
+         /* Drop captured images while queue is full instead of waiting. */
+         wrt_DRP = 1;
+      } else if ( strcmp(argv[i], "-pipeline") == 0 ) {
+         /* Parse, transform, rasterize and write headless frames on threads. */
+         pip_USE = 1;
+      } else if ( ( strcmp(argv[i], "-bench") == 0 ) && ( i+1 < *pargc ) ) {
+         /* Append per-stage frame timing of run as JSON line to file. */
+         bch_PATH = argv[++i];
+      } else if ( ( strcmp(argv[i], "-size") == 0 ) && ( i+1 < *pargc ) ) {
+         /* Headless frame width and height (e.g., 1920x1080). */
+         if ( sscanf(argv[++i], "%dx%d", &win_WID, &win_HGT) != 2 ) {
+            win_WID = 800;
+            win_HGT = 600;
+         }
+      } else if ( ( strcmp(argv[i], "-scale") == 0 ) && ( i+1 < *pargc ) ) {
+         /* Replicate target model into a lattice of given copies. */
+         scl_CNT = atol(argv[++i]);
+      } else if ( ( strcmp(argv[i], "-simd") == 0 ) && ( i+1 < *pargc ) ) {
+         /* Transformation kernels: auto, scalar, sse2 or avx2. */
+         i++;
+         if      ( strcmp(argv[i], "scalar") == 0 ) vec_ISA = XfrmScalar;
+         else if ( strcmp(argv[i], "sse2")   == 0 ) vec_ISA = XfrmSSE2;
+         else if ( strcmp(argv[i], "avx2")   == 0 ) vec_ISA = XfrmAVX2;
+         else                                       vec_ISA = XfrmAuto;
+      } else {
+         argv[j++] = argv[i];
+      }
+   }
+   argv[j] = NULL;
+   *pargc  = j;
+
+   /* Rendering mode, whatever the order of options: batch and headless
+      runs have no window, and the depth buffer needs a client-side
+      framebuffer, so it renders headless unless presented to a window.
+   */
+   if      ( ( bat_MOD == 1 ) || ( hdl == 1 ) ) ren_MOD = 1;
+   else if ( cli == 1 )                         ren_MOD = 2;
+   else if ( zbf_MOD == 1 ) {
+      printf("threeD:  -zbuffer renders headless; add -client to show frames in a window.\n");
+      ren_MOD = 1;
+   }
+}
+
 int main(argc, argv)
    int    argc;
    char*  argv[];
@@ -96,10 +242,20 @@ int main(argc, argv)
    Arg           wargs[10];
    int           n=0;
 
-/* Process execution command line arguments.
+/* Process execution command line options and arguments.
 */
-   /* Trajectory run number. */
-   if (argc > 1) {
+   ParseOptions(&argc, argv);
+   /* Frame width and height are held as Integer pixel coordinates. */
+   if ( ( win_WID < 1 ) || ( win_WID > 32767 ) ||
+        ( win_HGT < 1 ) || ( win_HGT > 32767 ) ) {
+      printf("threeD:  -size %dx%d out of range; width and height must be 1 to 32767.\n",
+             win_WID,win_HGT);
+      return 1;
+   }
+   TRACE_INIT();
+
+   /* Trajectory run number, or run specification for batch mode. */
+   if ((argc > 1) && (bat_MOD == 0)) {
       int i = atoi(argv[1]);
       if ((i >= 0) && (i <= 9999)) {
          run_NUM = i;
@@ -120,6 +276,47 @@ int main(argc, argv)
       }
    }
 
+/* Trajectory file format conversion without rendering.
+*/
+   if ( txy_CNV == 1 ) {
+      return TxyzToBin(run_NUM) ? 0 : 1;
+   }
+   if ( txy_CNV == 2 ) {
+      return TxyzToTxt(run_NUM) ? 0 : 1;
+   }
+
+/* Model file compilation to model pack without rendering.
+*/
+   if ( pak_CNV == 1 ) {
+      return PackWrite() ? 0 : 1;
+   }
+
+/* Select vertex transformation kernels for this processor.
+*/
+   XfrmInit(vec_ISA);
+
+/* Batch rendering of many runs is always headless.
+*/
+   if ( bat_MOD == 1 ) {
+      if ( ( str_PATH != NULL ) || ( fol_PATH != NULL ) ) {
+         printf("threeD:  -stream and -follow not supported with -batch.\n");
+         return 1;
+      }
+      if ( argc < 2 ) {
+         printf("threeD:  -batch requires a run specification.\n");
+         return 1;
+      }
+      return ( BatchRender(argv[1], bat_JOBS) == 0 ) ? 0 : 1;
+   }
+
+/* Headless rendering draws into a client-side framebuffer, needing
+   neither an X server connection nor an event loop.
+*/
+   if ( ren_MOD == 1 ) {
+      draw3D(NULL, NULL, None);
+      return quitflag ? 1 : 0;
+   }
+
 /* Initialize the X Toolkit Intrinsics.
 */
    XtToolkitInitialize();
@@ -146,8 +343,8 @@ int main(argc, argv)
 
 /* Create a widget.
 */
-   XtSetArg(wargs[n], XtNwidth,  800); n++;  // NOTE: Value for fovs in draw3D.c should match
-   XtSetArg(wargs[n], XtNheight, 600); n++;  //       the value of height here.
+   XtSetArg(wargs[n], XtNwidth,  win_WID); n++;
+   XtSetArg(wargs[n], XtNheight, win_HGT); n++;
 
    a_widget = XtCreateManagedWidget("a_widget",
                                      xmDrawingAreaWidgetClass,
@@ -178,6 +375,10 @@ int main(argc, argv)
    printf("Press Left Arrow key to slow animation down by 10 msec increments.\n");
    printf("Press Right Arrow key to speed animation up by 10 msec increments.\n");
    printf("Press SPACE key to toggle pause/unpause.\n");
+   printf("Press . (period) or , (comma) key to step forward or backward one frame.\n");
+   printf("Press ] or [ key to scrub forward or backward one second.\n");
+   printf("Press Home or End key to jump to first or last frame.\n");
+   printf("Press B key to toggle backward playback.\n");
 // printf("Press C key to continue.\n");
    printf("Press Q key to quit animation.\n");
    printf("Press R key to replay animation.\n"); 
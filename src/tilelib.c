@@ -0,0 +1,507 @@
+/**********************************************************************/
+/* FILE:  tilelib.c
+ * DATE:  16 OCT 2026
+ * AUTH:  G. E. Deschaines
+ * DESC:  Tile-parallel rasterization of client-side framebuffer
+ *        primitives on a pool of worker threads.
+ *
+ *        While tiling is enabled, the primitives of a frame are not
+ *        rasterized as they are drawn, but recorded in a display list
+ *        along with the graphics context state they are drawn with.
+ *        Each recorded primitive is binned into every screen tile its
+ *        bounding box overlaps, keeping drawing order within each
+ *        tile's bin.  When the frame is flushed, worker threads and
+ *        the calling thread take tiles in turn and rasterize each
+ *        tile's primitives through a view of the framebuffer clipped
+ *        to the tile.  Since the fbuflib rasterizing methods compute
+ *        pixel coverage and depth independently of clipping, and no
+ *        two tiles share a pixel, the frame is identical to one drawn
+ *        directly on a single thread.
+ *
+ *        Primitives may be recorded into one display list while
+ *        another, of a framebuffer of the same size, is rasterized by
+ *        another thread, as by the raster stage of a frame pipeline.
+ *
+ *        If the display list or a tile bin cannot grow to record a
+ *        primitive, the first such failure of a frame is reported and
+ *        the frame is marked failed, so rasterizing it returns FALSE
+ *        rather than silently producing a frame missing primitives.
+*/
+/**********************************************************************/
+
+#include <pthread.h>
+
+#define tlSize    64   /* screen tile width and height (pixels)     */
+#define tlMaxThr  64   /* maximum number of rasterizing threads     */
+
+#define tlFill     0   /* FbFillPolygon primitive                   */
+#define tlLines    1   /* FbDrawLines primitive                     */
+#define tlRect     2   /* FbDrawRectangle primitive                 */
+#define tlString   3   /* FbDrawImageString primitive               */
+#define tlClrDep   4   /* FbClearDepth of whole framebuffer         */
+#define tlSegs     5   /* FbDrawSegments primitive                  */
+
+typedef struct
+{
+  Integer        Typ;   /* primitive type                           */
+  unsigned char  Fgc;   /* foreground color index                   */
+  unsigned char  Bgc;   /* background color index                   */
+  Integer        Lwd;   /* line width                               */
+  Boolean        Dtst;  /* depth tested                             */
+  double         DepA;  /* depth plane and tolerance                */
+  double         DepB;
+  double         DepC;
+  double         DepT;
+  Integer        X;     /* rectangle or string origin               */
+  Integer        Y;
+  Integer        W;     /* rectangle width and height               */
+  Integer        H;
+  Longint        Off;   /* offset of points or characters in store  */
+  Longint        Cnt;   /* number of points or characters           */
+} TileCmd;
+
+typedef struct
+{
+  Longint  *Cmd;  /* indices of primitives binned into tile */
+  Longint   Cnt;
+  Longint   Max;
+} TileBin;
+
+typedef struct
+{
+  FrmBuf     *Fb;     /* framebuffer of recorded primitives       */
+  TileBin    *Bins;
+  TileCmd    *Cmds;   /* display list                             */
+  Longint     Ncmd;
+  Longint     Mcmd;
+  XPoint     *Pnts;   /* point store                              */
+  Longint     Npnt;
+  Longint     Mpnt;
+  char       *Chrs;   /* character store                          */
+  Longint     Nchr;
+  Longint     Mchr;
+  Boolean     Fail;   /* a primitive could not be recorded        */
+} TileList;
+
+typedef struct
+{
+  Integer     Nthr;   /* number of rasterizing threads, 0 if off  */
+  Integer     Ntx;    /* number of tile columns and rows          */
+  Integer     Nty;
+  TileList    Own;    /* display list of framebuffer of pool      */
+  TileList   *Rec;    /* display list primitives are recorded in  */
+  TileList   *Run;    /* display list being rasterized            */
+  Longint     Next;   /* next tile to be rasterized               */
+  Integer     Busy;   /* number of workers rasterizing            */
+  Longint     Gen;    /* flush generation                         */
+  Boolean     Quit;   /* workers to exit                          */
+  pthread_mutex_t  Mtx;
+  pthread_cond_t   Go;
+  pthread_cond_t   Done;
+  pthread_t        Thr[tlMaxThr];
+} TilePool;
+
+TilePool  tiles = { 0 };
+
+/*
+ * Rasterizes recorded primitive through framebuffer view of tile.
+*/
+static void TileDraw( FrmBuf *view, TileList *lst, TileCmd *cmd )
+{
+   fbFgClr  = cmd->Fgc;
+   fbBgClr  = cmd->Bgc;
+   fbLinWid = cmd->Lwd;
+   fbDepTst = cmd->Dtst;
+   fbDepA   = cmd->DepA;
+   fbDepB   = cmd->DepB;
+   fbDepC   = cmd->DepC;
+   fbDepTol = cmd->DepT;
+   switch ( cmd->Typ ) {
+   case tlFill :
+      FbFillPolygon(view, &lst->Pnts[cmd->Off], cmd->Cnt);
+      break;
+   case tlLines :
+      FbDrawLines(view, &lst->Pnts[cmd->Off], cmd->Cnt);
+      break;
+   case tlRect :
+      FbDrawRectangle(view, cmd->X, cmd->Y, cmd->W, cmd->H);
+      break;
+   case tlString :
+      FbDrawImageString(view, cmd->X, cmd->Y,
+                        &lst->Chrs[cmd->Off], (Integer)cmd->Cnt);
+      break;
+   case tlClrDep :
+      FbClearDepth(view);
+      break;
+   case tlSegs :
+      FbDrawSegments(view, (XSegment *)&lst->Pnts[cmd->Off], cmd->Cnt/2);
+      break;
+   }
+}
+
+/*
+ * Rasterizes binned primitives of tiles taken in turn until none are
+ * left.
+*/
+static void TileWork( void )
+{
+   TileList  *lst = tiles.Run;
+   FrmBuf     view;
+   TileBin   *bin;
+   Longint    itl, ntl, i;
+
+   ntl = (Longint)tiles.Ntx*tiles.Nty;
+   while ( ( itl = __sync_fetch_and_add(&tiles.Next, 1) ) < ntl ) {
+      bin = &lst->Bins[itl];
+      if ( bin->Cnt == 0 ) continue;
+      FbView(&view, lst->Fb, (Integer)((itl % tiles.Ntx)*tlSize),
+                              (Integer)((itl / tiles.Ntx)*tlSize),
+                              (Integer)((itl % tiles.Ntx + 1)*tlSize),
+                              (Integer)((itl / tiles.Ntx + 1)*tlSize));
+      for ( i = 0 ; i < bin->Cnt ; i++ ) {
+         TileDraw(&view, lst, &lst->Cmds[bin->Cmd[i]]);
+      }
+   }
+}
+
+/*
+ * Worker thread loop rasterizing tiles of each flushed frame.
+*/
+static void *TileWorker( void *arg )
+{
+   Longint  gen = 0;
+
+   (void)arg;
+   TRACE_THREAD("tile");
+   pthread_mutex_lock(&tiles.Mtx);
+   for (;;) {
+      while ( ( tiles.Gen == gen ) && ( ! tiles.Quit ) ) {
+         pthread_cond_wait(&tiles.Go, &tiles.Mtx);
+      }
+      if ( tiles.Quit ) break;
+      gen = tiles.Gen;
+      pthread_mutex_unlock(&tiles.Mtx);
+      TRACE_BEG(1,"TileWork");
+      TileWork();
+      TRACE_END(1);
+      pthread_mutex_lock(&tiles.Mtx);
+      if ( --tiles.Busy == 0 ) pthread_cond_signal(&tiles.Done);
+   }
+   pthread_mutex_unlock(&tiles.Mtx);
+   return NULL;
+}
+
+/*
+ * Makes empty display list of primitives recorded for framebuffer fb,
+ * which must be of the size given to TileCreate.
+*/
+Boolean TileListCreate( TileList *lst, FrmBuf *fb )
+{
+   memset(lst, 0, sizeof(TileList));
+   lst->Fb   = fb;
+   lst->Bins = (TileBin *)calloc((size_t)tiles.Ntx*tiles.Nty, sizeof(TileBin));
+   if ( lst->Bins == NULL ) {
+      printf("TileListCreate:  calloc error for %dx%d tiles.\n",tiles.Ntx,tiles.Nty);
+      return FALSE;
+   }
+   return TRUE;
+}
+
+/*
+ * Frees display list and tile bins.
+*/
+void TileListFree( TileList *lst )
+{
+   Longint  i, ntl;
+
+   if ( lst->Bins != NULL ) {
+      ntl = (Longint)tiles.Ntx*tiles.Nty;
+      for ( i = 0 ; i < ntl ; i++ ) free(lst->Bins[i].Cmd);
+      free(lst->Bins);
+   }
+   free(lst->Cmds);
+   free(lst->Pnts);
+   free(lst->Chrs);
+   memset(lst, 0, sizeof(TileList));
+}
+
+/*
+ * Enables tiled rasterization into framebuffer fb with nthr threads,
+ * or all online processors if nthr is 0.  Tiling is left disabled
+ * if only one thread would be used, unless always is TRUE (e.g., for
+ * a rasterizing stage of a frame pipeline).
+*/
+Boolean TileCreate( FrmBuf *fb, Integer nthr, Boolean always )
+{
+   Integer  i;
+
+   if ( nthr <= 0 ) nthr = (Integer)sysconf(_SC_NPROCESSORS_ONLN);
+   if ( nthr > tlMaxThr ) nthr = tlMaxThr;
+   if ( ( nthr <= 1 ) && ! always ) return TRUE;
+
+   tiles.Ntx = (fb->Wid + tlSize - 1)/tlSize;
+   tiles.Nty = (fb->Hgt + tlSize - 1)/tlSize;
+   if ( ! TileListCreate(&tiles.Own, fb) ) return FALSE;
+   tiles.Rec = &tiles.Own;
+   pthread_mutex_init(&tiles.Mtx, NULL);
+   pthread_cond_init(&tiles.Go, NULL);
+   pthread_cond_init(&tiles.Done, NULL);
+   for ( i = 1 ; i < nthr ; i++ ) {
+      if ( pthread_create(&tiles.Thr[i], NULL, TileWorker, NULL) != 0 ) {
+         printf("TileCreate:  pthread_create error for thread %d.\n",i);
+         break;
+      }
+   }
+   tiles.Nthr = i;
+#if DBG_LVL > 0
+   printf("TileCreate:  %dx%d tiles, %d threads\n",
+          tiles.Ntx,tiles.Nty,tiles.Nthr);
+#endif
+   return TRUE;
+}
+
+/*
+ * Directs primitives drawn from now on to be recorded in display
+ * list lst.
+*/
+void TileRecord( TileList *lst )
+{
+   tiles.Rec = lst;
+}
+
+/*
+ * Marks frame being recorded as failed, reporting the first primitive
+ * of the frame that function func could not record.
+*/
+static void TileLost( const char *func )
+{
+   TileList  *lst = tiles.Rec;
+
+   if ( ! lst->Fail ) {
+      printf("%s:  out of memory; frame is missing primitive %ld.\n",
+             func,lst->Ncmd);
+   }
+   lst->Fail = TRUE;
+}
+
+/*
+ * Appends new primitive with current graphics context state to the
+ * display list, returning NULL if out of memory.
+*/
+static TileCmd *TileAdd( Integer typ )
+{
+   TileList  *lst = tiles.Rec;
+   TileCmd   *cmd;
+
+   if ( ! GrowList((void **)&lst->Cmds, &lst->Mcmd, lst->Ncmd+1,
+                   sizeof(TileCmd), 4096) ) {
+      TileLost("TileAdd");
+      return NULL;
+   }
+   cmd = &lst->Cmds[lst->Ncmd];
+   cmd->Typ  = typ;
+   cmd->Fgc  = fbFgClr;
+   cmd->Bgc  = fbBgClr;
+   cmd->Lwd  = fbLinWid;
+   cmd->Dtst = fbDepTst;
+   cmd->DepA = fbDepA;
+   cmd->DepB = fbDepB;
+   cmd->DepC = fbDepC;
+   cmd->DepT = fbDepTol;
+   return cmd;
+}
+
+/*
+ * Bins last added primitive into tiles overlapped by pixel bounding
+ * box [x0,x1] x [y0,y1].
+*/
+static void TileBinCmd( Longint x0, Longint y0, Longint x1, Longint y1 )
+{
+   TileList  *lst = tiles.Rec;
+   TileBin   *bin;
+   Longint    tx0, ty0, tx1, ty1, tx, ty;
+
+   tx0 = lmax(x0, 0)/tlSize;
+   ty0 = lmax(y0, 0)/tlSize;
+   tx1 = lmin(x1, lst->Fb->Wid - 1);
+   ty1 = lmin(y1, lst->Fb->Hgt - 1);
+   if ( ( tx1 < 0 ) || ( ty1 < 0 ) ) return;
+   tx1 = tx1/tlSize;
+   ty1 = ty1/tlSize;
+   for ( ty = ty0 ; ty <= ty1 ; ty++ ) {
+      for ( tx = tx0 ; tx <= tx1 ; tx++ ) {
+         bin = &lst->Bins[ty*tiles.Ntx + tx];
+         if ( ! GrowList((void **)&bin->Cmd, &bin->Max, bin->Cnt+1,
+                         sizeof(Longint), 256) ) {
+            TileLost("TileBinCmd");
+            continue;
+         }
+         bin->Cmd[bin->Cnt++] = lst->Ncmd;
+      }
+   }
+   lst->Ncmd++;
+}
+
+/*
+ * Records polygon fill, connected lines or line segments (as pairs of
+ * end points) primitive of given type.
+ * Wide line bounding boxes are padded by the longest JoinMiter join
+ * extent, half the line width over the sine of half the 11 degree
+ * miter limit angle.
+*/
+static void TilePoints( Integer typ, XPoint *pts, Longint npts )
+{
+   TileList  *lst = tiles.Rec;
+   TileCmd   *cmd;
+   Longint    x0, y0, x1, y1, pad;
+   Longint    i;
+
+   if ( npts < 2 ) return;
+   if ( ! GrowList((void **)&lst->Pnts, &lst->Mpnt, lst->Npnt+npts,
+                   sizeof(XPoint), 16384) ) {
+      TileLost("TilePoints");
+      return;
+   }
+   if ( ( cmd = TileAdd(typ) ) == NULL ) return;
+   cmd->Off = lst->Npnt;
+   cmd->Cnt = npts;
+   memcpy(&lst->Pnts[lst->Npnt], pts, npts*sizeof(XPoint));
+   lst->Npnt += npts;
+
+   x0 = x1 = pts[0].x;
+   y0 = y1 = pts[0].y;
+   for ( i = 1 ; i < npts ; i++ ) {
+      x0 = lmin(x0, pts[i].x);
+      x1 = lmax(x1, pts[i].x);
+      y0 = lmin(y0, pts[i].y);
+      y1 = lmax(y1, pts[i].y);
+   }
+   pad = ( typ != tlFill ) ? (Longint)ceil(fbLinWid*5.22) + 1 : 0;
+   TileBinCmd(x0 - pad, y0 - pad, x1 + pad, y1 + pad);
+}
+
+void TileFillPolygon( XPoint *pts, Longint npts )
+{
+   TilePoints(tlFill, pts, npts);
+}
+
+void TileDrawLines( XPoint *pts, Longint npts )
+{
+   TilePoints(tlLines, pts, npts);
+}
+
+void TileDrawSegments( XSegment *segs, Longint nsegs )
+{
+   TilePoints(tlSegs, (XPoint *)segs, 2*nsegs);
+}
+
+void TileDrawRectangle( Integer x, Integer y, Integer w, Integer h )
+{
+   TileCmd  *cmd;
+
+   if ( ( cmd = TileAdd(tlRect) ) == NULL ) return;
+   cmd->X = x;
+   cmd->Y = y;
+   cmd->W = w;
+   cmd->H = h;
+   TileBinCmd(x, y, x + w, y + h);
+}
+
+void TileDrawImageString( Integer x, Integer y, const char *str, Integer len )
+{
+   TileList  *lst = tiles.Rec;
+   TileCmd   *cmd;
+
+   if ( ! GrowList((void **)&lst->Chrs, &lst->Mchr, lst->Nchr+len,
+                   sizeof(char), 256) ) {
+      TileLost("TileDrawImageString");
+      return;
+   }
+   if ( ( cmd = TileAdd(tlString) ) == NULL ) return;
+   cmd->X   = x;
+   cmd->Y   = y;
+   cmd->Off = lst->Nchr;
+   cmd->Cnt = len;
+   memcpy(&lst->Chrs[lst->Nchr], str, len);
+   lst->Nchr += len;
+   TileBinCmd(x, y - fbFntAsc, x + len*fbFntWid - 1, y - fbFntAsc + fbFntHgt - 1);
+}
+
+void TileClearDepth( void )
+{
+   if ( TileAdd(tlClrDep) == NULL ) return;
+   TileBinCmd(0, 0, tiles.Rec->Fb->Wid - 1, tiles.Rec->Fb->Hgt - 1);
+}
+
+/*
+ * Rasterizes recorded primitives of display list lst on the worker
+ * threads and calling thread, then empties the display list and tile
+ * bins.  Only one thread at a time may rasterize, but it need not be
+ * the thread recording primitives into another display list.  Returns
+ * FALSE if the frame failed, missing primitives that could not be
+ * recorded.
+*/
+Boolean TileRaster( TileList *lst )
+{
+   Boolean  okay = ! lst->Fail;
+   Longint  i, ntl;
+
+   lst->Fail = FALSE;
+   if ( lst->Ncmd == 0 ) return okay;
+
+   TRACE_BEG(1,"TileRaster");
+   pthread_mutex_lock(&tiles.Mtx);
+   tiles.Run  = lst;
+   tiles.Next = 0;
+   tiles.Busy = tiles.Nthr - 1;
+   tiles.Gen++;
+   pthread_cond_broadcast(&tiles.Go);
+   pthread_mutex_unlock(&tiles.Mtx);
+
+   TRACE_BEG(1,"TileWork");
+   TileWork();
+   TRACE_END(1);
+
+   pthread_mutex_lock(&tiles.Mtx);
+   while ( tiles.Busy > 0 ) pthread_cond_wait(&tiles.Done, &tiles.Mtx);
+   pthread_mutex_unlock(&tiles.Mtx);
+
+   ntl = (Longint)tiles.Ntx*tiles.Nty;
+   for ( i = 0 ; i < ntl ; i++ ) lst->Bins[i].Cnt = 0;
+   lst->Ncmd = 0;
+   lst->Npnt = 0;
+   lst->Nchr = 0;
+   TRACE_END(1);
+   return okay;
+}
+
+/*
+ * Rasterizes recorded primitives of the display list being recorded,
+ * returning FALSE if the frame failed.
+*/
+Boolean TileFlush( void )
+{
+   return TileRaster(tiles.Rec);
+}
+
+/*
+ * Stops worker threads and frees display list and tile bins.
+*/
+void TileFree( void )
+{
+   Longint  i;
+
+   if ( tiles.Nthr == 0 ) return;
+
+   pthread_mutex_lock(&tiles.Mtx);
+   tiles.Quit = TRUE;
+   pthread_cond_broadcast(&tiles.Go);
+   pthread_mutex_unlock(&tiles.Mtx);
+   for ( i = 1 ; i < tiles.Nthr ; i++ ) pthread_join(tiles.Thr[i], NULL);
+
+   TileListFree(&tiles.Own);
+   memset(&tiles, 0, sizeof(tiles));
+}
+
+/**********************************************************************/
+/**********************************************************************/
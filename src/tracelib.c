@@ -0,0 +1,214 @@
+/**********************************************************************/
+/* FILE:  tracelib.c
+ * DATE:  16 OCT 2026
+ * AUTH:  G. E. Deschaines
+ * DESC:  Chrome trace instrumentation of rendering stages.
+ *
+ *        When compiled with TRC_LVL greater than 0 (e.g., with
+ *        CDEFS=-DLINUX -DDBG_LVL=0 -DTRC_LVL=1), scoped trace points
+ *        bracketing model loading, trajectory reading, the stages of
+ *        each frame in draw3D(), grid drawing, X server flushes and
+ *        synchronization, image and stream output, tiled and pipeline
+ *        rasterization and captured image writing record a complete
+ *        event of their thread, start time and duration in a buffer
+ *        in memory.  Level 2 adds polygon drawing and clipping in
+ *        DrawPoly3D, one event per polygon.  At exit, the events are
+ *        written to ./threeD_trace.json in the Chrome trace event
+ *        JSON format, for viewing with about:tracing in Chrome or at
+ *        ui.perfetto.dev.  Batch worker processes write their events
+ *        to ./threeD_trace.<pid>.json instead.
+ *
+ *        With TRC_LVL 0 (the default), the TRACE_ macros expand to
+ *        nothing, like the DBG_LVL printf blocks, so the trace points
+ *        cost nothing in production builds.
+ *
+ *        Each thread keeps its own stack of open trace point names
+ *        and start times, and completed events are appended to the
+ *        shared buffer at an atomically incremented index, so trace
+ *        points may be used on any thread.  Events past the buffer capacity
+ *        are counted and dropped.
+*/
+/**********************************************************************/
+
+#ifndef TRC_LVL
+#define TRC_LVL 0
+#endif
+
+#if TRC_LVL > 0
+
+#define trcMaxEvt  (1L << 20)  /* capacity of event buffer          */
+#define trcMaxDep  32          /* depth of nested trace points      */
+#define trcMaxThr  128         /* number of named threads           */
+
+typedef struct
+{
+  const char  *Name;  /* trace point name (string literal)         */
+  Integer      Tid;   /* thread number                             */
+  Extended     Ts;    /* start time (usec)                         */
+  Extended     Dur;   /* duration (usec)                           */
+} TraceEvt;
+
+typedef struct
+{
+  TraceEvt    *Evt;              /* event buffer                   */
+  Longint      Cnt;              /* number of events appended      */
+  Longint      Drop;             /* events dropped when full       */
+  Integer      Nthr;             /* number of threads numbered     */
+  const char  *Thr[trcMaxThr];   /* names of numbered threads      */
+  Extended     T0;               /* trace start time (sec)         */
+  pid_t        Pid;              /* process starting trace         */
+} Trace;
+
+Trace  trace;
+
+static __thread Integer      trcTid = 0;          /* thread number  */
+static __thread Integer      trcDep = 0;          /* open points    */
+static __thread const char  *trcNam[trcMaxDep];   /* names          */
+static __thread Extended     trcBeg[trcMaxDep];   /* start times    */
+
+void TraceWrite( void );
+
+/*
+ * RETURNS MONOTONIC CLOCK TIME SINCE START OF TRACE (USEC)
+*/
+static Extended TraceUsec( void )
+{
+   struct timespec  t;
+
+   clock_gettime(CLOCK_MONOTONIC, &t);
+   return 1.0e6*((Extended)t.tv_sec + 1.0e-9*(Extended)t.tv_nsec - trace.T0);
+}
+
+/*
+ * NUMBERS CALLING THREAD, NAMING IT IF name IS NOT NULL
+*/
+void TraceThread( const char *name )
+{
+   Integer  tid;
+
+   if ( trcTid == 0 ) {
+      tid = (Integer)__sync_add_and_fetch(&trace.Nthr, 1);
+      trcTid = tid;
+   }
+   if ( ( name != NULL ) && ( trcTid <= trcMaxThr ) ) {
+      trace.Thr[trcTid-1] = name;
+   }
+}
+
+/*
+ * ALLOCATES EVENT BUFFER AND ARRANGES FOR EVENTS TO BE WRITTEN AT EXIT
+*/
+void TraceInit( void )
+{
+   struct timespec  t;
+
+   trace.Evt = (TraceEvt *)malloc(trcMaxEvt*sizeof(TraceEvt));
+   if ( trace.Evt == NULL ) {
+      printf("TraceInit:  malloc error for %ld events.\n",trcMaxEvt);
+      return;
+   }
+   clock_gettime(CLOCK_MONOTONIC, &t);
+   trace.T0  = (Extended)t.tv_sec + 1.0e-9*(Extended)t.tv_nsec;
+   trace.Pid = getpid();
+   TraceThread("main");
+   atexit(TraceWrite);
+}
+
+/*
+ * OPENS TRACE POINT OF CALLING THREAD
+*/
+void TraceBeg( const char *name )
+{
+   if ( trcTid == 0 ) TraceThread(NULL);
+   if ( trcDep < trcMaxDep ) {
+      trcNam[trcDep] = name;
+      trcBeg[trcDep] = TraceUsec();
+   }
+   trcDep = trcDep + 1;
+}
+
+/*
+ * CLOSES LAST OPENED TRACE POINT OF CALLING THREAD, APPENDING ITS
+ * COMPLETE EVENT TO THE BUFFER
+*/
+void TraceEnd( void )
+{
+   TraceEvt  *evt;
+   Longint    k;
+
+   if ( trcDep == 0 ) return;
+   trcDep = trcDep - 1;
+   if ( ( trcDep >= trcMaxDep ) || ( trace.Evt == NULL ) ) return;
+
+   k = __sync_fetch_and_add(&trace.Cnt, 1);
+   if ( k >= trcMaxEvt ) {
+      __sync_fetch_and_add(&trace.Drop, 1);
+      return;
+   }
+   evt = &trace.Evt[k];
+   evt->Name = trcNam[trcDep];
+   evt->Tid  = trcTid;
+   evt->Ts   = trcBeg[trcDep];
+   evt->Dur  = TraceUsec() - evt->Ts;
+}
+
+/*
+ * WRITES BUFFERED EVENTS IN CHROME TRACE EVENT JSON FORMAT
+*/
+void TraceWrite( void )
+{
+   FILE     *fp;
+   char      fpath[64];
+   pid_t     pid = getpid();
+   Longint   n, k;
+   Integer   i;
+
+   if ( trace.Evt == NULL ) return;
+   n = lmin(trace.Cnt, trcMaxEvt);
+
+   if ( pid == trace.Pid ) sprintf(fpath,"./threeD_trace.json");
+   else                    sprintf(fpath,"./threeD_trace.%d.json",(int)pid);
+   fp = fopen(fpath, "w");
+   if ( fp == NULL ) {
+      printf("TraceWrite:  fopen error for %s.\n",fpath);
+      return;
+   }
+   fprintf(fp,"{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+   fprintf(fp,"{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": %d, "
+              "\"args\": {\"name\": \"threeD\"}}",(int)pid);
+   for ( i = 0 ; i < lmin(trace.Nthr, trcMaxThr) ; i++ ) {
+      if ( trace.Thr[i] == NULL ) continue;
+      fprintf(fp,",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %d, "
+                 "\"tid\": %d, \"args\": {\"name\": \"%s\"}}",
+              (int)pid, i+1, trace.Thr[i]);
+   }
+   for ( k = 0 ; k < n ; k++ ) {
+      fprintf(fp,",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": %d, \"tid\": %d, "
+                 "\"ts\": %.3f, \"dur\": %.3f}",
+              trace.Evt[k].Name, (int)pid, trace.Evt[k].Tid,
+              trace.Evt[k].Ts, trace.Evt[k].Dur);
+   }
+   fprintf(fp,"\n]}\n");
+   fclose(fp);
+   if ( trace.Drop > 0 ) {
+      printf("TraceWrite:  %ld events dropped of %ld.\n",trace.Drop,trace.Cnt);
+   }
+   free(trace.Evt);
+   trace.Evt = NULL;
+}
+
+#define TRACE_INIT()          TraceInit()
+#define TRACE_THREAD(name)    TraceThread(name)
+#define TRACE_WRITE()         TraceWrite()
+#define TRACE_BEG(lvl,name)   do { if ( (lvl) <= TRC_LVL ) TraceBeg(name); } while (0)
+#define TRACE_END(lvl)        do { if ( (lvl) <= TRC_LVL ) TraceEnd(); } while (0)
+
+#else
+
+#define TRACE_INIT()
+#define TRACE_THREAD(name)
+#define TRACE_WRITE()
+#define TRACE_BEG(lvl,name)
+#define TRACE_END(lvl)
+
+#endif
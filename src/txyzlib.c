@@ -0,0 +1,1034 @@
+/**********************************************************************/
+/* FILE:  txyzlib.c
+ * DATE:  16 OCT 2026
+ * AUTH:  G. E. Deschaines
+ * DESC:  Data structures and methods to read TXYZ trajectory records
+ *        from either the TXYZ.OUT.#### text files or their binary
+ *        columnar TXYZ.BIN.#### equivalents, and to convert between
+ *        the two file formats.
+ *
+ *        Each TXYZ text record consists of a time line, an attitude
+ *        line and ktot decoy lines (none for padded ktot < 0 records).
+ *
+ *          time line     - tsec ktot XM YM ZM XT YT ZT
+ *          attitude line - -9999 -9999 PHM THM PSM PHT THT PST  (3-DOF)
+ *                          PHM THM PSM PHT THT PST              (6-DOF)
+ *          decoy line    - decoy position and radiance values
+ *
+ *        The binary file, written in native byte order, holds a header
+ *        followed by one array (column) per record field, so a memory
+ *        mapped file can be indexed directly by record number, and a
+ *        decoy side table referenced by a per record decoy index.
+ *
+ *          TxyzHdr header
+ *          Extended  T[n], XM[n], YM[n], ZM[n], XT[n], YT[n], ZT[n],
+ *                    PHM[n], THM[n], PSM[n], PHT[n], THT[n], PST[n]
+ *          int32_t   K[n]    ktot value
+ *          int32_t   L[n]    attitude layout (1=3-DOF marker, 0=6-DOF)
+ *          uint32_t  D[n]    index of first decoy in side table
+ *          (padding to 8 byte boundary)
+ *          TxyzDcy   decoys[ndcy]
+ *
+ *        Converting a text file to binary and back to text writes all
+ *        values with 17 significant digits, so parsed values, the
+ *        attitude layout and decoys round-trip exactly.
+ *
+ *        Since text records vary in length with their number of decoy
+ *        lines, a record index of (tsec, byte offset) pairs is built in
+ *        one pass on first open of a text file and cached next to it as
+ *        ./txyz/TXYZ.IDX.####, along with the text file size and
+ *        modification time to detect a stale cache.  Binary files are
+ *        indexed directly by record number.  Either way, records may be
+ *        sought by number or located by time with a binary search.
+ *
+ *        In follow mode, records are read as they are written to
+ *        standard input, a FIFO or a growing text file.  Input is
+ *        accumulated in a buffer and a record is returned only once its
+ *        time, attitude and ktot decoy lines are all complete, so partial
+ *        records at a read boundary are kept for the next read.  While
+ *        no record is ready, readers block in poll() on the input (and
+ *        the X server connection, so key presses are still handled),
+ *        or for a regular file sleep until the next check for growth.
+ *
+ *        For rendering at a fixed frame rate, frame times are placed
+ *        every 1/rate seconds from the first record read, and each
+ *        frame's record is interpolated between the two records which
+ *        bracket its time:  positions linearly, and missile and target
+ *        attitudes by spherical linear interpolation (slerp) of unit
+ *        quaternions made from their yaw, pitch and roll Euler angles.
+ *        The last record is always rendered, so the final frame shows
+ *        the time of intercept.
+*/
+/**********************************************************************/
+
+#include <stdint.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define TxyzMagic   "TXYZBIN\n"
+#define TxyzIdxMag  "TXYZIDX\n"
+#define TxyzVer     1
+#define TxyzBom     0x01020304
+#define TxyzNcol    13  /* number of Extended columns   */
+#define TxyzMxDcyV   8  /* maximum values per decoy line */
+#define TxyzMxLine 512  /* maximum text line length read */
+#define TxyzFolBuf  65536  /* initial follow mode buffer size (bytes)  */
+#define TxyzFolMs     100  /* follow mode wait for input (msec)         */
+#define TxyzRpd  0.017453292519943295  /* radians per degree */
+
+enum { TxyzT = 0, TxyzXM, TxyzYM, TxyzZM, TxyzXT, TxyzYT, TxyzZT,
+       TxyzPHM, TxyzTHM, TxyzPSM, TxyzPHT, TxyzTHT, TxyzPST };
+
+typedef struct
+{
+  char      Mag[8];  /* TxyzMagic                     */
+  uint32_t  Ver;     /* TxyzVer                       */
+  uint32_t  Bom;     /* TxyzBom in native byte order  */
+  uint32_t  Nrec;    /* number of trajectory records  */
+  uint32_t  Ndcy;    /* number of decoy records       */
+} TxyzHdr;
+
+typedef struct
+{
+  char      Mag[8];  /* TxyzIdxMag                    */
+  uint32_t  Ver;     /* TxyzVer                       */
+  uint32_t  Bom;     /* TxyzBom in native byte order  */
+  uint32_t  Nrec;    /* number of indexed records     */
+  uint32_t  Pad;
+  int64_t   Siz;     /* indexed text file size        */
+  int64_t   Mtm;     /* indexed text file mod time    */
+} TxyzIdxHdr;
+
+typedef struct
+{
+  Extended  T;       /* record time (sec)             */
+  int64_t   Off;     /* record byte offset            */
+} TxyzIdx;
+
+typedef struct
+{
+  Extended  Val[TxyzMxDcyV];  /* decoy position and radiance values */
+  int32_t   Nval;             /* number of values on decoy line     */
+  int32_t   Pad;
+} TxyzDcy;
+
+typedef struct
+{
+  Extended       V[TxyzNcol];  /* T, missile/target position, attitude  */
+  Integer        K;            /* ktot; decoy count, or < 0 if padded   */
+  Integer        L;            /* attitude layout: 1=3-DOF, 0=6-DOF     */
+  const TxyzDcy *Dcy;          /* decoys (binary only, else NULL)       */
+} TxyzRec;
+
+typedef struct
+{
+  FILE           *Fil;         /* text file, or NULL if binary   */
+  unsigned char  *Map;         /* mapped binary file             */
+  size_t          Len;         /* mapped binary file length      */
+  Longint         Nrec;        /* number of records              */
+  Longint         Irec;        /* next record index              */
+  TxyzIdx        *Idx;         /* text file record index         */
+  const Extended *Col[TxyzNcol];
+  const int32_t  *K;
+  const int32_t  *L;
+  const uint32_t *D;
+  const TxyzDcy  *Dcy;
+  Longint         Ndcy;
+  char           *Buf;         /* follow mode input buffer, or NULL  */
+  size_t          Bcap;        /* follow mode buffer capacity        */
+  size_t          Bln;         /* follow mode buffered bytes         */
+  size_t          Bpos;        /* follow mode next unparsed byte     */
+  int             Fd;          /* follow mode input descriptor       */
+  int             Xfd;         /* X connection to wait on, or -1     */
+  Boolean         Reg;         /* follow mode input is regular file  */
+  Boolean         Fin;         /* follow mode input writer closed    */
+} TxyzFile;
+
+typedef struct
+{
+  TxyzRec   R0;    /* records bracketing next frame time     */
+  TxyzRec   R1;
+  Integer   N;     /* 0 until first record read, else 1      */
+  Extended  T0;    /* time of first frame (sec)              */
+  Extended  Dt;    /* frame interval (sec)                   */
+  Longint   Ifrm;  /* number of next frame                   */
+  Extended  Tlst;  /* time of last frame made (sec)          */
+  Boolean   Fin;   /* last record has been made a frame      */
+} TxyzRate;
+
+/*
+ * RETURNS BYTE OFFSETS OF BINARY FILE COLUMNS FOR nrec RECORDS
+*/
+static size_t TxyzColOff( Longint nrec, Integer icol )
+{
+   size_t  off = sizeof(TxyzHdr);
+
+   /* Extended columns, then K, L and D int32 columns. */
+   if ( icol <= TxyzNcol ) {
+      return off + (size_t)icol*nrec*sizeof(Extended);
+   }
+   off = off + (size_t)TxyzNcol*nrec*sizeof(Extended);
+   return off + (size_t)(icol - TxyzNcol)*nrec*sizeof(int32_t);
+}
+
+static size_t TxyzDcyOff( Longint nrec )
+{
+   size_t  off = TxyzColOff(nrec, TxyzNcol+3);
+
+   return ( off + 7 ) & ~(size_t)7;
+}
+
+/*
+ * PARSES TEXT RECORD TIME LINE; RETURNS 1 IF ALL 8 VALUES WERE PARSED
+*/
+static Integer TxyzParsePos( const char *line, TxyzRec *rec )
+{
+   Extended  *v = rec->V;
+   int        k;
+
+   k = sscanf(line,"%lf %hd %lf %lf %lf %lf %lf %lf\n",
+                   &v[TxyzT],&rec->K,&v[TxyzXM],&v[TxyzYM],&v[TxyzZM],
+                   &v[TxyzXT],&v[TxyzYT],&v[TxyzZT]);
+   return ( k == 8 ) ? 1 : 0;
+}
+
+/*
+ * PARSES TEXT RECORD ATTITUDE LINE
+*/
+static void TxyzParseAtt( const char *line, TxyzRec *rec )
+{
+   Extended  *v = rec->V;
+   Integer    ipad;
+
+   if ( strstr(line,"     -9999     -9999") ) {
+   /* PROPNAV1.MCD 3-DOF simulation trajectory output file */
+      rec->L = 1;
+      sscanf(line,"%hd %hd %lf %lf %lf %lf %lf %lf\n",
+                  &ipad,&ipad,&v[TxyzPHM],&v[TxyzTHM],&v[TxyzPSM],
+                  &v[TxyzPHT],&v[TxyzTHT],&v[TxyzPST]);
+   } else {
+   /* Other 6-DOF simulation trajectory output file */
+      rec->L = 0;
+      sscanf(line,"%lf %lf %lf %lf %lf %lf\n",
+                  &v[TxyzPHM],&v[TxyzTHM],&v[TxyzPSM],
+                  &v[TxyzPHT],&v[TxyzTHT],&v[TxyzPST]);
+   }
+}
+
+/*
+ * PARSES TEXT RECORD DECOY LINE
+*/
+static void TxyzParseDcy( const char *line, TxyzDcy *d )
+{
+   int  k;
+
+   memset(d, 0, sizeof(TxyzDcy));
+   k = sscanf(line,"%lf %lf %lf %lf %lf %lf %lf %lf\n",
+                   &d->Val[0],&d->Val[1],&d->Val[2],&d->Val[3],
+                   &d->Val[4],&d->Val[5],&d->Val[6],&d->Val[7]);
+   d->Nval = ( k > 0 ) ? k : 0;
+}
+
+/*
+ * PARSES NEXT TEXT RECORD INTO rec, SAVING DECOY LINES TO dcy (IF NOT
+ * NULL) OR SKIPPING THEM; RETURNS 1 FOR A RECORD, 0 FOR AN UNPARSABLE
+ * LINE
+*/
+static Integer TxyzReadText( FILE *lfnt, TxyzRec *rec,
+                             TxyzDcy **dcy, Longint *ndcy, Longint *mxdcy )
+{
+   Integer    itot;
+   TxyzDcy   *d;
+   Boolean    got;
+
+/* GET MISSILE AND TARGET POSITION */
+   if ( fgets(sbuff,TxyzMxLine,lfnt) == NULL ) return 0;
+   if ( TxyzParsePos(sbuff, rec) != 1 ) return 0;
+
+/* GET MISSILE AND TARGET ORIENTATION */
+   if ( fgets(sbuff,TxyzMxLine,lfnt) == NULL ) sbuff[0] = '\0';
+   TxyzParseAtt(sbuff, rec);
+
+/* GET OR SKIP DECOY POSITION AND RADIANCE */
+   rec->Dcy = NULL;
+   for ( itot = 0 ; itot < rec->K ; itot++ )
+   {
+      got = ( fgets(sbuff,TxyzMxLine,lfnt) != NULL );
+      if ( dcy == NULL ) {
+         if ( got ) continue;
+         else       break;
+      }
+      if ( ! got ) sbuff[0] = '\0';
+      if ( *ndcy == *mxdcy ) {
+         *mxdcy = ( *mxdcy == 0 ) ? 256 : 2*(*mxdcy);
+         d = (TxyzDcy *)realloc(*dcy, (size_t)(*mxdcy)*sizeof(TxyzDcy));
+         if ( d == NULL ) return 0;
+         *dcy = d;
+      }
+      TxyzParseDcy(sbuff, &(*dcy)[(*ndcy)++]);
+   }
+   return 1;
+}
+
+/*
+ * LOADS CACHED ./txyz/TXYZ.IDX.#### RECORD INDEX OF OPENED TEXT FILE IF
+ * CURRENT, OTHERWISE BUILDS IT IN ONE PASS OVER THE FILE AND CACHES IT
+*/
+static void TxyzIndex( TxyzFile *trj, Integer run )
+{
+   char        fpath[32];
+   char        tpath[48];
+   struct stat sbuf;
+   TxyzIdxHdr  hdr;
+   TxyzRec     rec;
+   TxyzIdx    *idx;
+   FILE       *lfni;
+   Longint     mxrec = 0;
+   long        off;
+
+   if ( fstat(fileno(trj->Fil), &sbuf) != 0 ) return;
+
+   sprintf(fpath,"./txyz/TXYZ.IDX.%04hd",run);
+   lfni = fopen(fpath,"rb");
+   if ( lfni != NULL ) {
+      if ( ( fread(&hdr, sizeof(hdr), 1, lfni) == 1 ) &&
+           ( memcmp(hdr.Mag, TxyzIdxMag, 8) == 0 ) &&
+           ( hdr.Ver == TxyzVer ) && ( hdr.Bom == TxyzBom ) &&
+           ( hdr.Siz == (int64_t)sbuf.st_size ) &&
+           ( hdr.Mtm == (int64_t)sbuf.st_mtime ) ) {
+         trj->Idx = (TxyzIdx *)malloc((hdr.Nrec + 1)*sizeof(TxyzIdx));
+         if ( ( trj->Idx != NULL ) &&
+              ( fread(trj->Idx, sizeof(TxyzIdx), hdr.Nrec, lfni) == hdr.Nrec ) ) {
+            trj->Nrec = hdr.Nrec;
+            fclose(lfni);
+#if DBG_LVL > 0
+            printf("TxyzIndex:  Loaded %ld record index %s\n",trj->Nrec,fpath);
+#endif
+            return;
+         }
+         free(trj->Idx);
+         trj->Idx = NULL;
+      }
+      fclose(lfni);
+   }
+
+/* Index byte offset and time of each parsable record. */
+
+   memset(&rec, 0, sizeof(rec));
+   trj->Nrec = 0;
+   while ( ! feof(trj->Fil) ) {
+      off = ftell(trj->Fil);
+      if ( TxyzReadText(trj->Fil, &rec, NULL, NULL, NULL) != 1 ) continue;
+      if ( trj->Nrec == mxrec ) {
+         mxrec = ( mxrec == 0 ) ? 1024 : 2*mxrec;
+         idx   = (TxyzIdx *)realloc(trj->Idx, mxrec*sizeof(TxyzIdx));
+         if ( idx == NULL ) {
+            printf("TxyzIndex:  realloc error for %ld records.\n",mxrec);
+            free(trj->Idx);
+            trj->Idx  = NULL;
+            trj->Nrec = 0;
+            break;
+         }
+         trj->Idx = idx;
+      }
+      trj->Idx[trj->Nrec].T   = rec.V[TxyzT];
+      trj->Idx[trj->Nrec].Off = off;
+      trj->Nrec++;
+   }
+   clearerr(trj->Fil);
+   rewind(trj->Fil);
+   if ( trj->Idx == NULL ) return;
+
+/* Cache index, renamed into place so readers never see a partial file. */
+
+   memset(&hdr, 0, sizeof(hdr));
+   memcpy(hdr.Mag, TxyzIdxMag, 8);
+   hdr.Ver  = TxyzVer;
+   hdr.Bom  = TxyzBom;
+   hdr.Nrec = (uint32_t)trj->Nrec;
+   hdr.Siz  = (int64_t)sbuf.st_size;
+   hdr.Mtm  = (int64_t)sbuf.st_mtime;
+   sprintf(tpath,"%s.%ld",fpath,(long)getpid());
+   lfni = fopen(tpath,"wb");
+   if ( lfni == NULL ) return;
+   fwrite(&hdr, sizeof(hdr), 1, lfni);
+   fwrite(trj->Idx, sizeof(TxyzIdx), trj->Nrec, lfni);
+   if ( ( fclose(lfni) != 0 ) || ( rename(tpath, fpath) != 0 ) ) {
+      remove(tpath);
+   }
+#if DBG_LVL > 0
+   printf("TxyzIndex:  Cached %ld record index %s\n",trj->Nrec,fpath);
+#endif
+}
+
+/*
+ * OPENS TRAJECTORY RUN, PREFERRING BINARY ./txyz/TXYZ.BIN.#### OVER
+ * TEXT ./txyz/TXYZ.OUT.#### FILE UNLESS THE TEXT FILE HAS BEEN MODIFIED
+ * SINCE IT WAS CONVERTED (OR REGARDLESS IF stale IS TRUE)
+*/
+static Boolean TxyzOpenRun( TxyzFile *trj, Integer run, Boolean stale )
+{
+   char           fpath[32];
+   char           tpath[32];
+   struct stat    sbuf;
+   struct stat    tbuf;
+   const TxyzHdr *hdr;
+   Integer        i;
+   int            fd;
+
+   memset(trj, 0, sizeof(TxyzFile));
+
+   sprintf(fpath,"./txyz/TXYZ.BIN.%04hd",run);
+   sprintf(tpath,"./txyz/TXYZ.OUT.%04hd",run);
+   fd = open(fpath, O_RDONLY);
+   if ( ( fd >= 0 ) && ( ! stale ) &&
+        ( fstat(fd, &sbuf) == 0 ) && ( stat(tpath, &tbuf) == 0 ) &&
+        ( tbuf.st_mtime > sbuf.st_mtime ) ) {
+      printf("TxyzOpen:  %s is newer than %s; reading it (rerun -tobin).\n",
+             tpath,fpath);
+      close(fd);
+      fd = -1;
+   }
+   if ( fd >= 0 ) {
+#if DBG_LVL > 0
+      printf("TxyzOpen:  Mapping trajectory file %s\n",fpath);
+#endif
+      if ( ( fstat(fd, &sbuf) == 0 ) && ( sbuf.st_size >= sizeof(TxyzHdr) ) ) {
+         trj->Len = (size_t)sbuf.st_size;
+         trj->Map = (unsigned char *)mmap(NULL, trj->Len, PROT_READ,
+                                          MAP_PRIVATE, fd, 0);
+         if ( trj->Map == (unsigned char *)MAP_FAILED ) trj->Map = NULL;
+      }
+      close(fd);
+      hdr = (const TxyzHdr *)trj->Map;
+      if ( ( hdr == NULL ) ||
+           ( memcmp(hdr->Mag, TxyzMagic, 8) != 0 ) ||
+           ( hdr->Ver != TxyzVer ) || ( hdr->Bom != TxyzBom ) ||
+           ( TxyzDcyOff(hdr->Nrec) + hdr->Ndcy*sizeof(TxyzDcy) > trj->Len ) ) {
+         printf("TxyzOpen:  invalid binary trajectory file %s.\n",fpath);
+         if ( trj->Map != NULL ) munmap(trj->Map, trj->Len);
+         trj->Map = NULL;
+         return FALSE;
+      }
+      trj->Nrec = hdr->Nrec;
+      trj->Ndcy = hdr->Ndcy;
+      for ( i = 0 ; i < TxyzNcol ; i++ ) {
+         trj->Col[i] = (const Extended *)(trj->Map + TxyzColOff(trj->Nrec,i));
+      }
+      trj->K   = (const int32_t *)(trj->Map + TxyzColOff(trj->Nrec,TxyzNcol));
+      trj->L   = (const int32_t *)(trj->Map + TxyzColOff(trj->Nrec,TxyzNcol+1));
+      trj->D   = (const uint32_t *)(trj->Map + TxyzColOff(trj->Nrec,TxyzNcol+2));
+      trj->Dcy = (const TxyzDcy *)(trj->Map + TxyzDcyOff(trj->Nrec));
+      return TRUE;
+   }
+
+   sprintf(fpath,"./txyz/TXYZ.OUT.%04hd",run);
+#if DBG_LVL > 0
+   printf("TxyzOpen:  Opening trajectory file %s\n",fpath);
+#endif
+   trj->Fil = fopen(fpath,"r");
+   if ( trj->Fil == NULL ) {
+      printf("TxyzOpen:  fopen error for trajectory file %s.\n",fpath);
+      return FALSE;
+   }
+   TxyzIndex(trj, run);
+   return TRUE;
+}
+
+/*
+ * OPENS TRAJECTORY RUN, PREFERRING A CURRENT BINARY FILE
+*/
+Boolean TxyzOpen( TxyzFile *trj, Integer run )
+{
+   return TxyzOpenRun(trj, run, FALSE);
+}
+
+/*
+ * RETURNS TRUE WHEN ALL TRAJECTORY RECORDS HAVE BEEN READ
+*/
+Boolean TxyzEof( TxyzFile *trj )
+{
+   if ( trj->Map != NULL ) return ( trj->Irec >= trj->Nrec );
+   if ( trj->Fil != NULL ) return ( feof(trj->Fil) != 0 );
+   if ( trj->Buf != NULL ) return ( trj->Fin && ( trj->Bpos >= trj->Bln ) );
+   return TRUE;
+}
+
+/*
+ * GETS BINARY TRAJECTORY RECORD irec (0 <= irec < Nrec)
+*/
+void TxyzGet( TxyzFile *trj, Longint irec, TxyzRec *rec )
+{
+   Integer  i;
+
+   for ( i = 0 ; i < TxyzNcol ; i++ ) {
+      rec->V[i] = trj->Col[i][irec];
+   }
+   rec->K   = (Integer)trj->K[irec];
+   rec->L   = (Integer)trj->L[irec];
+   rec->Dcy = ( rec->K > 0 ) ? &trj->Dcy[trj->D[irec]] : NULL;
+}
+
+/*
+ * FOLLOWS TRAJECTORY RECORDS WRITTEN TO STANDARD INPUT ("-"), A FIFO OR
+ * A GROWING FILE, ALSO WAKING ON INPUT FROM X CONNECTION xfd (IF >= 0)
+*/
+Boolean TxyzFollow( TxyzFile *trj, const char *path, int xfd )
+{
+   struct stat  sbuf;
+
+   memset(trj, 0, sizeof(TxyzFile));
+   if ( strcmp(path, "-") == 0 ) {
+      trj->Fd = fileno(stdin);
+   } else {
+      /* Opening a FIFO waits here for its writer to connect. */
+      trj->Fd = open(path, O_RDONLY);
+      if ( trj->Fd < 0 ) {
+         printf("TxyzFollow:  open error for trajectory input %s.\n",path);
+         return FALSE;
+      }
+   }
+#if DBG_LVL > 0
+   printf("TxyzFollow:  Following trajectory input %s\n",path);
+#endif
+   trj->Reg  = ( fstat(trj->Fd, &sbuf) == 0 ) && S_ISREG(sbuf.st_mode);
+   trj->Xfd  = xfd;
+   trj->Bcap = TxyzFolBuf;
+   trj->Buf  = (char *)malloc(trj->Bcap);
+   if ( trj->Buf == NULL ) {
+      printf("TxyzFollow:  malloc error for input buffer.\n");
+      if ( trj->Fd != fileno(stdin) ) close(trj->Fd);
+      return FALSE;
+   }
+   return TRUE;
+}
+
+/*
+ * APPENDS AVAILABLE FOLLOWED INPUT TO BUFFER; RETURNS BYTES READ
+*/
+static ssize_t TxyzFill( TxyzFile *trj )
+{
+   char     *buf;
+   ssize_t   n;
+
+   if ( trj->Bpos > 0 ) {
+      memmove(trj->Buf, trj->Buf + trj->Bpos, trj->Bln - trj->Bpos);
+      trj->Bln  = trj->Bln - trj->Bpos;
+      trj->Bpos = 0;
+   }
+   if ( trj->Bln == trj->Bcap ) {
+      buf = (char *)realloc(trj->Buf, 2*trj->Bcap);
+      if ( buf == NULL ) return 0;
+      trj->Buf  = buf;
+      trj->Bcap = 2*trj->Bcap;
+   }
+   n = read(trj->Fd, trj->Buf + trj->Bln, trj->Bcap - trj->Bln);
+   if ( n > 0 ) {
+      trj->Bln += n;
+   } else if ( ( n == 0 ) && ! trj->Reg ) {
+      trj->Fin = TRUE;
+   }
+   return ( n > 0 ) ? n : 0;
+}
+
+/*
+ * WAITS UP TO msec MILLISECONDS FOR MORE FOLLOWED INPUT OR X EVENTS
+*/
+static void TxyzWait( TxyzFile *trj, int msec )
+{
+   struct pollfd  pfd[2];
+   int            n = 0;
+
+   if ( trj->Fin ) return;
+   if ( trj->Reg ) {
+      /* A regular file is always readable, so check it for growth
+         and otherwise sleep until the next check. */
+      if ( TxyzFill(trj) > 0 ) return;
+   } else {
+      pfd[n].fd      = trj->Fd;
+      pfd[n].events  = POLLIN;
+      pfd[n].revents = 0;
+      n++;
+   }
+   if ( trj->Xfd >= 0 ) {
+      pfd[n].fd      = trj->Xfd;
+      pfd[n].events  = POLLIN;
+      pfd[n].revents = 0;
+      n++;
+   }
+   if ( poll(pfd, n, msec) > 0 ) {
+      if ( ! trj->Reg && ( pfd[0].revents & (POLLIN | POLLHUP | POLLERR) ) ) {
+         TxyzFill(trj);
+      }
+   }
+}
+
+/*
+ * COPIES NEXT COMPLETE LINE OF FOLLOWED INPUT AT *pos TO line (AT MOST
+ * TxyzMxLine-1 CHARACTERS) AND ADVANCES *pos; A FINAL UNTERMINATED LINE IS ONLY
+ * COMPLETE ONCE THE WRITER HAS CLOSED THE INPUT
+*/
+static Boolean TxyzLine( TxyzFile *trj, size_t *pos, char *line )
+{
+   char    *eol;
+   size_t   len;
+
+   if ( *pos >= trj->Bln ) return FALSE;
+   eol = (char *)memchr(trj->Buf + *pos, '\n', trj->Bln - *pos);
+   if ( eol == NULL ) {
+      if ( ! trj->Fin ) return FALSE;
+      eol = trj->Buf + trj->Bln;
+   }
+   len = (size_t)(eol - (trj->Buf + *pos));
+   memcpy(line, trj->Buf + *pos, lmin(len, TxyzMxLine-1));
+   line[lmin(len, TxyzMxLine-1)] = '\0';
+   *pos = (size_t)(eol - trj->Buf) + ( ( eol < trj->Buf + trj->Bln ) ? 1 : 0 );
+   return TRUE;
+}
+
+/*
+ * PARSES NEXT COMPLETE RECORD OF FOLLOWED INPUT INTO rec; RETURNS 1 FOR
+ * A RECORD, 0 IF NO COMPLETE RECORD IS BUFFERED YET
+*/
+static Integer TxyzReadFollow( TxyzFile *trj, TxyzRec *rec )
+{
+   TxyzRec   tmp;
+   size_t    pos;
+   char      line[TxyzMxLine];
+   Integer   itot;
+
+   while ( TRUE ) {
+      pos = trj->Bpos;
+      tmp = *rec;
+      if ( ! TxyzLine(trj, &pos, line) ) return 0;
+      if ( TxyzParsePos(line, &tmp) != 1 ) {
+         /* Skip unparsable line, as for text files. */
+         trj->Bpos = pos;
+         continue;
+      }
+      if ( ! TxyzLine(trj, &pos, line) ) break;
+      TxyzParseAtt(line, &tmp);
+      for ( itot = 0 ; itot < tmp.K ; itot++ ) {
+         if ( ! TxyzLine(trj, &pos, line) ) break;
+      }
+      if ( itot < tmp.K ) break;
+      *rec      = tmp;
+      rec->Dcy  = NULL;
+      trj->Bpos = pos;
+      trj->Irec++;
+      return 1;
+   }
+   /* Record incomplete; discard it only if no more input can come. */
+   if ( trj->Fin ) trj->Bpos = trj->Bln;
+   return 0;
+}
+
+/*
+ * READS NEXT TRAJECTORY RECORD; RETURNS 1 FOR A RECORD, 0 IF NONE
+*/
+Integer TxyzRead( TxyzFile *trj, TxyzRec *rec )
+{
+   if ( trj->Map != NULL ) {
+      if ( trj->Irec >= trj->Nrec ) return 0;
+      TxyzGet(trj, trj->Irec++, rec);
+      return 1;
+   }
+   if ( trj->Fil != NULL ) {
+      if ( TxyzReadText(trj->Fil, rec, NULL, NULL, NULL) == 1 ) {
+         trj->Irec++;
+         return 1;
+      }
+   }
+   if ( trj->Buf != NULL ) {
+      if ( TxyzReadFollow(trj, rec) == 1 ) return 1;
+      TxyzWait(trj, TxyzFolMs);
+      return TxyzReadFollow(trj, rec);
+   }
+   return 0;
+}
+
+/*
+ * RETURNS TIME OF RECORD irec
+*/
+Extended TxyzTime( TxyzFile *trj, Longint irec )
+{
+   if ( trj->Map != NULL ) return trj->Col[TxyzT][irec];
+   return trj->Idx[irec].T;
+}
+
+/*
+ * POSITIONS TRAJECTORY SO NEXT RECORD READ IS irec, CLAMPED TO THE
+ * INDEXED RECORDS; RETURNS FALSE IF RECORDS ARE NOT INDEXED
+*/
+Boolean TxyzSeek( TxyzFile *trj, Longint irec )
+{
+   if ( trj->Nrec <= 0 ) return FALSE;
+   if ( trj->Map == NULL && trj->Idx == NULL ) return FALSE;
+   irec = lmax(0, lmin(trj->Nrec-1, irec));
+   if ( trj->Fil != NULL ) {
+      clearerr(trj->Fil);
+      if ( fseek(trj->Fil, (long)trj->Idx[irec].Off, SEEK_SET) != 0 ) {
+         return FALSE;
+      }
+   }
+   trj->Irec = irec;
+   return TRUE;
+}
+
+/*
+ * RETURNS INDEX OF FIRST RECORD AT OR AFTER TIME tsec (LAST RECORD IF
+ * NONE) BY BINARY SEARCH, OR -1 IF RECORDS ARE NOT INDEXED
+*/
+Longint TxyzFind( TxyzFile *trj, Extended tsec )
+{
+   Longint  lo, hi, mid;
+
+   if ( trj->Nrec <= 0 ) return -1;
+   if ( trj->Map == NULL && trj->Idx == NULL ) return -1;
+   lo = 0;
+   hi = trj->Nrec - 1;
+   while ( lo < hi ) {
+      mid = lo + (hi - lo)/2;
+      if ( TxyzTime(trj, mid) < tsec ) lo = mid + 1;
+      else                              hi = mid;
+   }
+   return lo;
+}
+
+/*
+ * MAKES UNIT QUATERNION q (w,x,y,z) FROM ROLL, PITCH AND YAW EULER
+ * ANGLES e (deg) OF A YAW-PITCH-ROLL ROTATION SEQUENCE
+*/
+static void TxyzQuat( const Extended e[3], Extended q[4] )
+{
+   Extended  cr = cos(0.5*TxyzRpd*e[0]), sr = sin(0.5*TxyzRpd*e[0]);
+   Extended  ct = cos(0.5*TxyzRpd*e[1]), st = sin(0.5*TxyzRpd*e[1]);
+   Extended  cp = cos(0.5*TxyzRpd*e[2]), sp = sin(0.5*TxyzRpd*e[2]);
+
+   q[0] = cr*ct*cp + sr*st*sp;
+   q[1] = sr*ct*cp - cr*st*sp;
+   q[2] = cr*st*cp + sr*ct*sp;
+   q[3] = cr*ct*sp - sr*st*cp;
+}
+
+/*
+ * INTERPOLATES ROLL, PITCH AND YAW EULER ANGLES (deg) FRACTION s OF
+ * THE WAY FROM e0 TO e1 ALONG THE SHORTEST ARC BETWEEN ATTITUDES
+*/
+static void TxyzSlerp( const Extended e0[3], const Extended e1[3],
+                       Extended s, Extended e[3] )
+{
+   Extended  q0[4], q1[4], q[4];
+   Extended  dot, th, a, b, n;
+   Integer   i;
+
+   TxyzQuat(e0, q0);
+   TxyzQuat(e1, q1);
+   dot = q0[0]*q1[0] + q0[1]*q1[1] + q0[2]*q1[2] + q0[3]*q1[3];
+   if ( dot < 0.0 ) {
+      for ( i = 0 ; i < 4 ; i++ ) q1[i] = -q1[i];
+      dot = -dot;
+   }
+   if ( dot > 0.9995 ) {
+      // Nearly equal attitudes; linear interpolation is accurate.
+      a = 1.0 - s;
+      b = s;
+   } else {
+      th = acos(dot);
+      a  = sin((1.0 - s)*th)/sin(th);
+      b  = sin(s*th)/sin(th);
+   }
+   for ( i = 0 ; i < 4 ; i++ ) q[i] = a*q0[i] + b*q1[i];
+   n = sqrt(q[0]*q[0] + q[1]*q[1] + q[2]*q[2] + q[3]*q[3]);
+   for ( i = 0 ; i < 4 ; i++ ) q[i] = q[i]/n;
+
+   e[0] = atan2(2.0*(q[0]*q[1] + q[2]*q[3]),
+                1.0 - 2.0*(q[1]*q[1] + q[2]*q[2]))/TxyzRpd;
+   e[1] = asin(dmax(-1.0, dmin(1.0, 2.0*(q[0]*q[2] - q[3]*q[1]))))/TxyzRpd;
+   e[2] = atan2(2.0*(q[0]*q[3] + q[1]*q[2]),
+                1.0 - 2.0*(q[2]*q[2] + q[3]*q[3]))/TxyzRpd;
+}
+
+/*
+ * WRAPS INTERPOLATED ANGLE e (deg) INTO THE RANGE OF THE RECORD ANGLES
+ * e0 AND e1 IT WAS INTERPOLATED BETWEEN: [0,360) IF NEITHER IS
+ * NEGATIVE, ELSE [-180,180)
+*/
+static Extended TxyzWrap( Extended e0, Extended e1, Extended e )
+{
+   Extended  lo = ( ( e0 >= 0.0 ) && ( e1 >= 0.0 ) ) ? 0.0 : -180.0;
+
+   if      ( e <  lo )         e = e + 360.0;
+   else if ( e >= lo + 360.0 ) e = e - 360.0;
+   return e;
+}
+
+/*
+ * INTERPOLATES RECORD AT TIME tsec BETWEEN RECORDS r0 AND r1; THE
+ * INTERPOLATED RECORD IS PADDED IF r1 IS PADDED, ELSE HAS THE DECOYS
+ * OF r0
+*/
+void TxyzLerp( const TxyzRec *r0, const TxyzRec *r1, Extended tsec,
+               TxyzRec *rec )
+{
+   Extended  dt = r1->V[TxyzT] - r0->V[TxyzT];
+   Extended  s;
+   Integer   i;
+
+   s = ( dt > 0.0 ) ? dmax(0.0, dmin(1.0, (tsec - r0->V[TxyzT])/dt)) : 1.0;
+   if ( s == 0.0 ) {
+      *rec = *r0;
+      return;
+   }
+   if ( s == 1.0 ) {
+      *rec = *r1;
+      rec->V[TxyzT] = tsec;
+      return;
+   }
+   *rec = *r0;
+   if ( r1->K < 0 ) rec->K = r1->K;
+   rec->V[TxyzT] = tsec;
+   for ( i = TxyzXM ; i <= TxyzZT ; i++ ) {
+      rec->V[i] = r0->V[i] + s*(r1->V[i] - r0->V[i]);
+   }
+   TxyzSlerp(&r0->V[TxyzPHM], &r1->V[TxyzPHM], s, &rec->V[TxyzPHM]);
+   TxyzSlerp(&r0->V[TxyzPHT], &r1->V[TxyzPHT], s, &rec->V[TxyzPHT]);
+
+   /* Roll and yaw come back from the quaternion in (-180,180]; show
+      them in the same range as the records. */
+   rec->V[TxyzPHM] = TxyzWrap(r0->V[TxyzPHM], r1->V[TxyzPHM], rec->V[TxyzPHM]);
+   rec->V[TxyzPSM] = TxyzWrap(r0->V[TxyzPSM], r1->V[TxyzPSM], rec->V[TxyzPSM]);
+   rec->V[TxyzPHT] = TxyzWrap(r0->V[TxyzPHT], r1->V[TxyzPHT], rec->V[TxyzPHT]);
+   rec->V[TxyzPST] = TxyzWrap(r0->V[TxyzPST], r1->V[TxyzPST], rec->V[TxyzPST]);
+}
+
+/*
+ * STARTS FIXED RATE FRAMES OF GIVEN RATE (1/sec) AT NEXT RECORD READ
+*/
+void TxyzRateStart( TxyzRate *rt, Extended rate )
+{
+   memset(rt, 0, sizeof(TxyzRate));
+   rt->Dt = 1.0/rate;
+}
+
+/*
+ * READS RECORD OF NEXT FIXED RATE FRAME, INTERPOLATED BETWEEN THE
+ * TRAJECTORY RECORDS BRACKETING ITS TIME; RETURNS 1 FOR A RECORD, 0
+ * IF NONE
+*/
+Integer TxyzReadRate( TxyzFile *trj, TxyzRate *rt, TxyzRec *rec )
+{
+   TxyzRec   nxt;
+   Extended  tf;
+
+   if ( rt->N == 0 ) {
+      if ( TxyzRead(trj, &rt->R1) != 1 ) return 0;
+      rt->R0   = rt->R1;
+      rt->N    = 1;
+      rt->T0   = rt->R1.V[TxyzT];
+      rt->Ifrm = 0;
+      rt->Tlst = rt->T0 - rt->Dt;
+      rt->Fin  = FALSE;
+   }
+   tf = rt->T0 + rt->Ifrm*rt->Dt;
+   while ( rt->R1.V[TxyzT] < tf ) {
+      if ( TxyzRead(trj, &nxt) != 1 ) {
+         if ( rt->Fin || ! TxyzEof(trj) ) return 0;
+         // Last record time falls between frame times; end on it
+         // unless already made a frame.
+         rt->Fin = TRUE;
+         if ( rt->Tlst >= rt->R1.V[TxyzT] ) return 0;
+         *rec = rt->R1;
+         rt->Tlst = rt->R1.V[TxyzT];
+         return 1;
+      }
+      rt->R0 = rt->R1;
+      rt->R1 = nxt;
+   }
+   TxyzLerp(&rt->R0, &rt->R1, tf, rec);
+   rt->Ifrm = rt->Ifrm + 1;
+   rt->Tlst = tf;
+   return 1;
+}
+
+/*
+ * RETURNS TRUE WHEN ALL FIXED RATE FRAMES HAVE BEEN READ
+*/
+Boolean TxyzRateEof( TxyzFile *trj, TxyzRate *rt )
+{
+   return TxyzEof(trj) && ( ( rt->N == 0 ) || rt->Fin );
+}
+
+/*
+ * CLOSES TRAJECTORY RUN
+*/
+void TxyzClose( TxyzFile *trj )
+{
+   if ( trj->Map != NULL ) munmap(trj->Map, trj->Len);
+   if ( trj->Fil != NULL ) fclose(trj->Fil);
+   if ( trj->Buf != NULL ) {
+      if ( trj->Fd != fileno(stdin) ) close(trj->Fd);
+      free(trj->Buf);
+   }
+   free(trj->Idx);
+   memset(trj, 0, sizeof(TxyzFile));
+}
+
+/*
+ * CONVERTS TEXT ./txyz/TXYZ.OUT.#### TO BINARY ./txyz/TXYZ.BIN.####
+*/
+Boolean TxyzToBin( Integer run )
+{
+   char       fpath[32];
+   FILE      *lfnt;
+   FILE      *lfno;
+   TxyzHdr    hdr;
+   TxyzRec    rec;
+   Extended  *col[TxyzNcol];
+   int32_t   *K = NULL, *L = NULL;
+   uint32_t  *D = NULL;
+   TxyzDcy   *dcy = NULL;
+   Longint    ndcy = 0, mxdcy = 0;
+   Longint    nrec = 0, mxrec = 0;
+   Longint    pad;
+   Boolean    okay = TRUE;
+   Integer    i;
+
+   sprintf(fpath,"./txyz/TXYZ.OUT.%04hd",run);
+   lfnt = fopen(fpath,"r");
+   if ( lfnt == NULL ) {
+      printf("TxyzToBin:  fopen error for trajectory file %s.\n",fpath);
+      return FALSE;
+   }
+   memset(col, 0, sizeof(col));
+   memset(&rec, 0, sizeof(rec));
+
+   while ( okay && ! feof(lfnt) ) {
+      if ( nrec == mxrec ) {
+         mxrec = ( mxrec == 0 ) ? 1024 : 2*mxrec;
+         for ( i = 0 ; i < TxyzNcol ; i++ ) {
+            col[i] = (Extended *)realloc(col[i], mxrec*sizeof(Extended));
+            okay = okay && ( col[i] != NULL );
+         }
+         K = (int32_t *)realloc(K, mxrec*sizeof(int32_t));
+         L = (int32_t *)realloc(L, mxrec*sizeof(int32_t));
+         D = (uint32_t *)realloc(D, mxrec*sizeof(uint32_t));
+         okay = okay && ( K != NULL ) && ( L != NULL ) && ( D != NULL );
+         if ( ! okay ) {
+            printf("TxyzToBin:  realloc error for %ld records.\n",mxrec);
+            break;
+         }
+      }
+      D[nrec] = (uint32_t)ndcy;
+      if ( TxyzReadText(lfnt, &rec, &dcy, &ndcy, &mxdcy) == 1 ) {
+         for ( i = 0 ; i < TxyzNcol ; i++ ) {
+            col[i][nrec] = rec.V[i];
+         }
+         K[nrec] = rec.K;
+         L[nrec] = rec.L;
+         nrec++;
+      }
+   }
+   fclose(lfnt);
+
+   sprintf(fpath,"./txyz/TXYZ.BIN.%04hd",run);
+   lfno = okay ? fopen(fpath,"wb") : NULL;
+   if ( okay && ( lfno == NULL ) ) {
+      printf("TxyzToBin:  fopen error for binary file %s.\n",fpath);
+      okay = FALSE;
+   }
+   if ( okay ) {
+      memset(&hdr, 0, sizeof(hdr));
+      memcpy(hdr.Mag, TxyzMagic, 8);
+      hdr.Ver  = TxyzVer;
+      hdr.Bom  = TxyzBom;
+      hdr.Nrec = (uint32_t)nrec;
+      hdr.Ndcy = (uint32_t)ndcy;
+      fwrite(&hdr, sizeof(hdr), 1, lfno);
+      for ( i = 0 ; i < TxyzNcol ; i++ ) {
+         fwrite(col[i], sizeof(Extended), nrec, lfno);
+      }
+      fwrite(K, sizeof(int32_t), nrec, lfno);
+      fwrite(L, sizeof(int32_t), nrec, lfno);
+      fwrite(D, sizeof(uint32_t), nrec, lfno);
+      for ( pad = TxyzDcyOff(nrec) - TxyzColOff(nrec,TxyzNcol+3) ; pad > 0 ; pad-- ) {
+         fputc(0, lfno);
+      }
+      fwrite(dcy, sizeof(TxyzDcy), ndcy, lfno);
+      okay = ( fclose(lfno) == 0 );
+      printf("TxyzToBin:  wrote %ld records, %ld decoys to %s\n",nrec,ndcy,fpath);
+   }
+
+   for ( i = 0 ; i < TxyzNcol ; i++ ) free(col[i]);
+   free(K);
+   free(L);
+   free(D);
+   free(dcy);
+   return okay;
+}
+
+/*
+ * WRITES sep AND x TO lfno IN THE FEWEST DIGITS (15 TO 17) READ BACK AS x
+*/
+static void TxyzPut( FILE *lfno, const char *sep, Extended x )
+{
+   char  s[32];
+   int   p;
+
+   for ( p = 15 ; p < 17 ; p++ ) {
+      sprintf(s,"%.*g",p,x);
+      if ( strtod(s,NULL) == x ) break;
+   }
+   if ( p == 17 ) sprintf(s,"%.17g",x);
+   fprintf(lfno,"%s%s",sep,s);
+}
+
+/*
+ * CONVERTS BINARY ./txyz/TXYZ.BIN.#### TO TEXT ./txyz/TXYZ.TXT.####
+*/
+Boolean TxyzToTxt( Integer run )
+{
+   char      fpath[32];
+   FILE     *lfno;
+   TxyzFile  trj;
+   TxyzRec   rec;
+   Extended *v = rec.V;
+   Integer   i, j;
+
+   if ( ! TxyzOpenRun(&trj, run, TRUE) ) return FALSE;
+   if ( trj.Map == NULL ) {
+      printf("TxyzToTxt:  no binary trajectory file for run %04hd.\n",run);
+      TxyzClose(&trj);
+      return FALSE;
+   }
+   sprintf(fpath,"./txyz/TXYZ.TXT.%04hd",run);
+   lfno = fopen(fpath,"w");
+   if ( lfno == NULL ) {
+      printf("TxyzToTxt:  fopen error for text file %s.\n",fpath);
+      TxyzClose(&trj);
+      return FALSE;
+   }
+   while ( TxyzRead(&trj, &rec) == 1 ) {
+      TxyzPut(lfno,"",v[TxyzT]);
+      fprintf(lfno," %hd",rec.K);
+      for ( j = TxyzXM ; j <= TxyzZT ; j++ ) TxyzPut(lfno," ",v[j]);
+      fprintf(lfno,"\n");
+      if ( rec.L == 1 ) {
+         fprintf(lfno,"     -9999     -9999");
+      }
+      for ( j = TxyzPHM ; j <= TxyzPST ; j++ ) TxyzPut(lfno," ",v[j]);
+      fprintf(lfno,"\n");
+      for ( i = 0 ; i < rec.K ; i++ ) {
+         for ( j = 0 ; j < rec.Dcy[i].Nval ; j++ ) {
+            TxyzPut(lfno,(j > 0) ? " " : "",rec.Dcy[i].Val[j]);
+         }
+         fprintf(lfno,"\n");
+      }
+   }
+   TxyzClose(&trj);
+   fclose(lfno);
+   printf("TxyzToTxt:  wrote %s\n",fpath);
+   return TRUE;
+}
@@ -0,0 +1,305 @@
+/**********************************************************************/
+/* FILE:  xfrmlib.c
+ * DATE:  16 OCT 2026
+ * AUTH:  G. E. Deschaines
+ * DESC:  Batch coordinate transformation kernels for arrays of points
+ *        stored as separate X, Y and Z coordinate arrays.
+ *
+ *        XfrmMove rotates points by a direction cosine matrix and then
+ *        translates them, as when moving object polygon vertice,
+ *        centroids and normals from model to world space.
+ *
+ *        XfrmView translates points relative to a view point, rotates
+ *        them into the view reference frame and then scales each axis,
+ *        as when transforming world space polygons into the viewport.
+ *
+ *        Each kernel has a scalar, an SSE2 and an AVX2 implementation.
+ *        The implementation used is chosen at run time by XfrmInit from
+ *        those the processor supports.  All three perform the same
+ *        double precision multiplies and adds in the same order, so
+ *        the results are bit-identical whichever is used, provided the
+ *        compiler is not allowed to contract them into fused multiply
+ *        adds (-ffp-contract=off).
+*/
+/**********************************************************************/
+
+#define XfrmAuto   -1  /* choose best supported implementation */
+#define XfrmScalar  0  /* scalar implementation                */
+#define XfrmSSE2    1  /* SSE2 two double lane implementation  */
+#define XfrmAVX2    2  /* AVX2 four double lane implementation */
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define XFRM_SIMD  1
+#include <immintrin.h>
+#endif
+
+/*
+ * Kernel argument m is a 3x3 matrix stored by rows, so output
+ * coordinate k of a point is m[3k]*x + m[3k+1]*y + m[3k+2]*z.
+*/
+typedef void (*XfrmMoveFn)( Longint n,
+                            const Extended *xi, const Extended *yi,
+                            const Extended *zi,
+                            Extended *xo, Extended *yo, Extended *zo,
+                            const Extended *m, const Extended *t );
+
+typedef void (*XfrmViewFn)( Longint n,
+                            const Extended *xi, const Extended *yi,
+                            const Extended *zi,
+                            Extended *xo, Extended *yo, Extended *zo,
+                            const Extended *m, const Extended *f,
+                            const Extended *s );
+
+/*
+ * Scalar transformation of point i, shared by the scalar kernels and
+ * the leading and trailing points of the SIMD kernels so all compute
+ * identical results.
+*/
+#define XfrmMove1(i) \
+   { u     = xi[i]; \
+     v     = yi[i]; \
+     w     = zi[i]; \
+     xo[i] = m[0]*u + m[1]*v + m[2]*w + t[0]; \
+     yo[i] = m[3]*u + m[4]*v + m[5]*w + t[1]; \
+     zo[i] = m[6]*u + m[7]*v + m[8]*w + t[2]; }
+
+#define XfrmView1(i) \
+   { u     = xi[i] - f[0]; \
+     v     = yi[i] - f[1]; \
+     w     = zi[i] - f[2]; \
+     xo[i] = (m[0]*u + m[1]*v + m[2]*w)*s[0]; \
+     yo[i] = (m[3]*u + m[4]*v + m[5]*w)*s[1]; \
+     zo[i] = (m[6]*u + m[7]*v + m[8]*w)*s[2]; }
+
+/*
+ * ROTATES n POINTS BY MATRIX m AND TRANSLATES THEM BY t (SCALAR)
+*/
+static void XfrmMoveC( Longint n,
+                       const Extended *xi, const Extended *yi,
+                       const Extended *zi,
+                       Extended *xo, Extended *yo, Extended *zo,
+                       const Extended *m, const Extended *t )
+{
+   Extended  u, v, w;
+   Longint   i;
+
+   for ( i = 0 ; i < n ; i++ ) XfrmMove1(i);
+}
+
+/*
+ * TRANSLATES n POINTS BY -f, ROTATES THEM BY MATRIX m AND SCALES
+ * THEM BY s (SCALAR)
+*/
+static void XfrmViewC( Longint n,
+                       const Extended *xi, const Extended *yi,
+                       const Extended *zi,
+                       Extended *xo, Extended *yo, Extended *zo,
+                       const Extended *m, const Extended *f,
+                       const Extended *s )
+{
+   Extended  u, v, w;
+   Longint   i;
+
+   for ( i = 0 ; i < n ; i++ ) XfrmView1(i);
+}
+
+#ifdef XFRM_SIMD
+
+/*
+ * ROTATES n POINTS BY MATRIX m AND TRANSLATES THEM BY t (SSE2)
+*/
+static void XfrmMoveSSE2( Longint n,
+                          const Extended *xi, const Extended *yi,
+                          const Extended *zi,
+                          Extended *xo, Extended *yo, Extended *zo,
+                          const Extended *m, const Extended *t )
+{
+   __m128d  m0 = _mm_set1_pd(m[0]), m1 = _mm_set1_pd(m[1]), m2 = _mm_set1_pd(m[2]);
+   __m128d  m3 = _mm_set1_pd(m[3]), m4 = _mm_set1_pd(m[4]), m5 = _mm_set1_pd(m[5]);
+   __m128d  m6 = _mm_set1_pd(m[6]), m7 = _mm_set1_pd(m[7]), m8 = _mm_set1_pd(m[8]);
+   __m128d  t0 = _mm_set1_pd(t[0]), t1 = _mm_set1_pd(t[1]), t2 = _mm_set1_pd(t[2]);
+   __m128d  x, y, z;
+   Extended u, v, w;
+   Longint  i;
+
+   for ( i = 0 ; i+2 <= n ; i += 2 ) {
+      x = _mm_loadu_pd(xi+i);
+      y = _mm_loadu_pd(yi+i);
+      z = _mm_loadu_pd(zi+i);
+      _mm_storeu_pd(xo+i, _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(m0,x),
+                          _mm_mul_pd(m1,y)), _mm_mul_pd(m2,z)), t0));
+      _mm_storeu_pd(yo+i, _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(m3,x),
+                          _mm_mul_pd(m4,y)), _mm_mul_pd(m5,z)), t1));
+      _mm_storeu_pd(zo+i, _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(m6,x),
+                          _mm_mul_pd(m7,y)), _mm_mul_pd(m8,z)), t2));
+   }
+   for ( ; i < n ; i++ ) XfrmMove1(i);
+}
+
+/*
+ * TRANSLATES n POINTS BY -f, ROTATES THEM BY MATRIX m AND SCALES
+ * THEM BY s (SSE2)
+*/
+static void XfrmViewSSE2( Longint n,
+                          const Extended *xi, const Extended *yi,
+                          const Extended *zi,
+                          Extended *xo, Extended *yo, Extended *zo,
+                          const Extended *m, const Extended *f,
+                          const Extended *s )
+{
+   __m128d  m0 = _mm_set1_pd(m[0]), m1 = _mm_set1_pd(m[1]), m2 = _mm_set1_pd(m[2]);
+   __m128d  m3 = _mm_set1_pd(m[3]), m4 = _mm_set1_pd(m[4]), m5 = _mm_set1_pd(m[5]);
+   __m128d  m6 = _mm_set1_pd(m[6]), m7 = _mm_set1_pd(m[7]), m8 = _mm_set1_pd(m[8]);
+   __m128d  f0 = _mm_set1_pd(f[0]), f1 = _mm_set1_pd(f[1]), f2 = _mm_set1_pd(f[2]);
+   __m128d  s0 = _mm_set1_pd(s[0]), s1 = _mm_set1_pd(s[1]), s2 = _mm_set1_pd(s[2]);
+   __m128d  x, y, z;
+   Extended u, v, w;
+   Longint  i;
+
+   for ( i = 0 ; i+2 <= n ; i += 2 ) {
+      x = _mm_sub_pd(_mm_loadu_pd(xi+i), f0);
+      y = _mm_sub_pd(_mm_loadu_pd(yi+i), f1);
+      z = _mm_sub_pd(_mm_loadu_pd(zi+i), f2);
+      _mm_storeu_pd(xo+i, _mm_mul_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(m0,x),
+                          _mm_mul_pd(m1,y)), _mm_mul_pd(m2,z)), s0));
+      _mm_storeu_pd(yo+i, _mm_mul_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(m3,x),
+                          _mm_mul_pd(m4,y)), _mm_mul_pd(m5,z)), s1));
+      _mm_storeu_pd(zo+i, _mm_mul_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(m6,x),
+                          _mm_mul_pd(m7,y)), _mm_mul_pd(m8,z)), s2));
+   }
+   for ( ; i < n ; i++ ) XfrmView1(i);
+}
+
+/*
+ * ROTATES n POINTS BY MATRIX m AND TRANSLATES THEM BY t (AVX2)
+*/
+__attribute__((target("avx2")))
+static void XfrmMoveAVX2( Longint n,
+                          const Extended *xi, const Extended *yi,
+                          const Extended *zi,
+                          Extended *xo, Extended *yo, Extended *zo,
+                          const Extended *m, const Extended *t )
+{
+   __m256d  m0 = _mm256_set1_pd(m[0]), m1 = _mm256_set1_pd(m[1]), m2 = _mm256_set1_pd(m[2]);
+   __m256d  m3 = _mm256_set1_pd(m[3]), m4 = _mm256_set1_pd(m[4]), m5 = _mm256_set1_pd(m[5]);
+   __m256d  m6 = _mm256_set1_pd(m[6]), m7 = _mm256_set1_pd(m[7]), m8 = _mm256_set1_pd(m[8]);
+   __m256d  t0 = _mm256_set1_pd(t[0]), t1 = _mm256_set1_pd(t[1]), t2 = _mm256_set1_pd(t[2]);
+   __m256d  x, y, z;
+   Extended u, v, w;
+   Longint  i;
+
+   /* Peel leading points up to a 32 byte aligned output address. */
+   for ( i = 0 ; ( i < n ) && ( ( (size_t)(xo+i) & 31 ) != 0 ) ; i++ ) {
+      XfrmMove1(i);
+   }
+
+   for ( ; i+4 <= n ; i += 4 ) {
+      x = _mm256_loadu_pd(xi+i);
+      y = _mm256_loadu_pd(yi+i);
+      z = _mm256_loadu_pd(zi+i);
+      _mm256_storeu_pd(xo+i, _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(
+                             _mm256_mul_pd(m0,x), _mm256_mul_pd(m1,y)),
+                             _mm256_mul_pd(m2,z)), t0));
+      _mm256_storeu_pd(yo+i, _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(
+                             _mm256_mul_pd(m3,x), _mm256_mul_pd(m4,y)),
+                             _mm256_mul_pd(m5,z)), t1));
+      _mm256_storeu_pd(zo+i, _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(
+                             _mm256_mul_pd(m6,x), _mm256_mul_pd(m7,y)),
+                             _mm256_mul_pd(m8,z)), t2));
+   }
+   for ( ; i < n ; i++ ) XfrmMove1(i);
+}
+
+/*
+ * TRANSLATES n POINTS BY -f, ROTATES THEM BY MATRIX m AND SCALES
+ * THEM BY s (AVX2)
+*/
+__attribute__((target("avx2")))
+static void XfrmViewAVX2( Longint n,
+                          const Extended *xi, const Extended *yi,
+                          const Extended *zi,
+                          Extended *xo, Extended *yo, Extended *zo,
+                          const Extended *m, const Extended *f,
+                          const Extended *s )
+{
+   __m256d  m0 = _mm256_set1_pd(m[0]), m1 = _mm256_set1_pd(m[1]), m2 = _mm256_set1_pd(m[2]);
+   __m256d  m3 = _mm256_set1_pd(m[3]), m4 = _mm256_set1_pd(m[4]), m5 = _mm256_set1_pd(m[5]);
+   __m256d  m6 = _mm256_set1_pd(m[6]), m7 = _mm256_set1_pd(m[7]), m8 = _mm256_set1_pd(m[8]);
+   __m256d  f0 = _mm256_set1_pd(f[0]), f1 = _mm256_set1_pd(f[1]), f2 = _mm256_set1_pd(f[2]);
+   __m256d  s0 = _mm256_set1_pd(s[0]), s1 = _mm256_set1_pd(s[1]), s2 = _mm256_set1_pd(s[2]);
+   __m256d  x, y, z;
+   Extended u, v, w;
+   Longint  i;
+
+   /* Peel leading points up to a 32 byte aligned output address. */
+   for ( i = 0 ; ( i < n ) && ( ( (size_t)(xo+i) & 31 ) != 0 ) ; i++ ) {
+      XfrmView1(i);
+   }
+
+   for ( ; i+4 <= n ; i += 4 ) {
+      x = _mm256_sub_pd(_mm256_loadu_pd(xi+i), f0);
+      y = _mm256_sub_pd(_mm256_loadu_pd(yi+i), f1);
+      z = _mm256_sub_pd(_mm256_loadu_pd(zi+i), f2);
+      _mm256_storeu_pd(xo+i, _mm256_mul_pd(_mm256_add_pd(_mm256_add_pd(
+                             _mm256_mul_pd(m0,x), _mm256_mul_pd(m1,y)),
+                             _mm256_mul_pd(m2,z)), s0));
+      _mm256_storeu_pd(yo+i, _mm256_mul_pd(_mm256_add_pd(_mm256_add_pd(
+                             _mm256_mul_pd(m3,x), _mm256_mul_pd(m4,y)),
+                             _mm256_mul_pd(m5,z)), s1));
+      _mm256_storeu_pd(zo+i, _mm256_mul_pd(_mm256_add_pd(_mm256_add_pd(
+                             _mm256_mul_pd(m6,x), _mm256_mul_pd(m7,y)),
+                             _mm256_mul_pd(m8,z)), s2));
+   }
+   for ( ; i < n ; i++ ) XfrmView1(i);
+}
+
+#endif
+
+XfrmMoveFn  XfrmMove = XfrmMoveC;   /* selected move kernel */
+XfrmViewFn  XfrmView = XfrmViewC;   /* selected view kernel */
+
+/*
+ * SELECTS TRANSFORMATION KERNEL IMPLEMENTATION (XfrmAuto FOR BEST
+ * SUPPORTED) AND RETURNS IMPLEMENTATION SELECTED
+*/
+Integer XfrmInit( Integer isa )
+{
+#ifdef XFRM_SIMD
+   __builtin_cpu_init();
+   if ( isa == XfrmAuto ) {
+      isa = __builtin_cpu_supports("avx2") ? XfrmAVX2 : XfrmSSE2;
+   }
+   if ( ( isa == XfrmAVX2 ) && ( ! __builtin_cpu_supports("avx2") ) ) {
+      printf("XfrmInit:  AVX2 not supported by processor, using SSE2.\n");
+      isa = XfrmSSE2;
+   }
+#else
+   if ( ( isa != XfrmAuto ) && ( isa != XfrmScalar ) ) {
+      printf("XfrmInit:  SIMD kernels not built, using scalar.\n");
+   }
+   isa = XfrmScalar;
+#endif
+
+   switch ( isa ) {
+#ifdef XFRM_SIMD
+      case XfrmAVX2 :
+         XfrmMove = XfrmMoveAVX2;
+         XfrmView = XfrmViewAVX2;
+         break;
+      case XfrmSSE2 :
+         XfrmMove = XfrmMoveSSE2;
+         XfrmView = XfrmViewSSE2;
+         break;
+#endif
+      default :
+         isa      = XfrmScalar;
+         XfrmMove = XfrmMoveC;
+         XfrmView = XfrmViewC;
+         break;
+   }
+#if DBG_LVL > 0
+   printf("XfrmInit:  using %s transformation kernels.\n",
+          (isa == XfrmAVX2) ? "AVX2" : (isa == XfrmSSE2) ? "SSE2" : "scalar");
+#endif
+   return isa;
+}